@@ -1,9 +1,14 @@
 #pragma once
+#include <functional>
+#include <string>
 #include <variant>
+#include <vector>
 
 #include "core/njMesh.h"
 #include "ecs/EngineTypes.h"
+#include "ecs/njComponentSplit.h"
 #include "math/njMat4.h"
+#include "physics/Queries.h"
 
 namespace njin::ecs {
 
@@ -52,6 +57,8 @@ namespace njin::ecs {
     struct njMeshComponent {
         std::string mesh;     // name of mesh
         std::string texture;  // name of texture
+
+        bool operator==(const njMeshComponent&) const = default;
     };
 
     /**
@@ -137,6 +144,8 @@ namespace njin::ecs {
 
     /**
      * Dynamics state
+     * @note Stored split, @see njComponentSplit<nj3DPhysicsComponent>.
+     * Query nj3DRigidBodyComponent and nj3DColliderComponent instead.
      */
     struct nj3DPhysicsComponent {
         math::njVec3f velocity{};  // do not edit manually
@@ -145,6 +154,60 @@ namespace njin::ecs {
         nj3DCollider collider{};          // original aabb representation
         nj3DCollider current_collider{};  // current aabb
         RigidBodyType type{ RigidBodyType::Static };
+        float restitution{ 0.f };  // share of closing speed kept on impact
+        float friction{ 0.5f };    // coefficient of friction
+        // speed below which the body counts as resting, and may sleep
+        float sleep_velocity{ 0.05f };
+        // swept against static bodies every tick, so that it cannot pass
+        // through them however fast it moves
+        bool is_bullet{ false };
+    };
+
+    /**
+     * Hot part of nj3DPhysicsComponent, read and written every tick by
+     * integration
+     */
+    struct nj3DRigidBodyComponent {
+        math::njVec3f velocity{};  // do not edit manually
+        math::njVec3f force{};     // do not edit manually
+        float mass{ 0 };
+        RigidBodyType type{ RigidBodyType::Static };
+    };
+
+    /**
+     * Cold part of nj3DPhysicsComponent: the shape and material of a body,
+     * needed to build bounding boxes and resolve contacts, but never by
+     * integration
+     */
+    struct nj3DColliderComponent {
+        nj3DCollider collider{};          // original aabb representation
+        nj3DCollider current_collider{};  // current aabb
+        float restitution{ 0.f };
+        float friction{ 0.5f };
+        float sleep_velocity{ 0.05f };
+        bool is_bullet{ false };
+    };
+
+    template<>
+    struct njComponentSplit<nj3DPhysicsComponent> {
+        using hot_type = nj3DRigidBodyComponent;
+        using cold_type = nj3DColliderComponent;
+
+        static hot_type hot(const nj3DPhysicsComponent& component) {
+            return { .velocity = component.velocity,
+                     .force = component.force,
+                     .mass = component.mass,
+                     .type = component.type };
+        }
+
+        static cold_type cold(const nj3DPhysicsComponent& component) {
+            return { .collider = component.collider,
+                     .current_collider = component.current_collider,
+                     .restitution = component.restitution,
+                     .friction = component.friction,
+                     .sleep_velocity = component.sleep_velocity,
+                     .is_bullet = component.is_bullet };
+        }
     };
 
     /**
@@ -159,8 +222,24 @@ namespace njin::ecs {
     };
 
     /**
-     * Specifies shape cast requests (for hitboxes?)
-     * // TODO
+     * Ray casts, shape casts and overlap tests an entity wants answered,
+     * e.g. for line of sight or hitboxes. The physics system answers the
+     * queries every tick once bodies have moved, and writes the results in
+     * the same order.
+     * @note Queries are in world space. Set ignored to the entity itself
+     * to keep it from hitting its own collider.
      */
-    struct njCollidersComponent {};
+    struct njCollidersComponent {
+        std::vector<physics::Query> queries{};
+        std::vector<physics::QueryResult> results{};  // do not edit manually
+    };
 }  // namespace njin::ecs
+
+// shared meshes are grouped by value
+template<>
+struct std::hash<njin::ecs::njMeshComponent> {
+    std::size_t operator()(const njin::ecs::njMeshComponent& mesh) const {
+        std::hash<std::string> string_hasher{};
+        return string_hasher(mesh.mesh) ^ (string_hasher(mesh.texture) << 1);
+    }
+};
@@ -1,12 +1,15 @@
 #pragma once
 #include <chrono>
+#include <memory>
 #include <vector>
 
 #include <complex.h>
 
 #include "math/njMat4.h"
 #include "njSystem.h"
+#include "physics/Broadphase.h"
 #include "physics/PhysicsTypes.h"
+#include "physics/ThreadPool.h"
 
 namespace njin::ecs {
     /**
@@ -23,17 +26,40 @@ namespace njin::ecs {
     * to find the position of the entity at t_(i+1) and store it
     *
     * In step 3, verlet integration is used to find the tentative position of
-    * an entity at t_(i+1). Then, a binary BVH is constructed to resolve
-    * penetrations based on this tentative position.
-    * The BVH is then updated, then collision queries are answered.
+    * an entity at t_(i+1). Then, a broadphase that persists across ticks
+    * is updated to find the overlaps at this tentative position.
+    * The broadphase is then updated, then collision queries are answered.
     *
     */
     class nj2DPhysicsSystem : public njSystem {
         public:
-        nj2DPhysicsSystem();
+        /**
+         * Constructor
+         * @param broadphase Type of broadphase to find overlaps with
+         * @param pool Threads to build the broadphase on, shared with
+         * other systems and worlds. Without one, all work runs on the
+         * updating thread.
+         */
+        explicit nj2DPhysicsSystem(physics::BroadphaseType broadphase =
+                                   physics::BroadphaseType::SpatialHash,
+                                   std::shared_ptr<physics::ThreadPool> pool =
+                                   nullptr);
 
         void update(const ecs::njEntityManager& entity_manager) override;
 
+        /**
+         * Switch to another type of broadphase. The new broadphase is
+         * filled on the next tick.
+         * @param broadphase Type of broadphase to find overlaps with
+         */
+        void set_broadphase(physics::BroadphaseType broadphase);
+
+        /**
+         * @return Pairs of entities whose colliders overlap at their
+         * tentative positions, as of the last tick
+         */
+        const physics::OverlappingPairs& get_overlapping_pairs() const;
+
         private:
         /**
          * Check if the time since the last update has passed the predefined
@@ -66,5 +92,13 @@ namespace njin::ecs {
         TimePoint previous_{ Clock::now() };
 
         std::unordered_map<EntityId, math::njMat4f> transforms_{};
+
+        std::shared_ptr<physics::ThreadPool> pool_;
+
+        // bounding boxes of all simulated entities at tick (i+1)
+        std::unique_ptr<physics::Broadphase> broadphase_;
+
+        // overlapping pairs at tick (i+1)
+        physics::OverlappingPairs overlapping_{};
     };
 }  // namespace njin::ecs
\ No newline at end of file
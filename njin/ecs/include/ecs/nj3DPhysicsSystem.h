@@ -2,7 +2,15 @@
 #include <chrono>
 #include <unordered_map>
 
-#include <physics/BVH.h>
+#include <memory>
+#include <optional>
+
+#include <physics/Broadphase.h>
+#include <physics/ContactSolver.h>
+#include <physics/Islands.h>
+#include <physics/Queries.h>
+#include <physics/Sweep.h>
+#include <physics/ThreadPool.h>
 
 #include "math/njMat4.h"
 #include "njSystem.h"
@@ -12,7 +20,7 @@ namespace njin::ecs {
     /**
     * Responsible for directly modifying the transform of entities. This system should
     * be the only system that can directly write to a transform component.
-    * Runs at a fixed tick rate.
+    * Runs at a fixed tick rate, paced by the wall clock or by calls to step.
     *
     * During an update at t_i, the physics system performs 3 main tasks in order.
     * 1. If the entity has a movement intent component, process it and
@@ -23,17 +31,128 @@ namespace njin::ecs {
     * to find the position of the entity at t_(i+1) and store it
     *
     * In step 3, verlet integration is used to find the tentative position of
-    * an entity at t_(i+1). Then, a binary BVH is constructed to resolve
-    * penetrations based on this tentative position.
-    * The BVH is then updated, then collision queries are answered.
+    * an entity at t_(i+1). Then, a broadphase that persists across ticks
+    * is updated to resolve penetrations based on this tentative position.
+    * The broadphase is then updated, then collision queries are answered.
+    * Contacts are resolved by a contact solver with a fixed number of
+    * iterations, so the cost of a tick stays bounded. Penetrations it
+    * leaves are picked up again on the next tick.
+    *
+    * Touching dynamic bodies form islands. Once every body of an island
+    * has stayed below its sleep velocity for the sleep time, the island
+    * falls asleep: its bodies are no longer integrated and keep their
+    * bounding boxes, until an awake body touches the island or a body of
+    * it is given a velocity.
+    *
+    * Bodies flagged as bullets are swept from their position at t_i to
+    * their tentative position before depenetration, so that they stop at
+    * static bodies in their way instead of passing through them. A body
+    * that hits something has the rest of its motion reflected and swept
+    * again, up to a maximum number of substeps, after which it stays
+    * where the last substep left it.
+    *
+    * Finally, the queries of every njCollidersComponent are answered
+    * against the broadphase as one batch, in parallel.
     *
     */
     class nj3DPhysicsSystem final : public njSystem {
         public:
-        nj3DPhysicsSystem();
+        /**
+         * Constructor
+         * @param broadphase Type of broadphase to find overlaps with
+         * @param solver Contact solver settings
+         * @param pool Threads to run the contact solver, queries and
+         * broadphase builds on,
+         * shared with other systems and worlds, e.g. the pool of a
+         * njWorldHost. Without one, all work runs on the updating thread.
+         */
+        explicit nj3DPhysicsSystem(physics::BroadphaseType broadphase =
+                                   physics::BroadphaseType::DynamicTree,
+                                   const physics::ContactSolverSettings&
+                                   solver = {},
+                                   std::shared_ptr<physics::ThreadPool> pool =
+                                   nullptr);
 
+        /**
+         * Tick once the tick interval has passed on the wall clock
+         * @param entity_manager Entity manager
+         */
         void update(const ecs::njEntityManager& entity_manager) override;
 
+        /**
+         * Advance the simulation by one fixed tick, however much time has
+         * passed. Call this instead of update to drive the simulation
+         * yourself, e.g. from tests or a fixed-step loop.
+         * @param entity_manager Entity manager
+         */
+        void step(const ecs::njEntityManager& entity_manager);
+
+        /**
+         * @return Simulated seconds per tick
+         */
+        static float get_tick_duration();
+
+        /**
+         * Switch to another type of broadphase. The new broadphase is
+         * filled on the next tick.
+         * @param broadphase Type of broadphase to find overlaps with
+         */
+        void set_broadphase(physics::BroadphaseType broadphase);
+
+        /**
+         * Change the settings of the contact solver, from the next tick on
+         * @param settings Contact solver settings
+         */
+        void set_solver_settings(const physics::ContactSolverSettings&
+                                 settings);
+
+        /**
+         * @return Stats of the contact solver during the last tick
+         */
+        const physics::ContactSolverStats& get_solver_stats() const;
+
+        /**
+         * Set how long the bodies of an island have to rest before it
+         * falls asleep
+         * @param seconds Sleep time in seconds
+         */
+        void set_sleep_time(float seconds);
+
+        /**
+         * @return Number of dynamic bodies that were awake at the end of
+         * the last tick
+         */
+        size_t get_awake_count() const;
+
+        /**
+         * @return Number of dynamic bodies that were asleep at the end of
+         * the last tick
+         */
+        size_t get_sleeping_count() const;
+
+        /**
+         * @param entity Entity to check
+         * @return True if the entity is a sleeping dynamic body
+         */
+        bool is_sleeping(EntityId entity) const;
+
+        /**
+         * Set how many times a bullet may hit something and continue
+         * moving within a tick
+         * @param substeps Maximum number of substeps
+         */
+        void set_max_ccd_substeps(uint32_t substeps);
+
+        /**
+         * Answer a batch of queries against the bounding boxes as of the
+         * last tick, in parallel
+         * @param queries Queries to answer
+         * @param results Buffer to write the results to, in the order of
+         * the queries. It is resized to fit.
+         */
+        void answer_queries(std::span<const physics::Query> queries,
+                            std::vector<physics::QueryResult>& results);
+
         private:
         /**
          * Check if the time since the last update has passed the predefined
@@ -56,6 +175,49 @@ namespace njin::ecs {
 
         std::unordered_map<EntityId, math::njMat4f> entity_to_transform_{};
 
+        // shared with the broadphase, so it comes first
+        std::shared_ptr<physics::ThreadPool> pool_;
+
+        // bounding boxes of all simulated entities at tick (i+1)
+        std::unique_ptr<physics::Broadphase> broadphase_;
+
+        // overlapping pairs of the current depenetration pass, kept to
+        // reuse its allocation
+        physics::OverlappingPairs overlapping_{};
+
+        physics::ContactSolver solver_;
+
+        // bodies handed to the contact solver, kept to reuse the allocation
+        std::vector<physics::SolverBody> bodies_{};
+
+        /**
+         * Sleep state of a dynamic body
+         */
+        struct SleepState {
+            // seconds the body has been resting for
+            float rest_time{ 0.f };
+            bool is_sleeping{ false };
+            // speed that wakes the body, copied from its collider when it
+            // falls asleep so that integration never reads the collider
+            float sleep_velocity{ 0.f };
+        };
+
+        std::unordered_map<EntityId, SleepState> entity_to_sleep_{};
+
+        // islands of touching dynamic bodies, found each tick
+        physics::Islands islands_{};
+        std::vector<EntityId> dynamic_bodies_{};
+
+        float sleep_time_{ 0.5f };
+        size_t awake_count_{ 0 };
+        size_t sleeping_count_{ 0 };
+
+        uint32_t max_ccd_substeps_{ 4 };
+
+        // queries of all collider components, answered as one batch
+        std::vector<physics::Query> queries_{};
+        std::vector<physics::QueryResult> results_{};
+
         /**
          * Write the transforms for all entities at t_i
          * @param entity_manager Entity manager
@@ -74,7 +236,9 @@ namespace njin::ecs {
 
         /**
          * Calculate the bounding box primitives for all entities, based
-         * on the transforms for the entities at tick (i+1) at the current state
+         * on the transforms for the entities at tick (i+1) at the current
+         * state. Sleeping bodies keep the bounding box they have in the
+         * broadphase.
          * @return List of primitives based on the current transforms
          * for tick (i+1)
          */
@@ -82,14 +246,64 @@ namespace njin::ecs {
         calculate_primitives(const njEntityManager& entity_manager) const;
 
         /**
-         * Resolve all penetrating bodies in a given set of primitives
+         * Sweep bullets from their bounding boxes at t_i to their
+         * tentative ones, moving each back to where it first hits a
+         * static or sleeping body. The broadphase holds the tentative
+         * bounding boxes afterwards if any bullet was swept.
+         * @param entity_manager Entity manager
+         * @param primitives Tentative primitives of all simulated
+         * entities. The bounding boxes of bullets that hit something are
+         * replaced.
+         */
+        void sweep_bullets(const njEntityManager& entity_manager,
+                           std::vector<physics::Primitive>& primitives);
+
+        /**
+         * Find the first body a bullet hits that does not move this tick
+         * @param entity_manager Entity manager
+         * @param entity The bullet
+         * @param box Bounding box of the bullet
+         * @param displacement Motion of the bullet
+         * @return The body that was hit and the contact, or nothing
+         */
+        std::optional<std::pair<EntityId, physics::SweepHit>>
+        find_time_of_impact(const njEntityManager& entity_manager,
+                            EntityId entity,
+                            const physics::BoundingBox& box,
+                            const math::njVec3f& displacement) const;
+
+        /**
+         * Resolve penetrating bodies in a given set of primitives, within
+         * the iterations of the contact solver. The broadphase holds the
+         * depenetrated bounding boxes afterwards.
          * @param entity_manager
          * @param primitives Primitives to depenetrate
-         * @return Updated BVH with no penetrating objects
          */
-        physics::BVH
+        void
         depenetrate(const njEntityManager& entity_manager,
                     const std::vector<physics::Primitive>& primitives);
+
+        /**
+         * Wake every island with an awake body in it, using the current
+         * overlapping pairs
+         * @param entity_manager Entity manager
+         * @param primitives Primitives of all simulated entities
+         */
+        void wake_islands(const njEntityManager& entity_manager,
+                          const std::vector<physics::Primitive>& primitives);
+
+        /**
+         * Advance the rest time of awake bodies, and put islands whose
+         * bodies have all rested long enough to sleep
+         * @param entity_manager Entity manager
+         */
+        void update_sleep(const njEntityManager& entity_manager);
+
+        /**
+         * Answer the queries of all collider components
+         * @param entity_manager Entity manager
+         */
+        void answer_collider_queries(const njEntityManager& entity_manager);
     };
 
 }  // namespace njin::ecs
\ No newline at end of file
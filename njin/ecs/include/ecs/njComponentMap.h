@@ -1,22 +1,186 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "njComponentMapInterface.h"
+#include "njSortedIndex.h"
 
 namespace njin::ecs {
+    /**
+     * Storage of all components of a single type.
+     * Components are stored in fixed-size pages of slots. Pages never move,
+     * so pointers returned by get() stay valid until the component is
+     * removed or the storage is compacted. Removing a component destroys
+     * it in place and leaves a hole that is reused by the next insertion,
+     * so heavy churn fragments the storage until it is compacted.
+     * @tparam Component Component type
+     */
     template<typename Component>
     class njComponentMap : public njComponentMapInterface {
         public:
         using EntityId = uint32_t;
+
+        // key that orders components for locality during compaction
+        using CompactionKey = std::function<uint64_t(const Component&)>;
+
+        njComponentMap() = default;
+        njComponentMap(const njComponentMap&) = delete;
+        njComponentMap& operator=(const njComponentMap&) = delete;
+        ~njComponentMap() override;
+
         void remove(EntityId entity) override;
 
         void insert(EntityId entity, Component component);
 
         Component* get(EntityId entity);
 
+        njComponentStats get_stats() const override;
+
+        bool needs_compaction() const override;
+
+        bool compact(size_t work) override;
+
+        /**
+         * Set the order components are packed in during compaction.
+         * Components are sorted by key, then by entity. Without a key,
+         * components are sorted by entity, which matches the order views
+         * are produced in.
+         * @param key Function extracting the sort key (e.g. spatial cell or
+         * mesh) from a component
+         * @note Changes to a component's value are not tracked, so a
+         * component whose key changed is only moved by the next pass that
+         * is started for another reason
+         */
+        void set_compaction_key(CompactionKey key);
+
+        // key that groups entities in the sorted index
+        using SortKey = std::function<uint64_t(const Component&)>;
+
+        /**
+         * Keep an index of the entities sorted by a key extracted from
+         * their components. The index is kept up to date as components
+         * are inserted and removed; changes to a component's value must be
+         * reported through update_sort_key.
+         * @param key Function extracting the sort key from a component
+         */
+        void set_sort_key(SortKey key);
+
+        /**
+         * Re-extract the sort key of an entity's component after its value
+         * changed
+         * @param entity Entity whose component changed
+         */
+        void update_sort_key(EntityId entity);
+
+        /**
+         * @return The sorted index, or nullptr if no sort key was set
+         */
+        const njSortedIndex* get_sorted_index() const;
+
         private:
-        std::unordered_map<EntityId, Component> map_{};
+        // owner of an empty slot
+        static constexpr EntityId NO_ENTITY{
+            std::numeric_limits<EntityId>::max()
+        };
+
+        // slots per page, about 16 KiB worth of components
+        static constexpr size_t PAGE_SIZE{
+            std::max<size_t>(1, 16384 / sizeof(Component))
+        };
+
+        // uninitialized storage for PAGE_SIZE components
+        struct Page {
+            alignas(Component) std::byte storage[PAGE_SIZE *
+                                                 sizeof(Component)];
+        };
+
+        // stages of a compaction pass, each done a bounded step at a time
+        enum class CompactionPhase {
+            Idle,    // no pass in progress
+            Gather,  // collect the (key, entity) of every live slot
+            Sort,    // sort blocks of the gathered entries
+            Merge,   // merge sorted blocks into a single order
+            Place    // move each entity to its slot in the order
+        };
+
+        struct CompactionEntry {
+            uint64_t key;
+            EntityId entity;
+        };
+
+        std::vector<std::unique_ptr<Page>> pages_{};
+
+        // entity that owns each slot handed out, NO_ENTITY for holes
+        std::vector<EntityId> slot_to_entity_{};
+
+        std::unordered_map<EntityId, size_t> entity_to_slot_{};
+
+        // holes available for reuse. Entries are checked when popped, so
+        // slots that were filled or trimmed by compaction may linger.
+        std::vector<size_t> free_slots_{};
+
+        // number of holes in slot_to_entity_
+        size_t hole_count_{ 0 };
+
+        // a component was stored out of (key, entity) order
+        bool out_of_order_{ false };
+
+        CompactionKey compaction_key_{};
+
+        // state of the compaction pass in progress
+        CompactionPhase phase_{ CompactionPhase::Idle };
+        std::vector<CompactionEntry> order_{};
+        std::vector<CompactionEntry> merge_buffer_{};
+        size_t cursor_{ 0 };
+        size_t block_size_{ 0 };
+        size_t merge_width_{ 0 };
+        size_t merge_left_{ 0 };
+        size_t merge_right_{ 0 };
+        size_t next_slot_{ 0 };
+
+        SortKey sort_key_{};
+        njSortedIndex sorted_index_{};
+
+        /**
+         * @param slot Slot handed out by the storage
+         * @return Address of the slot
+         */
+        Component* get_slot(size_t slot) const;
+
+        /**
+         * @param slot Live slot
+         * @return Compaction key of the component in the slot
+         */
+        uint64_t get_compaction_key(size_t slot) const;
+
+        /**
+         * Move the component of an entity into a slot, swapping it with
+         * the component already there if there is one
+         * @param entity Entity to move
+         * @param target Slot to move the entity to
+         */
+        void move_to_slot(EntityId entity, size_t target);
+
+        /**
+         * Do up to a given amount of work of the current compaction phase
+         * @param work Work left in this call, reduced by the work done
+         */
+        void gather(size_t& work);
+        void sort_blocks(size_t& work);
+        void merge_blocks(size_t& work);
+        void place(size_t& work);
+
+        /**
+         * End the compaction pass: drop trailing holes and the pages they
+         * leave empty
+         */
+        void finish_compaction();
     };
 }  // namespace njin::ecs
 
@@ -1,18 +1,374 @@
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <typeinfo>
+
 namespace njin::ecs {
+    template<typename Component>
+    njComponentMap<Component>::~njComponentMap() {
+        for (size_t slot{ 0 }; slot < slot_to_entity_.size(); ++slot) {
+            if (slot_to_entity_[slot] != NO_ENTITY) {
+                std::destroy_at(get_slot(slot));
+            }
+        }
+    }
+
     template<typename Component>
     void njComponentMap<Component>::insert(EntityId entity,
                                            Component component) {
-        map_.insert({ entity, component });
+        if (entity_to_slot_.contains(entity)) {
+            return;
+        }
+
+        size_t slot{ slot_to_entity_.size() };
+        while (!free_slots_.empty()) {
+            const size_t hole{ free_slots_.back() };
+            free_slots_.pop_back();
+            if (hole < slot_to_entity_.size() &&
+                slot_to_entity_[hole] == NO_ENTITY) {
+                slot = hole;
+                break;
+            }
+        }
+
+        if (slot == slot_to_entity_.size()) {
+            if (slot == pages_.size() * PAGE_SIZE) {
+                pages_.push_back(std::make_unique<Page>());
+            }
+            slot_to_entity_.push_back(NO_ENTITY);
+        } else {
+            // fill a hole, wherever it is in the order
+            --hole_count_;
+            out_of_order_ = true;
+        }
+        std::construct_at(get_slot(slot), std::move(component));
+        slot_to_entity_[slot] = entity;
+        entity_to_slot_.insert({ entity, slot });
+
+        // appending keeps the order as long as the new component sorts
+        // after the one before it
+        if (slot > 0 && slot == slot_to_entity_.size() - 1) {
+            const EntityId previous{ slot_to_entity_[slot - 1] };
+            if (previous != NO_ENTITY) {
+                const uint64_t key{ get_compaction_key(slot) };
+                const uint64_t previous_key{ get_compaction_key(slot - 1) };
+                if (key < previous_key ||
+                    (key == previous_key && entity < previous)) {
+                    out_of_order_ = true;
+                }
+            }
+        }
+
+        if (sort_key_) {
+            sorted_index_.insert(entity, sort_key_(*get_slot(slot)));
+        }
     }
 
     template<typename Component>
     Component* njComponentMap<Component>::get(EntityId entity) {
-        return &map_.at(entity);
+        return get_slot(entity_to_slot_.at(entity));
     }
 
     template<typename Component>
     void njComponentMap<Component>::remove(EntityId entity) {
-        map_.erase(entity);
+        if (!entity_to_slot_.contains(entity)) {
+            return;
+        }
+
+        const size_t slot{ entity_to_slot_.at(entity) };
+        entity_to_slot_.erase(entity);
+        sorted_index_.remove(entity);
+
+        // release whatever the component holds on to, and leave a hole
+        std::destroy_at(get_slot(slot));
+        slot_to_entity_[slot] = NO_ENTITY;
+        free_slots_.push_back(slot);
+        ++hole_count_;
+    }
+
+    template<typename Component>
+    njComponentStats njComponentMap<Component>::get_stats() const {
+        const size_t count{ entity_to_slot_.size() };
+        const size_t bytes_used{ count * sizeof(Component) };
+        const size_t bytes_reserved{
+            pages_.size() * sizeof(Page) +
+            pages_.capacity() * sizeof(std::unique_ptr<Page>) +
+            slot_to_entity_.capacity() * sizeof(EntityId) +
+            free_slots_.capacity() * sizeof(size_t) +
+            (order_.capacity() + merge_buffer_.capacity()) *
+            sizeof(CompactionEntry) +
+            estimate_map_bytes(entity_to_slot_)
+        };
+
+        float load_factor{ 0.f };
+        float fragmentation{ 0.f };
+        if (!slot_to_entity_.empty()) {
+            load_factor = static_cast<float>(count) /
+                          static_cast<float>(slot_to_entity_.size());
+            fragmentation = static_cast<float>(hole_count_) /
+                            static_cast<float>(slot_to_entity_.size());
+        }
+
+        return { .name = demangle(typeid(Component).name()),
+                 .count = count,
+                 .component_size = sizeof(Component),
+                 .bytes_used = bytes_used,
+                 .bytes_reserved = bytes_reserved,
+                 .load_factor = load_factor,
+                 .fragmentation = fragmentation };
+    }
+
+    template<typename Component>
+    bool njComponentMap<Component>::needs_compaction() const {
+        return phase_ != CompactionPhase::Idle || hole_count_ > 0 ||
+               out_of_order_;
+    }
+
+    template<typename Component>
+    bool njComponentMap<Component>::compact(size_t work) {
+        if (phase_ == CompactionPhase::Idle) {
+            if (!needs_compaction()) {
+                return true;
+            }
+            // start a new pass. Anything stored out of order from here on
+            // is only caught by the next pass.
+            out_of_order_ = false;
+            order_.clear();
+            order_.reserve(entity_to_slot_.size());
+            cursor_ = 0;
+            block_size_ = std::max<size_t>(work, 1);
+            phase_ = CompactionPhase::Gather;
+        }
+
+        work = std::max<size_t>(work, 1);
+        while (work > 0 && phase_ != CompactionPhase::Idle) {
+            switch (phase_) {
+                case CompactionPhase::Gather:
+                    gather(work);
+                    break;
+                case CompactionPhase::Sort:
+                    sort_blocks(work);
+                    break;
+                case CompactionPhase::Merge:
+                    merge_blocks(work);
+                    break;
+                case CompactionPhase::Place:
+                    place(work);
+                    break;
+                case CompactionPhase::Idle:
+                    break;
+            }
+        }
+
+        return phase_ == CompactionPhase::Idle;
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::gather(size_t& work) {
+        for (; work > 0 && cursor_ < slot_to_entity_.size(); --work) {
+            const EntityId entity{ slot_to_entity_[cursor_] };
+            if (entity != NO_ENTITY) {
+                order_.push_back({ get_compaction_key(cursor_), entity });
+            }
+            ++cursor_;
+        }
+
+        if (cursor_ == slot_to_entity_.size()) {
+            cursor_ = 0;
+            phase_ = CompactionPhase::Sort;
+        }
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::sort_blocks(size_t& work) {
+        const auto less{ [](const CompactionEntry& a,
+                            const CompactionEntry& b) {
+            if (a.key != b.key) {
+                return a.key < b.key;
+            }
+            return a.entity < b.entity;
+        } };
+
+        // a whole block at a time, so a call may overshoot by one block
+        while (work > 0 && cursor_ < order_.size()) {
+            const size_t end{ std::min(cursor_ + block_size_,
+                                       order_.size()) };
+            std::sort(order_.begin() + cursor_, order_.begin() + end, less);
+            work -= std::min(work, end - cursor_);
+            cursor_ = end;
+        }
+
+        if (cursor_ == order_.size()) {
+            merge_buffer_.resize(order_.size());
+            merge_width_ = block_size_;
+            cursor_ = 0;
+            merge_left_ = 0;
+            merge_right_ = std::min(merge_width_, order_.size());
+            phase_ = CompactionPhase::Merge;
+        }
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::merge_blocks(size_t& work) {
+        // bottom-up merge sort: cursor_ is the start of the pair of runs
+        // being merged, merge_left_ / merge_right_ the next entry of each
+        const size_t count{ order_.size() };
+        while (work > 0 && merge_width_ < count) {
+            const size_t middle{ std::min(cursor_ + merge_width_, count) };
+            const size_t end{ std::min(cursor_ + 2 * merge_width_, count) };
+            for (; work > 0 && (merge_left_ < middle || merge_right_ < end);
+                 --work) {
+                const size_t out{ merge_left_ + merge_right_ - middle };
+                bool take_left{ merge_right_ == end };
+                if (merge_left_ < middle && merge_right_ < end) {
+                    const CompactionEntry& left{ order_[merge_left_] };
+                    const CompactionEntry& right{ order_[merge_right_] };
+                    // ties go left, so the sort is stable
+                    take_left = left.key != right.key
+                                ? left.key < right.key
+                                : left.entity <= right.entity;
+                }
+                if (take_left) {
+                    merge_buffer_[out] = order_[merge_left_];
+                    ++merge_left_;
+                } else {
+                    merge_buffer_[out] = order_[merge_right_];
+                    ++merge_right_;
+                }
+            }
+
+            if (merge_left_ == middle && merge_right_ == end) {
+                cursor_ = end;
+                if (cursor_ == count) {
+                    // every pair of runs merged, the runs are twice as long
+                    std::swap(order_, merge_buffer_);
+                    merge_width_ *= 2;
+                    cursor_ = 0;
+                }
+                merge_left_ = cursor_;
+                merge_right_ = std::min(cursor_ + merge_width_, count);
+            }
+        }
+
+        if (merge_width_ >= count) {
+            merge_buffer_ = {};
+            cursor_ = 0;
+            next_slot_ = 0;
+            phase_ = CompactionPhase::Place;
+        }
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::place(size_t& work) {
+        // cursor_ walks the order
+        for (; work > 0 && cursor_ < order_.size(); --work) {
+            const EntityId entity{ order_[cursor_].entity };
+            ++cursor_;
+            // removed since the pass started
+            if (!entity_to_slot_.contains(entity)) {
+                continue;
+            }
+            move_to_slot(entity, next_slot_);
+            ++next_slot_;
+        }
+
+        if (cursor_ == order_.size()) {
+            finish_compaction();
+        }
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::move_to_slot(EntityId entity,
+                                                 size_t target) {
+        const size_t slot{ entity_to_slot_.at(entity) };
+        if (slot == target) {
+            return;
+        }
+
+        Component* from{ get_slot(slot) };
+        Component* to{ get_slot(target) };
+        const EntityId occupant{ slot_to_entity_[target] };
+        if (occupant == NO_ENTITY) {
+            std::construct_at(to, std::move(*from));
+            std::destroy_at(from);
+            free_slots_.push_back(slot);
+        } else {
+            Component temporary{ std::move(*to) };
+            std::destroy_at(to);
+            std::construct_at(to, std::move(*from));
+            std::destroy_at(from);
+            std::construct_at(from, std::move(temporary));
+            entity_to_slot_.at(occupant) = slot;
+        }
+        slot_to_entity_[slot] = occupant;
+        slot_to_entity_[target] = entity;
+        entity_to_slot_.at(entity) = target;
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::finish_compaction() {
+        while (!slot_to_entity_.empty() &&
+               slot_to_entity_.back() == NO_ENTITY) {
+            slot_to_entity_.pop_back();
+            --hole_count_;
+        }
+        pages_.resize((slot_to_entity_.size() + PAGE_SIZE - 1) / PAGE_SIZE);
+        if (hole_count_ == 0) {
+            free_slots_ = {};
+        }
+
+        order_ = {};
+        entity_to_slot_.rehash(0);
+        phase_ = CompactionPhase::Idle;
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::set_compaction_key(CompactionKey key) {
+        compaction_key_ = std::move(key);
+        if (!entity_to_slot_.empty()) {
+            out_of_order_ = true;
+        }
+    }
+
+    template<typename Component>
+    Component* njComponentMap<Component>::get_slot(size_t slot) const {
+        std::byte* storage{ pages_[slot / PAGE_SIZE]->storage };
+        return std::launder(reinterpret_cast<Component*>(
+        storage + (slot % PAGE_SIZE) * sizeof(Component)));
+    }
+
+    template<typename Component>
+    uint64_t njComponentMap<Component>::get_compaction_key(size_t slot) const {
+        return compaction_key_ ? compaction_key_(*get_slot(slot)) : 0;
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::set_sort_key(SortKey key) {
+        sort_key_ = std::move(key);
+        sorted_index_ = {};
+        if (!sort_key_) {
+            return;
+        }
+        for (const auto& [entity, slot] : entity_to_slot_) {
+            sorted_index_.insert(entity, sort_key_(*get_slot(slot)));
+        }
+    }
+
+    template<typename Component>
+    void njComponentMap<Component>::update_sort_key(EntityId entity) {
+        if (!sort_key_) {
+            return;
+        }
+        const Component& component{ *get(entity) };
+        sorted_index_.update(entity, sort_key_(component));
+    }
+
+    template<typename Component>
+    const njSortedIndex* njComponentMap<Component>::get_sorted_index() const {
+        if (!sort_key_) {
+            return nullptr;
+        }
+        return &sorted_index_;
     }
 
 };  // namespace njin::ecs
\ No newline at end of file
@@ -1,11 +1,35 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
+#include "ecs/njEntityManagerStats.h"
+
 namespace njin::ecs {
     class njComponentMapInterface {
         public:
         virtual ~njComponentMapInterface() = default;
 
         virtual void remove(uint32_t entity) = 0;
+
+        /**
+         * @return Memory and occupancy stats of this map
+         */
+        virtual njComponentStats get_stats() const = 0;
+
+        /**
+         * @return True if the storage has holes or is out of its locality
+         * order, or if a compaction pass is in progress
+         */
+        virtual bool needs_compaction() const = 0;
+
+        /**
+         * Re-pack the storage so that it has no holes, ordered for
+         * locality. A pass is spread over as many calls as needed, each
+         * resuming where the previous one stopped.
+         * @param work Most components to visit in this call
+         * @return True if there is no pass left in progress
+         * @note Invalidates all pointers into the storage
+         */
+        virtual bool compact(size_t work) = 0;
     };
 }  // namespace njin::ecs
\ No newline at end of file
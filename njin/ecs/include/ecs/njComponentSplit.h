@@ -0,0 +1,31 @@
+#pragma once
+#include <concepts>
+
+namespace njin::ecs {
+    /**
+     * Declares that a logical component is stored as two separate streams:
+     * a hot one with the fields read every tick, and a cold one with the
+     * rest. Specialize it for a component to split it:
+     * - hot_type, cold_type: the two stored component types
+     * - static hot_type hot(const Component&)
+     * - static cold_type cold(const Component&)
+     * The entity manager then stores the two parts in their own component
+     * maps whenever the logical component is added or removed, and queries
+     * name hot_type or cold_type to only touch the part they need.
+     * @tparam Component Logical component type
+     */
+    template<typename Component>
+    struct njComponentSplit;
+
+    template<typename Component>
+    concept SplitComponent = requires(const Component& component) {
+        typename njComponentSplit<Component>::hot_type;
+        typename njComponentSplit<Component>::cold_type;
+        {
+            njComponentSplit<Component>::hot(component)
+        } -> std::same_as<typename njComponentSplit<Component>::hot_type>;
+        {
+            njComponentSplit<Component>::cold(component)
+        } -> std::same_as<typename njComponentSplit<Component>::cold_type>;
+    };
+}  // namespace njin::ecs
\ No newline at end of file
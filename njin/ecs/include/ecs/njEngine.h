@@ -1,10 +1,13 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 #include "ecs/njArchetype.h"
 #include "ecs/njEntityManager.h"
+#include "ecs/njScheduler.h"
 #include "ecs/njSystem.h"
 #include "njPlayerArchetype.h"
 
@@ -12,12 +15,34 @@ namespace njin::ecs {
     using EntityId = uint32_t;
 
     /**
-     * Main engine class oversees and runs updates on all systems
+     * How many slices a system needed for its last full pass
+     * @param system System the report is for
+     * @param tick_group Tick group the system runs in
+     * @param time_sliced True if the system runs in time-sliced mode
+     * @param slices Number of updates the last completed pass took. Systems
+     * that are not time-sliced take 1, and systems that never iterate
+     * through njSystem::for_each_sliced report 0.
+     */
+    struct njSliceReport {
+        const njSystem* system{ nullptr };
+        TickGroup tick_group{ TickGroup::Zero };
+        bool time_sliced{ false };
+        uint32_t slices{ 0 };
+    };
+
+    /**
+     * Main engine class oversees and runs updates on all systems.
+     * An engine is a self-contained world: all of its state lives in its
+     * entity manager and its systems, so several engines can run
+     * side by side (@see njWorldHost)
      */
     class njEngine {
         public:
         njEngine();
 
+        njEngine(const njEngine&) = delete;
+        njEngine& operator=(const njEngine&) = delete;
+
         /** Begin forward to entity manager */
         /**
          * Add a system to the engine
@@ -38,6 +63,15 @@ namespace njin::ecs {
          */
         void remove_entity(EntityId entity);
 
+        /**
+         * Enable or disable an entity without changing its components
+         * @param entity Entity to enable or disable
+         * @param enabled True to enable the entity
+         */
+        void set_enabled(EntityId entity, bool enabled) {
+            entity_manager_.set_enabled(entity, enabled);
+        }
+
         /**
          * Query for a particular view
          * @tparam Component Component types to query for
@@ -69,6 +103,27 @@ namespace njin::ecs {
             entity_manager_.add_component(entity, component);
         }
 
+        /**
+         * Add a shared component to an existing entity
+         * @tparam Component Type of component
+         * @param entity Entity to add component to
+         * @param value Value of the component
+         */
+        template<typename Component>
+        void add_shared_component(EntityId entity, const Component& value) {
+            entity_manager_.add_shared_component(entity, value);
+        }
+
+        /**
+         * Query the groups of entities sharing a value
+         * @tparam Component Type of component
+         * @return List of groups
+         */
+        template<typename Component>
+        std::vector<njSharedGroup<Component>> get_shared_groups() const {
+            return entity_manager_.get_shared_groups<Component>();
+        }
+
         /**
          * Query for a particular view of an entity
          * @tparam Component Component types to query for
@@ -79,8 +134,49 @@ namespace njin::ecs {
             return entity_manager_.get_view<Component...>(entity);
         }
 
+        /**
+         * Take a snapshot of the memory use of the entity manager
+         * @return Stats snapshot
+         */
+        njEntityManagerStats get_stats() const {
+            return entity_manager_.get_stats();
+        }
+
+        /**
+         * Set the order a component type's storage is packed in during
+         * compaction
+         * @tparam Component Component type
+         * @param key Function extracting the sort key from a component
+         * @note May be set before any component of this type exists
+         */
+        template<typename Component>
+        void set_compaction_key(
+        typename njComponentMap<Component>::CompactionKey key) {
+            entity_manager_.set_compaction_key<Component>(std::move(key));
+        }
+
+        /**
+         * Keep the entities with a component type sorted by a key
+         * extracted from that component
+         * @tparam Component Component type
+         * @param key Function extracting the sort key from a component
+         */
+        template<typename Component>
+        void set_sort_key(typename njComponentMap<Component>::SortKey key) {
+            entity_manager_.set_sort_key<Component>(std::move(key));
+        }
+
         /** End forward to entity manager */
 
+        /**
+         * Compact the entity manager's storage incrementally at the end of
+         * every update
+         * @param budget Time budget of compaction per update. If empty,
+         * storage is never compacted automatically.
+         * @note Compaction invalidates the views held by suspended tasks
+         */
+        void set_compaction_budget(std::optional<njSystem::Budget> budget);
+
         /**
         * Create a new entity out of a given archetype
         * @param archetype Archetype to make the entity from
@@ -89,10 +185,33 @@ namespace njin::ecs {
         EntityId add_archetype(const njArchetype& archetype);
 
         /**
-         * Updates all systems in tick group order
+         * Updates all systems in tick group order, after resuming the
+         * tasks that are ready to continue
          */
         void update();
 
+        /**
+         * Start a task that runs across updates. Tasks are resumed at the
+         * start of every update, before tick group Zero.
+         * @param task Task to start
+         * @note Tasks must fetch their views again after every co_await,
+         * @see njTask
+         */
+        void spawn(njTask<> task);
+
+        /**
+         * @return Number of tasks (spawned by the engine or its systems)
+         * that have not finished
+         */
+        size_t get_task_count() const;
+
+        /**
+         * Report how many slices each system needed for its last
+         * completed pass
+         * @return One report per system, in tick group order
+         */
+        std::vector<njSliceReport> get_slice_reports() const;
+
         private:
         // systems belonging to the same tick group
         using TickGroupSystems = std::vector<std::unique_ptr<njSystem>>;
@@ -101,6 +220,12 @@ namespace njin::ecs {
 
         njEntityManager entity_manager_{};
 
+        // declared after the systems, so that tasks are destroyed before
+        // the systems they may refer to
+        njScheduler scheduler_{};
+
+        std::optional<njSystem::Budget> compaction_budget_{};
+
         /**
          * Updates all systems in a tick group
          * @param group Tick group of systems to update
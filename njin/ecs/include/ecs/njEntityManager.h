@@ -1,5 +1,7 @@
 #pragma once
+#include <array>
 #include <bitset>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -9,6 +11,10 @@
 #include "ecs/EngineTypes.h"
 #include "ecs/njComponentMap.h"
 #include "ecs/njComponentMapInterface.h"
+#include "ecs/njComponentSplit.h"
+#include "ecs/njEntityManagerStats.h"
+#include "ecs/njSharedComponentMap.h"
+#include "ecs/njSortedIndex.h"
 
 #include <any>
 #include <set>
@@ -46,6 +52,9 @@ namespace njin::ecs {
     class njEntityManager {
         public:
         static constexpr int SIGNATURE_LENGTH = 32;
+
+        // components visited per step of a budgeted compaction
+        static constexpr size_t COMPACTION_STEP = 256;
         using ComponentType = std::type_index;
         using EntityName = std::string;
         using ComponentSignature = std::bitset<SIGNATURE_LENGTH>;
@@ -59,11 +68,21 @@ namespace njin::ecs {
             }
         };
 
+        // order of signatures in the per-component bucket index
+        struct ComponentSignatureLess {
+            bool operator()(const ComponentSignature& a,
+                            const ComponentSignature& b) const {
+                return a.to_ullong() < b.to_ullong();
+            }
+        };
+
         /**
          * Add a component to an existing entity
          * @tparam Component Type of component
          * @param entity Entity to add component to
          * @param component Component to add
+         * @note Split components are added as their hot and cold parts,
+         * @see njComponentSplit
          */
         template<typename Component>
         void add_component(EntityId entity, Component component);
@@ -81,6 +100,22 @@ namespace njin::ecs {
          */
         void remove_entity(EntityId entity);
 
+        /**
+         * Enable or disable an entity. Disabled entities keep all their
+         * components and their signature, but are skipped by every query
+         * over multiple entities until they are enabled again.
+         * @param entity Entity to enable or disable
+         * @param enabled True to enable the entity
+         * @note O(1), does not move the entity between signature buckets
+         */
+        void set_enabled(EntityId entity, bool enabled);
+
+        /**
+         * @param entity Entity to check
+         * @return True if the entity is enabled. Entities start enabled.
+         */
+        bool is_enabled(EntityId entity) const;
+
         /**
          * Query for a particular view across all entities
          * @tparam Component Component types to query for
@@ -119,6 +154,139 @@ namespace njin::ecs {
         template<typename... Component>
         void remove_components(EntityId entity);
 
+        /**
+         * Add a shared component to an existing entity. If another entity
+         * already shares an equal value, the entity joins its group instead
+         * of storing a copy of its own.
+         * @tparam Component Type of component
+         * @param entity Entity to add component to
+         * @param value Value of the component
+         * @note Shared components have their own signature bit, named
+         * njShared<Component>. It can be used in Exclude and
+         * has_components, but not in views: read the value with
+         * get_shared_component or get_shared_groups instead.
+         */
+        template<typename Component>
+        requires std::equality_comparable<Component>
+        void add_shared_component(EntityId entity, const Component& value);
+
+        /**
+         * Read the shared component of an entity
+         * @tparam Component Type of component
+         * @param entity Entity to read the component of
+         * @return Shared component, or nullptr if no entity ever had a
+         * shared component of this type
+         */
+        template<typename Component>
+        const Component* get_shared_component(EntityId entity) const;
+
+        /**
+         * Get a modifiable shared component of an entity. The value is
+         * copied first if other entities share it, so changes only ever
+         * apply to this entity.
+         * @tparam Component Type of component
+         * @param entity Entity to get the component of
+         * @return Component that only this entity refers to, or nullptr
+         * if no entity ever had a shared component of this type
+         * @note Invalidates groups returned by get_shared_groups
+         */
+        template<typename Component>
+        Component* get_shared_component_mutable(EntityId entity);
+
+        /**
+         * Remove the shared component of an entity
+         * @tparam Component Type of component
+         * @param entity Entity to remove the component from
+         */
+        template<typename Component>
+        void remove_shared_component(EntityId entity);
+
+        /**
+         * Query the groups of entities sharing a value, e.g. to batch work
+         * that only depends on the value
+         * @tparam Component Type of component
+         * @return List of groups
+         * @note Groups list their disabled entities as well, since they
+         * refer to the storage directly. Check is_enabled when iterating.
+         */
+        template<typename Component>
+        std::vector<njSharedGroup<Component>> get_shared_groups() const;
+
+        /**
+         * Check whether an entity has all the given components
+         * @tparam Component Component types
+         * @param entity Entity to check
+         * @return True if the entity has every component type
+         * @note A split component is on an entity if both of its parts are
+         */
+        template<typename... Component>
+        bool has_components(EntityId entity) const;
+
+        /**
+         * Take a snapshot of the memory use of this entity manager: per
+         * component type storage, per signature bucket occupancy and the
+         * bookkeeping maps
+         * @return Stats snapshot
+         */
+        njEntityManagerStats get_stats() const;
+
+        /**
+         * Re-pack component storage and drop empty signature buckets.
+         * A pass is spread over as many calls as needed: each call
+         * compacts the maps that need it in steps of COMPACTION_STEP
+         * components until the budget is used up, and the next call
+         * resumes where it stopped.
+         * @param budget Time budget of this call
+         * @return True if this call finished a compaction pass
+         * @note At least one step is done per call. Invalidates all views.
+         */
+        bool compact(std::chrono::microseconds budget);
+
+        /**
+         * Set the order a component type's storage is packed in during
+         * compaction, e.g. by spatial cell or by mesh, so that entities
+         * with equal keys are adjacent in memory
+         * @tparam Component Component type
+         * @param key Function extracting the sort key from a component
+         * @note May be set before any component of this type exists
+         */
+        template<typename Component>
+        void set_compaction_key(
+        typename njComponentMap<Component>::CompactionKey key);
+
+        /**
+         * Keep the entities with a component type sorted by a key
+         * extracted from that component, e.g. (mesh, texture) or spatial
+         * cell, so that entities with equal keys form contiguous runs.
+         * The order is maintained incrementally as components are added
+         * and removed, and as changes are reported through mark_changed.
+         * @tparam Component Component type
+         * @param key Function extracting the sort key from a component
+         */
+        template<typename Component>
+        void set_sort_key(typename njComponentMap<Component>::SortKey key);
+
+        /**
+         * Query the entities with a component type, grouped by sort key
+         * @tparam Component Component type
+         * @return One run of entities per distinct key, in ascending key
+         * order. Empty if no sort key was set.
+         * @note Runs refer to the index directly, so they list disabled
+         * entities as well. Invalidated by any change to the component type.
+         */
+        template<typename Component>
+        std::vector<njSortedIndex::Run> get_sorted_runs() const;
+
+        /**
+         * Report that the value of an entity's component changed, so that
+         * it is moved to the run of its new sort key
+         * @tparam Component Component type
+         * @param entity Entity whose component changed
+         * @note Does nothing if no sort key was set
+         */
+        template<typename Component>
+        void mark_changed(EntityId entity) const;
+
         private:
         std::unordered_map<ComponentType,
                            std::unique_ptr<njComponentMapInterface>>
@@ -135,11 +303,22 @@ namespace njin::ecs {
         std::unordered_map<ComponentSignature, std::set<EntityId>>
         signature_to_ids_{};
 
+        // inverted index: for each component bit, the signatures of all
+        // buckets with that bit set, sorted by ComponentSignatureLess
+        std::array<std::vector<ComponentSignature>, SIGNATURE_LENGTH>
+        bit_to_signatures_{};
+
         EntityId current_{ 0 };
 
+        // enabled bit of every entity, indexed by EntityId
+        std::vector<bool> enabled_{};
+
         // current available signature for a new component
         ComponentSignature current_signature_{ 0b1 };
 
+        // component maps left to compact in the current compaction pass
+        std::vector<ComponentType> compaction_queue_{};
+
         /**
          * Get the map that contains a certain component type
          * @tparam Component Component type
@@ -149,6 +328,25 @@ namespace njin::ecs {
         template<typename Component>
         njComponentMap<Component>* get_component_map() const;
 
+        /**
+         * Get the map of a component type, making it and giving the type
+         * a signature bit if it does not exist yet
+         * @tparam Map Type of the component map
+         * @param type Component type stored in the map
+         * @return Component map
+         */
+        template<typename Map>
+        Map* make_component_map(ComponentType type);
+
+        /**
+         * Get the map that contains a certain shared component type
+         * @tparam Component Component type
+         * @return Shared component map. If the component does not have a
+         * map then it returns nullptr
+         */
+        template<typename Component>
+        njSharedComponentMap<Component>* get_shared_component_map() const;
+
         /**
          * Update the respective maps when an entity has a new component signature
          * @param entity EntityId of the entity
@@ -185,17 +383,45 @@ namespace njin::ecs {
         ComponentSignature get_signature() const;
 
         /**
-         * Get all the Entities whose component signatures satisfy the
-         * given signature. An Entity has a satisfactory component signature
-         * if all the bits set in the requirement signature are also set
-         * in the component signature.
-         * That is, if Entity A has components C0, C1, C2, the requirement signature
-         * of {C0, C1} is satisfied, and so is {C0}, and so forth.
-         * @param requirement Requirement signature, the signature to satisfy
-         * @return List of Entities
+         * Get all the signature buckets whose signatures satisfy the
+         * include signature but not the exclude signature. A signature
+         * satisfies a requirement if all the bits set in the requirement
+         * are also set in the signature. That is, if Entity A has
+         * components C0, C1, C2, the requirement signature of {C0, C1} is
+         * satisfied, and so is {C0}, and so forth.
+         * The zero requirement is only satisfied by entities with no
+         * components at all.
+         * @param include Requirement signature, the signature to satisfy
+         * @param exclude Signature that must not be satisfied
+         * @return Matching buckets, in ascending signature order
+         * @note Buckets are found by intersecting the sorted bucket lists
+         * of the included components, so the cost depends on how many
+         * buckets contain those components, not on how many buckets exist
+         */
+        std::vector<const std::set<EntityId>*>
+        get_buckets(ComponentSignature include,
+                    ComponentSignature exclude) const;
+
+        /**
+         * Get the bucket of a signature, making and indexing it if it does
+         * not exist yet
+         * @param signature Signature of the bucket
+         * @return Bucket
+         */
+        std::set<EntityId>& get_bucket(ComponentSignature signature);
+
+        /**
+         * Get the names of the component types in a signature
+         * @param signature Signature to get the component types of
+         * @return Names of the component types
+         */
+        std::vector<std::string>
+        get_component_names(ComponentSignature signature) const;
+
+        /**
+         * Drop signature buckets that no longer hold any entities
          */
-        std::set<EntityId>
-        get_entities_by_signature(ComponentSignature requirement) const;
+        void prune_signature_buckets();
     };
 
 }  // namespace njin::ecs
@@ -1,42 +1,38 @@
 #pragma once
 #include <iostream>
+#include <iterator>
+#include <ranges>
 
 namespace njin::ecs {
 
     template<typename Component>
     void njEntityManager::add_component(EntityId entity, Component component) {
-        ComponentType component_type{ typeid(Component) };
-        if (type_to_components_.contains(component_type)) {
-            njComponentMap<Component>* map{
-                static_cast<njComponentMap<Component>*>(type_to_components_
-                                                        .at(component_type)
-                                                        .get())
-            };
-
-            map->insert(entity, component);
-        } else {  // new component type
-            // record the new type's bit signature
-            type_to_signature_.insert({ component_type, current_signature_ });
-            signature_to_type_.insert({ current_signature_, component_type });
-            current_signature_ <<= 1;
+        static_assert(!SharedComponent<Component>,
+                      "shared components are added with add_shared_component");
+        if constexpr (SplitComponent<Component>) {
+            using Split = njComponentSplit<Component>;
+            add_component(entity, Split::hot(component));
+            add_component(entity, Split::cold(component));
+        } else {
+            ComponentType component_type{ typeid(Component) };
+            make_component_map<njComponentMap<Component>>(component_type)
+            ->insert(entity, component);
 
-            // make a new map that stores this component type
-            njComponentMap<Component> new_map{};
-            new_map.insert(entity, component);
-            type_to_components_
-            .insert({ component_type,
-                      std::make_unique<njComponentMap<Component>>(new_map) });
+            ComponentSignature new_signature{
+                calculate_new_signature(entity, component_type)
+            };
+            update_entity_signature(entity, new_signature);
         }
-
-        ComponentSignature new_signature{
-            calculate_new_signature(entity, component_type)
-        };
-        update_entity_signature(entity, new_signature);
     }
 
     template<typename... Component>
     requires(ComponentTypes<Component...>)
     std::vector<View<Component...>> njEntityManager::get_views() const {
+        static_assert(!(SplitComponent<Component> || ...),
+                      "split components are queried by their parts");
+        static_assert(!(SharedComponent<Component> || ...),
+                      "shared components are read with get_shared_component");
+
         // all the relevant component maps
         std::tuple<njComponentMap<Component>*...> maps{
             get_component_map<Component>()...
@@ -57,22 +53,28 @@ namespace njin::ecs {
             calculate_signature<Component...>()
         };
 
-        const std::set<EntityId> entities{
-            get_entities_by_signature(signature)
+        const std::vector<const std::set<EntityId>*> buckets{
+            get_buckets(signature, {})
         };
 
         std::vector<View<Component...>> views{};
-        for (EntityId entity : entities) {
-            // get the view of a single entity
-            View<Component...> view{ std::apply(
-            [entity](njComponentMap<Component>*... map) -> View<Component...> {
-                std::tuple<Component*...> components{
-                    std::make_tuple(map->get(entity)...)
-                };
-                return { entity, components };
-            },
-            maps) };
-            views.push_back(view);
+        for (const std::set<EntityId>* bucket : buckets) {
+            for (EntityId entity : *bucket) {
+                if (!enabled_[entity]) {
+                    continue;
+                }
+                // get the view of a single entity
+                View<Component...> view{ std::apply(
+                [entity](njComponentMap<Component>*... map)
+                -> View<Component...> {
+                    std::tuple<Component*...> components{
+                        std::make_tuple(map->get(entity)...)
+                    };
+                    return { entity, components };
+                },
+                maps) };
+                views.push_back(view);
+            }
         }
 
         return views;
@@ -83,14 +85,38 @@ namespace njin::ecs {
         name_to_id_.insert({ name, current_ });
         const EntityId this_id{ current_ };
         ++current_;
+        enabled_.push_back(true);
 
         update_entity_signature(this_id, 0b0);
 
         return this_id;
     }
 
+    inline void njEntityManager::set_enabled(EntityId entity, bool enabled) {
+        enabled_.at(entity) = enabled;
+    }
+
+    inline bool njEntityManager::is_enabled(EntityId entity) const {
+        return enabled_.at(entity);
+    }
+
+    template<typename Map>
+    Map* njEntityManager::make_component_map(ComponentType type) {
+        if (!type_to_components_.contains(type)) {
+            // new component type, record its bit signature
+            type_to_signature_.insert({ type, current_signature_ });
+            signature_to_type_.insert({ current_signature_, type });
+            current_signature_ <<= 1;
+
+            type_to_components_.insert({ type, std::make_unique<Map>() });
+        }
+        return static_cast<Map*>(type_to_components_.at(type).get());
+    }
+
     template<typename Component>
     njComponentMap<Component>* njEntityManager::get_component_map() const {
+        static_assert(!SharedComponent<Component>,
+                      "shared components are stored in a shared map");
         ComponentType type_id{ typeid(Component) };
         if (type_to_components_.contains(type_id)) {
             return static_cast<njComponentMap<Component>*>(type_to_components_
@@ -100,20 +126,116 @@ namespace njin::ecs {
         return nullptr;
     }
 
+    template<typename Component>
+    requires std::equality_comparable<Component>
+    void njEntityManager::add_shared_component(EntityId entity,
+                                               const Component& value) {
+        ComponentType component_type{ typeid(njShared<Component>) };
+        njSharedComponentMap<Component>* map{
+            make_component_map<njSharedComponentMap<Component>>(component_type)
+        };
+        map->insert(entity, map->find_group(value));
+
+        ComponentSignature new_signature{
+            calculate_new_signature(entity, component_type)
+        };
+        update_entity_signature(entity, new_signature);
+    }
+
+    template<typename Component>
+    const Component*
+    njEntityManager::get_shared_component(EntityId entity) const {
+        const njSharedComponentMap<Component>* map{
+            get_shared_component_map<Component>()
+        };
+        if (!map) {
+            return nullptr;
+        }
+        return map->get(entity);
+    }
+
+    template<typename Component>
+    Component* njEntityManager::get_shared_component_mutable(EntityId entity) {
+        njSharedComponentMap<Component>* map{
+            get_shared_component_map<Component>()
+        };
+        if (!map) {
+            return nullptr;
+        }
+        return map->get_mutable(entity);
+    }
+
+    template<typename Component>
+    void njEntityManager::remove_shared_component(EntityId entity) {
+        njSharedComponentMap<Component>* map{
+            get_shared_component_map<Component>()
+        };
+        if (!map) {
+            return;
+        }
+        map->remove(entity);
+
+        ComponentSignature old{ id_to_signature_.at(entity) };
+        ComponentSignature remove{ get_signature<njShared<Component>>() };
+        update_entity_signature(entity, old & ~remove);
+    }
+
+    template<typename Component>
+    std::vector<njSharedGroup<Component>>
+    njEntityManager::get_shared_groups() const {
+        njSharedComponentMap<Component>* map{
+            get_shared_component_map<Component>()
+        };
+        if (!map) {
+            return {};
+        }
+        return map->get_groups();
+    }
+
+    template<typename... Component>
+    bool njEntityManager::has_components(EntityId entity) const {
+        if constexpr ((SplitComponent<Component> || ...)) {
+            // split components are on an entity if both parts are
+            return ([&] {
+                if constexpr (SplitComponent<Component>) {
+                    using Split = njComponentSplit<Component>;
+                    return has_components<typename Split::hot_type,
+                                          typename Split::cold_type>(entity);
+                } else {
+                    return has_components<Component>(entity);
+                }
+            }() && ...);
+        } else {
+            // a type that was never added cannot be on any entity
+            if (!(type_to_signature_.contains(typeid(Component)) && ...)) {
+                return false;
+            }
+            const ComponentSignature requirement{
+                calculate_signature<Component...>()
+            };
+            return (id_to_signature_.at(entity) & requirement) ==
+                   requirement;
+        }
+    }
+
+    template<typename Component>
+    njSharedComponentMap<Component>*
+    njEntityManager::get_shared_component_map() const {
+        ComponentType type_id{ typeid(njShared<Component>) };
+        if (type_to_components_.contains(type_id)) {
+            return static_cast<njSharedComponentMap<Component>*>(
+            type_to_components_.at(type_id).get());
+        }
+        return nullptr;
+    }
+
     inline void
     njEntityManager::update_entity_signature(EntityId entity,
                                              ComponentSignature signature) {
         // this entity is new, so it doesn't have a previous signature
         if (!id_to_signature_.contains(entity)) {
             id_to_signature_.insert({ entity, signature });
-            if (!signature_to_ids_.contains(signature)) {
-                signature_to_ids_.insert({ signature, { entity } });
-            } else {
-                std::set<EntityId>& new_bucket{
-                    signature_to_ids_.at(signature)
-                };
-                new_bucket.insert(entity);
-            }
+            get_bucket(signature).insert(entity);
             return;
         }
         ComponentSignature old_signature{ id_to_signature_.at(entity) };
@@ -124,13 +246,29 @@ namespace njin::ecs {
         old_bucket.erase(entity);
 
         // add to new signature bucket
-        // need to check if that bucket actually exists yet
-        if (!signature_to_ids_.contains(signature)) {
-            signature_to_ids_.insert({ signature, { entity } });
-        } else {
-            std::set<EntityId>& new_bucket{ signature_to_ids_.at(signature) };
-            new_bucket.insert(entity);
+        get_bucket(signature).insert(entity);
+    }
+
+    inline std::set<EntityId>&
+    njEntityManager::get_bucket(ComponentSignature signature) {
+        auto [it, inserted]{ signature_to_ids_.try_emplace(signature) };
+        if (inserted) {
+            // index the new bucket under each of its components
+            for (int i{ 0 }; i < SIGNATURE_LENGTH; ++i) {
+                if (!signature.test(i)) {
+                    continue;
+                }
+                std::vector<ComponentSignature>& signatures{
+                    bit_to_signatures_[i]
+                };
+                signatures.insert(std::ranges::lower_bound(
+                                  signatures,
+                                  signature,
+                                  ComponentSignatureLess{}),
+                                  signature);
+            }
         }
+        return it->second;
     }
 
     inline njEntityManager::ComponentSignature
@@ -144,22 +282,50 @@ namespace njin::ecs {
         return old_signature | component_signature;
     }
 
-    inline std::set<EntityId>
-    njEntityManager::get_entities_by_signature(ComponentSignature requirement)
-    const {
-        std::set<EntityId> result{};
+    inline std::vector<const std::set<EntityId>*>
+    njEntityManager::get_buckets(ComponentSignature include,
+                                 ComponentSignature exclude) const {
         // special case where the requirement is entities with no component
-        // at all.
-        if (requirement.none()) {
-            return signature_to_ids_.at(0);
+        // at all. these are excluded by the zero exclude signature too.
+        if (include.none()) {
+            if (exclude.none() || !signature_to_ids_.contains(0)) {
+                return {};
+            }
+            return { &signature_to_ids_.at(0) };
         }
 
-        for (auto [signature, entities] : signature_to_ids_) {
-            if ((requirement & signature) == requirement) {
-                result.insert(entities.begin(), entities.end());
+        // intersect the bucket lists of the included components, starting
+        // from the shortest one
+        std::vector<const std::vector<ComponentSignature>*> lists{};
+        for (int i{ 0 }; i < SIGNATURE_LENGTH; ++i) {
+            if (include.test(i)) {
+                lists.push_back(&bit_to_signatures_[i]);
             }
         }
-        return result;
+        std::ranges::sort(lists, {}, [](const auto* list) {
+            return list->size();
+        });
+
+        std::vector<ComponentSignature> matches{ *lists[0] };
+        std::vector<ComponentSignature> scratch{};
+        for (size_t i{ 1 }; i < lists.size() && !matches.empty(); ++i) {
+            scratch.clear();
+            std::ranges::set_intersection(matches,
+                                          *lists[i],
+                                          std::back_inserter(scratch),
+                                          ComponentSignatureLess{});
+            std::swap(matches, scratch);
+        }
+
+        std::vector<const std::set<EntityId>*> buckets{};
+        buckets.reserve(matches.size());
+        for (const ComponentSignature& signature : matches) {
+            if (exclude.any() && (signature & exclude) == exclude) {
+                continue;
+            }
+            buckets.push_back(&signature_to_ids_.at(signature));
+        }
+        return buckets;
     }
 
     template<typename... Component>
@@ -187,21 +353,38 @@ namespace njin::ecs {
 
     template<typename... Component>
     void njEntityManager::remove_components(EntityId entity) {
-        // remove the components from their maps
-        std::tuple<njComponentMap<Component>*...> maps{
-            get_component_map<Component>()...
-        };
+        if constexpr ((SplitComponent<Component> || ...)) {
+            // remove both parts of split components
+            (
+            [&] {
+                if constexpr (SplitComponent<Component>) {
+                    using Split = njComponentSplit<Component>;
+                    remove_components<typename Split::hot_type,
+                                      typename Split::cold_type>(entity);
+                } else {
+                    remove_components<Component>(entity);
+                }
+            }(),
+            ...);
+        } else {
+            // remove the components from their maps
+            std::tuple<njComponentMap<Component>*...> maps{
+                get_component_map<Component>()...
+            };
 
-        std::apply(
-        [entity](njComponentMap<Component>*... m) { (m->remove(entity), ...); },
-        maps);
+            std::apply(
+            [entity](njComponentMap<Component>*... m) {
+                (m->remove(entity), ...);
+            },
+            maps);
 
-        // update the signature
-        ComponentSignature old{ id_to_signature_.at(entity) };
-        ComponentSignature remove{ calculate_signature<Component>()... };
-        ComponentSignature new_signature{ (old ^ remove) & old };
+            // update the signature
+            ComponentSignature old{ id_to_signature_.at(entity) };
+            ComponentSignature remove{ calculate_signature<Component...>() };
+            ComponentSignature new_signature{ (old ^ remove) & old };
 
-        update_entity_signature(entity, new_signature);
+            update_entity_signature(entity, new_signature);
+        }
     }
 
     inline void njEntityManager::remove_entity(EntityId entity) {
@@ -214,7 +397,7 @@ namespace njin::ecs {
         /** remove entity's components from all component maps */
         std::vector<ComponentType> types{};
         for (int i{ 0 }; i < SIGNATURE_LENGTH; ++i) {
-            if (signature.test(0)) {
+            if (signature.test(i)) {
                 ComponentSignature current{ 0b1 };
                 current <<= i;
                 if (!signature_to_type_.contains(current)) {
@@ -232,6 +415,11 @@ namespace njin::ecs {
 
     template<typename... Component>
     View<Component...> njEntityManager::get_view(EntityId entity) const {
+        static_assert(!(SplitComponent<Component> || ...),
+                      "split components are queried by their parts");
+        static_assert(!(SharedComponent<Component> || ...),
+                      "shared components are read with get_shared_component");
+
         // all the relevant component maps
         std::tuple<njComponentMap<Component>*...> maps{
             get_component_map<Component>()...
@@ -267,6 +455,10 @@ namespace njin::ecs {
         // component type
         auto maps{ [&]<typename... Components>(
                    std::type_identity<std::tuple<Components...>>) {
+            static_assert(!(SplitComponent<Components> || ...),
+                          "split components are queried by their parts");
+            static_assert(!(SharedComponent<Components> || ...),
+                          "shared components can only be excluded");
             return std::make_tuple(get_component_map<Components>()...);
         }(std::type_identity<typename Include::component_types>{}) };
 
@@ -284,34 +476,181 @@ namespace njin::ecs {
             }(std::type_identity<typename Exclude::component_types>{})
         };
 
-        // set difference
-        std::set<EntityId> includes{
-            get_entities_by_signature(include_signature)
-        };
-        std::set<EntityId> excludes{
-            get_entities_by_signature(exclude_signature)
-        };
+        // a component that does not yet exist in the entity manager
+        // matches no entity
+        const bool should_terminate{ std::apply(
+        [](const auto*... m) { return ((m == nullptr) || ...); },
+        maps) };
+        if (should_terminate) {
+            return {};
+        }
 
-        auto in_excludes{ [&excludes](EntityId id) {
-            return excludes.contains(id);
-        } };
-        std::erase_if(includes, in_excludes);
+        const std::vector<const std::set<EntityId>*> buckets{
+            get_buckets(include_signature, exclude_signature)
+        };
 
         std::vector<typename Include::view_type> views{};
-        for (EntityId entity : includes) {
-            // get the view of a single entity
-            auto view{ std::apply(
-            [entity]<typename... Components>(njComponentMap<Components>*... map)
-            -> View<Components...> {
-                std::tuple<Components*...> components{
-                    std::make_tuple(map->get(entity)...)
-                };
-                return { entity, components };
-            },
-            maps) };
-            views.push_back(view);
+        for (const std::set<EntityId>* bucket : buckets) {
+            for (EntityId entity : *bucket) {
+                if (!enabled_[entity]) {
+                    continue;
+                }
+                // get the view of a single entity
+                auto view{ std::apply(
+                [entity]<typename... Components>(
+                njComponentMap<Components>*... map) -> View<Components...> {
+                    std::tuple<Components*...> components{
+                        std::make_tuple(map->get(entity)...)
+                    };
+                    return { entity, components };
+                },
+                maps) };
+                views.push_back(view);
+            }
         }
 
         return views;
     }
-}  // namespace njin::ecs
+
+    inline std::vector<std::string>
+    njEntityManager::get_component_names(ComponentSignature signature) const {
+        std::vector<std::string> names{};
+        for (int i{ 0 }; i < SIGNATURE_LENGTH; ++i) {
+            ComponentSignature bit{ 0b1 };
+            bit <<= i;
+            if ((signature & bit).none() || !signature_to_type_.contains(bit)) {
+                continue;
+            }
+            names.push_back(demangle(signature_to_type_.at(bit).name()));
+        }
+        return names;
+    }
+
+    inline njEntityManagerStats njEntityManager::get_stats() const {
+        njEntityManagerStats stats{ .entity_count = id_to_signature_.size() };
+
+        for (const auto& map : type_to_components_ | std::views::values) {
+            stats.components.push_back(map->get_stats());
+        }
+
+        for (const auto& [signature, entities] : signature_to_ids_) {
+            stats.signatures.push_back({ .signature = signature.to_ullong(),
+                                         .components =
+                                         get_component_names(signature),
+                                         .entity_count = entities.size(),
+                                         .bytes_reserved =
+                                         estimate_set_bytes(entities) });
+        }
+
+        stats.maps = { make_map_stats("type_to_components", type_to_components_),
+                       make_map_stats("name_to_id", name_to_id_),
+                       make_map_stats("type_to_signature", type_to_signature_),
+                       make_map_stats("signature_to_type", signature_to_type_),
+                       make_map_stats("id_to_signature", id_to_signature_),
+                       make_map_stats("signature_to_ids", signature_to_ids_) };
+
+        // the inverted index is a fixed array of one sorted list per bit
+        njMapStats bit_stats{ .name = "bit_to_signatures",
+                              .bucket_count = SIGNATURE_LENGTH,
+                              .bytes_reserved = sizeof(bit_to_signatures_) };
+        for (const auto& signatures : bit_to_signatures_) {
+            bit_stats.size += signatures.size();
+            bit_stats.bytes_reserved +=
+            signatures.capacity() * sizeof(ComponentSignature);
+        }
+        bit_stats.load_factor = static_cast<float>(bit_stats.size) /
+                                static_cast<float>(SIGNATURE_LENGTH);
+        stats.maps.push_back(bit_stats);
+
+        // one bit per entity id ever handed out
+        stats.maps.push_back({ .name = "enabled",
+                               .size = enabled_.size(),
+                               .bytes_reserved = sizeof(enabled_) +
+                                                 (enabled_.capacity() + 7) /
+                                                 8 });
+
+        return stats;
+    }
+
+    inline bool njEntityManager::compact(std::chrono::microseconds budget) {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point start{ Clock::now() };
+
+        // start a new pass
+        if (compaction_queue_.empty()) {
+            prune_signature_buckets();
+            for (const auto& [type, map] : type_to_components_) {
+                if (map->needs_compaction()) {
+                    compaction_queue_.push_back(type);
+                }
+            }
+        }
+
+        while (!compaction_queue_.empty()) {
+            const ComponentType type{ compaction_queue_.back() };
+            if (type_to_components_.at(type)->compact(COMPACTION_STEP)) {
+                compaction_queue_.pop_back();
+            }
+
+            if (Clock::now() - start >= budget) {
+                break;
+            }
+        }
+
+        return compaction_queue_.empty();
+    }
+
+    template<typename Component>
+    void njEntityManager::set_compaction_key(
+    typename njComponentMap<Component>::CompactionKey key) {
+        static_assert(!SharedComponent<Component>,
+                      "shared components are stored in a shared map");
+        make_component_map<njComponentMap<Component>>(typeid(Component))
+        ->set_compaction_key(std::move(key));
+    }
+
+    template<typename Component>
+    void njEntityManager::set_sort_key(
+    typename njComponentMap<Component>::SortKey key) {
+        static_assert(!SharedComponent<Component>,
+                      "shared components are stored in a shared map");
+        make_component_map<njComponentMap<Component>>(typeid(Component))
+        ->set_sort_key(std::move(key));
+    }
+
+    template<typename Component>
+    std::vector<njSortedIndex::Run> njEntityManager::get_sorted_runs() const {
+        njComponentMap<Component>* map{ get_component_map<Component>() };
+        if (!map || !map->get_sorted_index()) {
+            return {};
+        }
+        return map->get_sorted_index()->get_runs();
+    }
+
+    template<typename Component>
+    void njEntityManager::mark_changed(EntityId entity) const {
+        njComponentMap<Component>* map{ get_component_map<Component>() };
+        if (map) {
+            map->update_sort_key(entity);
+        }
+    }
+
+    inline void njEntityManager::prune_signature_buckets() {
+        // the bucket of entities without components is always kept,
+        // since queries for the zero signature look it up directly
+        std::erase_if(signature_to_ids_, [this](const auto& bucket) {
+            const auto& [signature, entities] = bucket;
+            if (signature.none() || !entities.empty()) {
+                return false;
+            }
+
+            // drop the bucket from the index too
+            for (int i{ 0 }; i < SIGNATURE_LENGTH; ++i) {
+                if (signature.test(i)) {
+                    std::erase(bit_to_signatures_[i], signature);
+                }
+            }
+            return true;
+        });
+    }
+}  // namespace njin::ecs
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace njin::ecs {
+    /**
+     * Memory and occupancy of the storage of a single component type
+     * @param name Readable name of the component type
+     * @param count Number of components stored
+     * @param component_size Size of a single component, in bytes
+     * @param bytes_used Bytes taken up by the components themselves
+     * @param bytes_reserved Bytes allocated by the storage, including
+     * bookkeeping. This is an estimate, since the layout of the underlying
+     * containers is implementation-defined.
+     * @param load_factor Live components per allocated storage slot,
+     * in [0, 1]
+     * @param fragmentation Fraction of storage slots that are holes left
+     * behind by removed components, in [0, 1]
+     */
+    struct njComponentStats {
+        std::string name{};
+        size_t count{ 0 };
+        size_t component_size{ 0 };
+        size_t bytes_used{ 0 };
+        size_t bytes_reserved{ 0 };
+        float load_factor{ 0.f };
+        float fragmentation{ 0.f };
+    };
+
+    /**
+     * Occupancy of a single signature bucket
+     * @param signature Component signature of the bucket
+     * @param components Names of the component types in the signature
+     * @param entity_count Number of entities in the bucket
+     * @param bytes_reserved Estimated bytes allocated by the bucket
+     */
+    struct njSignatureStats {
+        uint64_t signature{ 0 };
+        std::vector<std::string> components{};
+        size_t entity_count{ 0 };
+        size_t bytes_reserved{ 0 };
+    };
+
+    /**
+     * Memory and occupancy of one of the entity manager's bookkeeping maps
+     * @param name Name of the map
+     * @param size Number of elements
+     * @param bucket_count Number of buckets
+     * @param load_factor Average number of elements per bucket
+     * @param bytes_reserved Estimated bytes allocated by the map
+     */
+    struct njMapStats {
+        std::string name{};
+        size_t size{ 0 };
+        size_t bucket_count{ 0 };
+        float load_factor{ 0.f };
+        size_t bytes_reserved{ 0 };
+    };
+
+    /**
+     * Snapshot of the memory use of an entity manager
+     */
+    struct njEntityManagerStats {
+        size_t entity_count{ 0 };
+        std::vector<njComponentStats> components{};
+        std::vector<njSignatureStats> signatures{};
+        std::vector<njMapStats> maps{};
+
+        /**
+         * Serialize the snapshot
+         * @return JSON representation of the snapshot
+         */
+        std::string to_json() const;
+    };
+
+    /**
+     * Turn a type name as reported by typeid into one a person can read,
+     * e.g. N4njin3ecs16njMeshComponentE into njin::ecs::njMeshComponent
+     * @param name Type name as reported by typeid
+     * @return Demangled name, or the name as is if demangling is not
+     * supported or fails
+     */
+    std::string demangle(const char* name);
+
+    /**
+     * Estimate the bytes allocated by a node-based hash map: one node per
+     * element (value + next pointer) and one pointer per bucket
+     * @tparam Map Hash map type
+     * @param map Map to estimate for
+     * @return Estimated bytes allocated
+     */
+    template<typename Map>
+    size_t estimate_map_bytes(const Map& map) {
+        return map.size() *
+               (sizeof(typename Map::value_type) + sizeof(void*)) +
+               map.bucket_count() * sizeof(void*);
+    }
+
+    /**
+     * Estimate the bytes allocated by a node-based ordered set: one node per
+     * element (value + colour + parent/left/right pointers)
+     * @tparam Set Ordered set type
+     * @param set Set to estimate for
+     * @return Estimated bytes allocated
+     */
+    template<typename Set>
+    size_t estimate_set_bytes(const Set& set) {
+        return set.size() *
+               (sizeof(typename Set::value_type) + 4 * sizeof(void*));
+    }
+
+    /**
+     * Gather the stats of a hash map
+     * @tparam Map Hash map type
+     * @param name Name to report the map under
+     * @param map Map to gather stats for
+     * @return Stats of the map
+     */
+    template<typename Map>
+    njMapStats make_map_stats(const std::string& name, const Map& map) {
+        return { .name = name,
+                 .size = map.size(),
+                 .bucket_count = map.bucket_count(),
+                 .load_factor = map.load_factor(),
+                 .bytes_reserved = estimate_map_bytes(map) };
+    }
+}  // namespace njin::ecs
\ No newline at end of file
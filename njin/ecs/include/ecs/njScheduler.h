@@ -0,0 +1,114 @@
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "ecs/njTask.h"
+
+namespace njin::ecs {
+    /**
+     * Runs tasks that span multiple engine updates. Tasks only ever run
+     * inside spawn's first resume() and later resume() calls, on the thread
+     * calling resume(), so they can safely touch the same state systems do.
+     */
+    class njScheduler {
+        public:
+        // checked on every resume(), the task is resumed once it is true
+        using Condition = std::function<bool()>;
+
+        njScheduler() = default;
+
+        njScheduler(const njScheduler&) = delete;
+        njScheduler& operator=(const njScheduler&) = delete;
+
+        /**
+         * Take ownership of a task. The task starts on the next resume().
+         * @param task Task to run
+         */
+        void spawn(njTask<> task);
+
+        /**
+         * Suspend a coroutine until a condition holds. Used by awaitables.
+         * @param handle Coroutine to resume
+         * @param ready Condition to wait for. If empty, the coroutine is
+         * resumed on the next resume().
+         */
+        void wait(std::coroutine_handle<> handle, Condition ready);
+
+        /**
+         * Resume every task that was waiting before this call and is now
+         * ready. Tasks that suspend again while being resumed wait for the
+         * next call. Finished tasks are destroyed.
+         * @note Rethrows the first exception that escaped a spawned task
+         */
+        void resume();
+
+        /**
+         * @return Number of spawned tasks that have not finished
+         */
+        size_t get_task_count() const;
+
+        private:
+        struct Waiting {
+            std::coroutine_handle<> handle;
+            Condition ready;
+        };
+
+        std::vector<njTask<>> tasks_{};
+        std::vector<Waiting> waiting_{};
+    };
+
+    /**
+     * Awaitable that suspends a task until the next engine update
+     */
+    struct njNextTick {
+        bool await_ready() const noexcept;
+
+        template<typename Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle);
+
+        void await_resume() const noexcept;
+    };
+
+    /**
+     * Awaitable that suspends a task until an async job has finished
+     * @tparam T Result type of the job
+     */
+    template<typename T>
+    struct njFutureAwaiter {
+        std::future<T> future;
+
+        bool await_ready() const;
+
+        template<typename Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle);
+
+        T await_resume();
+    };
+
+    /**
+     * co_await to continue on the next engine update
+     */
+    njNextTick next_tick();
+
+    /**
+     * co_await to continue once a job has finished, with its result
+     * @param future Future of the job
+     */
+    template<typename T>
+    njFutureAwaiter<T> when_ready(std::future<T> future);
+
+    /**
+     * co_await to read a whole file on a worker thread, continuing with its
+     * contents once it has been read
+     * @param path Path of the file
+     * @note Awaiting throws std::runtime_error if the file cannot be read
+     */
+    njFutureAwaiter<std::string> read_file_async(std::filesystem::path path);
+}  // namespace njin::ecs
+
+#include "ecs/njScheduler.tpp"
\ No newline at end of file
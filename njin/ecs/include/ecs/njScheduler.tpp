@@ -0,0 +1,44 @@
+#pragma once
+
+namespace njin::ecs {
+    inline bool njNextTick::await_ready() const noexcept {
+        return false;
+    }
+
+    template<typename Promise>
+    void njNextTick::await_suspend(std::coroutine_handle<Promise> handle) {
+        handle.promise().scheduler->wait(handle, {});
+    }
+
+    inline void njNextTick::await_resume() const noexcept {}
+
+    template<typename T>
+    bool njFutureAwaiter<T>::await_ready() const {
+        return future.wait_for(std::chrono::seconds{ 0 }) ==
+               std::future_status::ready;
+    }
+
+    template<typename T>
+    template<typename Promise>
+    void
+    njFutureAwaiter<T>::await_suspend(std::coroutine_handle<Promise> handle) {
+        // the awaiter lives in the suspended coroutine's frame, so it
+        // outlives the wait
+        handle.promise().scheduler->wait(handle,
+                                         [this] { return await_ready(); });
+    }
+
+    template<typename T>
+    T njFutureAwaiter<T>::await_resume() {
+        return future.get();
+    }
+
+    inline njNextTick next_tick() {
+        return {};
+    }
+
+    template<typename T>
+    njFutureAwaiter<T> when_ready(std::future<T> future) {
+        return { std::move(future) };
+    }
+}  // namespace njin::ecs
\ No newline at end of file
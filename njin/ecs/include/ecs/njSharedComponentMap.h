@@ -0,0 +1,185 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "ecs/njComponentMapInterface.h"
+
+namespace njin::ecs {
+    /**
+     * Tag naming the shared variant of a component type. Shared components
+     * have their own signature bit, separate from the regular component of
+     * the same type, e.g. to exclude them in queries:
+     * Exclude<njShared<njMeshComponent>>
+     * Their values are read through get_shared_component or
+     * get_shared_groups, not through views.
+     * @tparam Component Component type
+     */
+    template<typename Component>
+    struct njShared {
+        using component_type = Component;
+    };
+
+    template<typename T>
+    struct is_shared_component : std::false_type {};
+
+    template<typename Component>
+    struct is_shared_component<njShared<Component>> : std::true_type {};
+
+    /**
+     * A njShared tag. Shared components are not stored in a regular
+     * component map, so they can only be named in Exclude, has_components
+     * and the *_shared_component functions.
+     */
+    template<typename T>
+    concept SharedComponent = is_shared_component<T>::value;
+
+    using SharedGroupId = uint32_t;
+
+    /**
+     * All entities that share a single component value
+     * @param id Id of the group
+     * @param value Shared value
+     * @param entities Entities in the group
+     * @note Invalidated when shared components of this type are added,
+     * removed or modified
+     */
+    template<typename Component>
+    struct njSharedGroup {
+        SharedGroupId id;
+        const Component* value;
+        const std::set<uint32_t>* entities;
+    };
+
+    /**
+     * Storage of shared components of a single type. Entities are grouped
+     * by value: every group holds one immutable value that all of its
+     * entities refer to. Modifying the value of one entity copies it into a
+     * new group first (copy-on-write), leaving the rest of the group as is.
+     * Groups are indexed by a hash of their value, so finding the group of
+     * a value does not depend on how many groups there are. Values are
+     * hashed with std::hash if it is specialized for the component, and by
+     * their bytes otherwise.
+     * @tparam Component Component type
+     */
+    template<typename Component>
+    class njSharedComponentMap : public njComponentMapInterface {
+        static_assert(std::equality_comparable<Component>,
+                      "shared components are grouped by value");
+
+        public:
+        using EntityId = uint32_t;
+
+        void remove(EntityId entity) override;
+
+        /**
+         * Make a new group
+         * @param value Value shared by the group
+         * @return Id of the group
+         */
+        SharedGroupId add_group(const Component& value);
+
+        /**
+         * Find a group sharing a given value, making one if there is none
+         * @param value Value to look for
+         * @return Id of the group
+         */
+        SharedGroupId find_group(const Component& value);
+
+        /**
+         * Add an entity to a group. An entity already in a group is
+         * left as is.
+         * @param entity Entity to add
+         * @param group Group to add the entity to
+         */
+        void insert(EntityId entity, SharedGroupId group);
+
+        /**
+         * Read the shared value of an entity
+         * @param entity Entity to read the value of
+         * @return Shared value
+         */
+        const Component* get(EntityId entity) const;
+
+        /**
+         * Get a modifiable value of an entity. If the value is shared with
+         * other entities, the entity is moved into a copy of its group first.
+         * Once modified, the group is merged into an existing group with an
+         * equal value by the next find_group, get_mutable or compact.
+         * @param entity Entity to get the value of
+         * @return Value that only this entity refers to
+         * @note The value is only valid until the next call to
+         * find_group, get_mutable or compact
+         */
+        Component* get_mutable(EntityId entity);
+
+        /**
+         * @return All groups, in ascending group id order
+         */
+        std::vector<njSharedGroup<Component>> get_groups() const;
+
+        njComponentStats get_stats() const override;
+
+        bool needs_compaction() const override;
+
+        bool compact(size_t work) override;
+
+        private:
+        struct Group {
+            Component value;
+            std::set<EntityId> entities;
+
+            // hash the group is indexed under
+            size_t hash;
+        };
+
+        std::unordered_map<SharedGroupId, Group> groups_{};
+        std::unordered_map<EntityId, SharedGroupId> entity_to_group_{};
+
+        // groups by the hash of their value
+        std::unordered_map<size_t, std::vector<SharedGroupId>>
+        hash_to_groups_{};
+
+        // groups handed out by get_mutable, whose value may have changed
+        // since they were indexed
+        std::vector<SharedGroupId> modified_groups_{};
+
+        // groups made by add_group / find_group that never got an entity
+        size_t empty_groups_{ 0 };
+
+        SharedGroupId next_group_{ 0 };
+
+        /**
+         * @param value Value to hash
+         * @return Hash of the value
+         */
+        static size_t hash_value(const Component& value);
+
+        /**
+         * @param value Value to look for
+         * @param ignore Group to skip
+         * @return Id of an indexed group with an equal value, if any
+         */
+        std::optional<SharedGroupId> find_indexed(const Component& value,
+                                                  SharedGroupId ignore) const;
+
+        /**
+         * Drop a group and remove it from the index
+         * @param id Id of the group
+         */
+        void erase_group(SharedGroupId id);
+
+        /**
+         * Re-index the groups handed out by get_mutable under their current
+         * value, merging each into an existing group with an equal value
+         */
+        void merge_modified_groups();
+    };
+}  // namespace njin::ecs
+
+#include "ecs/njSharedComponentMap.tpp"
\ No newline at end of file
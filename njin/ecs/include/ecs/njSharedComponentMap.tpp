@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <functional>
+#include <ranges>
+#include <typeinfo>
+
+namespace njin::ecs {
+    template<typename Component>
+    void njSharedComponentMap<Component>::remove(EntityId entity) {
+        if (!entity_to_group_.contains(entity)) {
+            return;
+        }
+
+        const SharedGroupId id{ entity_to_group_.at(entity) };
+        entity_to_group_.erase(entity);
+
+        Group& group{ groups_.at(id) };
+        group.entities.erase(entity);
+        if (group.entities.empty()) {
+            erase_group(id);
+        }
+    }
+
+    template<typename Component>
+    SharedGroupId njSharedComponentMap<Component>::add_group(
+    const Component& value) {
+        const SharedGroupId id{ next_group_ };
+        ++next_group_;
+        const size_t hash{ hash_value(value) };
+        groups_.insert({ id, Group{ value, {}, hash } });
+        hash_to_groups_[hash].push_back(id);
+        ++empty_groups_;
+
+        return id;
+    }
+
+    template<typename Component>
+    SharedGroupId njSharedComponentMap<Component>::find_group(
+    const Component& value) {
+        merge_modified_groups();
+        const std::optional<SharedGroupId> id{
+            find_indexed(value, next_group_)
+        };
+        if (id) {
+            return *id;
+        }
+        return add_group(value);
+    }
+
+    template<typename Component>
+    void njSharedComponentMap<Component>::insert(EntityId entity,
+                                                 SharedGroupId group) {
+        if (entity_to_group_.contains(entity)) {
+            return;
+        }
+
+        std::set<EntityId>& entities{ groups_.at(group).entities };
+        if (entities.empty()) {
+            --empty_groups_;
+        }
+        entities.insert(entity);
+        entity_to_group_.insert({ entity, group });
+    }
+
+    template<typename Component>
+    const Component* njSharedComponentMap<Component>::get(
+    EntityId entity) const {
+        return &groups_.at(entity_to_group_.at(entity)).value;
+    }
+
+    template<typename Component>
+    Component* njSharedComponentMap<Component>::get_mutable(EntityId entity) {
+        merge_modified_groups();
+
+        const SharedGroupId id{ entity_to_group_.at(entity) };
+        Group& group{ groups_.at(id) };
+        if (group.entities.size() == 1) {
+            // sole owner, nothing to copy
+            modified_groups_.push_back(id);
+            return &group.value;
+        }
+
+        // copy on write: detach the entity into its own group
+        const SharedGroupId copy{ add_group(group.value) };
+        group.entities.erase(entity);
+        Group& detached{ groups_.at(copy) };
+        detached.entities.insert(entity);
+        --empty_groups_;
+        entity_to_group_.at(entity) = copy;
+        modified_groups_.push_back(copy);
+
+        return &detached.value;
+    }
+
+    template<typename Component>
+    std::vector<njSharedGroup<Component>>
+    njSharedComponentMap<Component>::get_groups() const {
+        std::vector<njSharedGroup<Component>> groups{};
+        groups.reserve(groups_.size());
+        for (const auto& [id, group] : groups_) {
+            if (group.entities.empty()) {
+                continue;
+            }
+            groups.push_back({ id, &group.value, &group.entities });
+        }
+        std::ranges::sort(groups, {}, &njSharedGroup<Component>::id);
+
+        return groups;
+    }
+
+    template<typename Component>
+    njComponentStats njSharedComponentMap<Component>::get_stats() const {
+        const size_t count{ entity_to_group_.size() };
+
+        // only one copy of each value is stored
+        const size_t bytes_used{ groups_.size() * sizeof(Component) };
+        size_t bytes_reserved{ estimate_map_bytes(groups_) +
+                               estimate_map_bytes(entity_to_group_) +
+                               estimate_map_bytes(hash_to_groups_) +
+                               modified_groups_.capacity() *
+                               sizeof(SharedGroupId) };
+        for (const Group& group : groups_ | std::views::values) {
+            bytes_reserved += estimate_set_bytes(group.entities);
+        }
+        for (const auto& bucket : hash_to_groups_ | std::views::values) {
+            bytes_reserved += bucket.capacity() * sizeof(SharedGroupId);
+        }
+
+        float load_factor{ 0.f };
+        float fragmentation{ 0.f };
+        if (!groups_.empty()) {
+            // values are always packed, so the only waste is empty groups
+            // made by find_group / add_group that never got an entity
+            load_factor = static_cast<float>(groups_.size() - empty_groups_) /
+                          static_cast<float>(groups_.size());
+            fragmentation = static_cast<float>(empty_groups_) /
+                            static_cast<float>(groups_.size());
+        }
+
+        return { .name = demangle(typeid(njShared<Component>).name()),
+                 .count = count,
+                 .component_size = sizeof(Component),
+                 .bytes_used = bytes_used,
+                 .bytes_reserved = bytes_reserved,
+                 .load_factor = load_factor,
+                 .fragmentation = fragmentation };
+    }
+
+    template<typename Component>
+    bool njSharedComponentMap<Component>::needs_compaction() const {
+        return !modified_groups_.empty() || empty_groups_ > 0;
+    }
+
+    template<typename Component>
+    bool njSharedComponentMap<Component>::compact(size_t) {
+        // one value per group, so a pass is cheap enough to do at once
+        merge_modified_groups();
+
+        std::vector<SharedGroupId> empty{};
+        for (const auto& [id, group] : groups_) {
+            if (group.entities.empty()) {
+                empty.push_back(id);
+            }
+        }
+        for (SharedGroupId id : empty) {
+            erase_group(id);
+        }
+        groups_.rehash(0);
+        entity_to_group_.rehash(0);
+        hash_to_groups_.rehash(0);
+
+        return true;
+    }
+
+    template<typename Component>
+    size_t njSharedComponentMap<Component>::hash_value(
+    const Component& value) {
+        if constexpr (requires { std::hash<Component>{}(value); }) {
+            return std::hash<Component>{}(value);
+        } else {
+            static_assert(std::is_trivially_copyable_v<Component>,
+                          "specialize std::hash to share this component");
+            // FNV-1a over the bytes of the value. Equal values with
+            // different bytes (e.g. 0.f and -0.f) just end up in separate
+            // groups.
+            const auto* bytes{ reinterpret_cast<const unsigned char*>(
+            &value) };
+            uint64_t hash{ 14695981039346656037ull };
+            for (size_t i{ 0 }; i < sizeof(Component); ++i) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    }
+
+    template<typename Component>
+    std::optional<SharedGroupId>
+    njSharedComponentMap<Component>::find_indexed(const Component& value,
+                                                  SharedGroupId ignore) const {
+        const auto bucket{ hash_to_groups_.find(hash_value(value)) };
+        if (bucket == hash_to_groups_.end()) {
+            return std::nullopt;
+        }
+        for (SharedGroupId id : bucket->second) {
+            if (id != ignore && groups_.at(id).value == value) {
+                return id;
+            }
+        }
+        return std::nullopt;
+    }
+
+    template<typename Component>
+    void njSharedComponentMap<Component>::erase_group(SharedGroupId id) {
+        const Group& group{ groups_.at(id) };
+        if (group.entities.empty()) {
+            --empty_groups_;
+        }
+
+        std::vector<SharedGroupId>& bucket{ hash_to_groups_.at(group.hash) };
+        std::erase(bucket, id);
+        if (bucket.empty()) {
+            hash_to_groups_.erase(group.hash);
+        }
+        groups_.erase(id);
+    }
+
+    template<typename Component>
+    void njSharedComponentMap<Component>::merge_modified_groups() {
+        for (SharedGroupId id : modified_groups_) {
+            // merged or removed since it was handed out
+            if (!groups_.contains(id)) {
+                continue;
+            }
+
+            Group& group{ groups_.at(id) };
+            const size_t hash{ hash_value(group.value) };
+            const std::optional<SharedGroupId> equal{
+                find_indexed(group.value, id)
+            };
+            if (equal) {
+                // equal to an existing group again, join it
+                Group& target{ groups_.at(*equal) };
+                for (EntityId entity : group.entities) {
+                    target.entities.insert(entity);
+                    entity_to_group_.at(entity) = *equal;
+                }
+                group.entities.clear();
+                ++empty_groups_;
+                erase_group(id);
+            } else if (hash != group.hash) {
+                std::vector<SharedGroupId>& bucket{
+                    hash_to_groups_.at(group.hash)
+                };
+                std::erase(bucket, id);
+                if (bucket.empty()) {
+                    hash_to_groups_.erase(group.hash);
+                }
+                group.hash = hash;
+                hash_to_groups_[hash].push_back(id);
+            }
+        }
+        modified_groups_.clear();
+    }
+}  // namespace njin::ecs
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace njin::ecs {
+    /**
+     * Entities kept sorted by a key, e.g. (mesh, texture) or spatial cell.
+     * Entities with equal keys are contiguous, and within a run entities
+     * are in ascending order. The index is updated one entity at a time
+     * as keys change, so it never has to be re-sorted as a whole.
+     */
+    class njSortedIndex {
+        public:
+        using EntityId = uint32_t;
+        using Key = uint64_t;
+
+        /**
+         * All entities with the same key
+         * @param key Key of the run
+         * @param entities Entities in the run, ascending
+         * @note Invalidated by any change to the index
+         */
+        struct Run {
+            Key key;
+            std::span<const EntityId> entities;
+        };
+
+        /**
+         * Add an entity to the index. An entity already in the index has
+         * its key updated instead.
+         * @param entity Entity to add
+         * @param key Key of the entity
+         */
+        void insert(EntityId entity, Key key);
+
+        /**
+         * Remove an entity from the index
+         * @param entity Entity to remove
+         */
+        void remove(EntityId entity);
+
+        /**
+         * Change the key of an entity, moving it to its new run
+         * @param entity Entity to update
+         * @param key New key of the entity
+         * @note Does nothing if the key did not change
+         */
+        void update(EntityId entity, Key key);
+
+        bool contains(EntityId entity) const;
+
+        size_t size() const;
+
+        /**
+         * @return All entities, sorted by key then by entity
+         */
+        std::span<const EntityId> get_entities() const;
+
+        /**
+         * @return One run per distinct key, in ascending key order
+         */
+        std::vector<Run> get_runs() const;
+
+        private:
+        // parallel arrays sorted by (key, entity), so that the entities of
+        // a run are contiguous
+        std::vector<Key> keys_{};
+        std::vector<EntityId> entities_{};
+
+        std::unordered_map<EntityId, Key> entity_to_key_{};
+
+        /**
+         * Find the position of an entry
+         * @param entity Entity of the entry
+         * @param key Key of the entry
+         * @return Index of the first entry not ordered before (key, entity)
+         */
+        size_t lower_bound(EntityId entity, Key key) const;
+    };
+}  // namespace njin::ecs
\ No newline at end of file
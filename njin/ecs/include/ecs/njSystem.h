@@ -1,7 +1,11 @@
 #pragma once
+#include <chrono>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 #include "njEntityManager.h"
+#include "njScheduler.h"
 
 namespace njin::ecs {
     enum class TickGroup : uint8_t {
@@ -14,6 +18,8 @@ namespace njin::ecs {
 
     class njSystem {
         public:
+        using Budget = std::chrono::microseconds;
+
         virtual ~njSystem() = default;
 
         njSystem(TickGroup group);
@@ -21,9 +27,79 @@ namespace njin::ecs {
 
         virtual void update(const ecs::njEntityManager& entity_manager) = 0;
 
+        /**
+         * Run this system in time-sliced mode. Each update only processes
+         * as many query results as fit in the budget, and the next update
+         * resumes from where the previous one stopped.
+         * @param budget Time budget of a single update
+         * @note At least one query result is processed every update, so
+         * a pass always makes progress even with a zero budget
+         */
+        void set_time_budget(Budget budget);
+
+        /**
+         * Leave time-sliced mode, so that every update processes all
+         * query results (the default)
+         */
+        void clear_time_budget();
+
+        /**
+         * @return True if this system runs in time-sliced mode
+         */
+        bool is_time_sliced() const;
+
+        /**
+         * Get the number of slices (updates) the last completed pass over
+         * the query results needed
+         * @return Number of slices. This is 0 if no pass has completed yet.
+         */
+        uint32_t get_slice_count() const;
+
         protected:
         TickGroup tick_group_;
 
+        /**
+         * Apply a function to a list of query results. In time-sliced mode
+         * this stops once the time budget has been used up, and the next call
+         * resumes at the first unprocessed result.
+         * @tparam View Type of a single query result
+         * @tparam Function Callable taking a const View&
+         * @param views Query results
+         * @param function Function to apply to each query result
+         * @return True if this call finished a pass over the query results
+         * @note The cursor is an index into the query results, so entities
+         * added or removed in the middle of a pass may shift it
+         */
+        template<typename View, typename Function>
+        bool for_each_sliced(const std::vector<View>& views,
+                             Function&& function);
+
+        /**
+         * Start a task that can wait across updates, e.g. on a file read or
+         * a job. The engine resumes it at the start of its updates.
+         * Views must be fetched again after every co_await, @see njTask.
+         * @param task Task to start
+         * @throws std::logic_error if the system was not added to an engine
+         */
+        void spawn(njTask<> task);
+
         private:
+        friend class njEngine;
+
+        // scheduler of the engine this system was added to
+        njScheduler* scheduler_{ nullptr };
+
+        std::optional<Budget> budget_{};
+
+        // index of the next query result to process
+        size_t cursor_{ 0 };
+
+        // slices used so far by the pass in progress
+        uint32_t current_slices_{ 0 };
+
+        // slices used by the last completed pass
+        uint32_t last_slices_{ 0 };
     };
-}  // namespace njin::ecs
\ No newline at end of file
+}  // namespace njin::ecs
+
+#include "ecs/njSystem.tpp"
\ No newline at end of file
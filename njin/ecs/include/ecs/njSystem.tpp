@@ -0,0 +1,35 @@
+#pragma once
+
+namespace njin::ecs {
+    template<typename View, typename Function>
+    bool njSystem::for_each_sliced(const std::vector<View>& views,
+                                   Function&& function) {
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point start{ Clock::now() };
+        ++current_slices_;
+
+        // the query results may have shrunk since the last slice
+        if (cursor_ > views.size()) {
+            cursor_ = views.size();
+        }
+
+        while (cursor_ < views.size()) {
+            function(views[cursor_]);
+            ++cursor_;
+
+            if (budget_ && Clock::now() - start >= *budget_) {
+                break;
+            }
+        }
+
+        if (cursor_ < views.size()) {
+            return false;
+        }
+
+        // pass complete, the next call starts over
+        last_slices_ = current_slices_;
+        current_slices_ = 0;
+        cursor_ = 0;
+        return true;
+    }
+}  // namespace njin::ecs
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+namespace njin::ecs {
+    class njScheduler;
+
+    /**
+     * State shared by the promises of all tasks
+     */
+    struct njTaskPromiseBase {
+        // scheduler that resumes the task whenever it waits on something
+        njScheduler* scheduler{ nullptr };
+
+        // task awaiting this one, resumed once this one finishes
+        std::coroutine_handle<> continuation{};
+
+        std::exception_ptr exception{};
+
+        /**
+         * Transfers control to the awaiting task, if any, when a task
+         * finishes
+         */
+        struct FinalAwaiter {
+            bool await_ready() noexcept;
+
+            template<typename Promise>
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<Promise> handle) noexcept;
+
+            void await_resume() noexcept;
+        };
+
+        // tasks start when they are spawned or awaited, not when called
+        std::suspend_always initial_suspend() noexcept;
+
+        FinalAwaiter final_suspend() noexcept;
+
+        void unhandled_exception();
+    };
+
+    template<typename T>
+    class njTask;
+
+    template<typename T>
+    struct njTaskPromise : njTaskPromiseBase {
+        std::optional<T> value{};
+
+        njTask<T> get_return_object();
+
+        void return_value(T result);
+    };
+
+    template<>
+    struct njTaskPromise<void> : njTaskPromiseBase {
+        njTask<void> get_return_object();
+
+        void return_void();
+    };
+
+    /**
+     * A coroutine that can suspend across engine updates. A task does not
+     * run until it is spawned on a scheduler (@see njScheduler::spawn) or
+     * awaited by another task, and it can co_await:
+     * - other tasks, resuming with their result
+     * - next_tick(), resuming on the next engine update
+     * - when_ready(future), resuming once an async job has finished
+     * - read_file_async(path), resuming with the contents of a file
+     * @tparam T Type of the result of the task
+     * @note Views must not be held across a suspension. Storage may be
+     * compacted at the end of every update (@see
+     * njEngine::set_compaction_budget), which moves components, so views
+     * have to be fetched again after each co_await.
+     */
+    template<typename T = void>
+    class njTask {
+        public:
+        using promise_type = njTaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        njTask() = default;
+
+        explicit njTask(Handle handle);
+
+        njTask(const njTask&) = delete;
+        njTask& operator=(const njTask&) = delete;
+
+        njTask(njTask&& other) noexcept;
+        njTask& operator=(njTask&& other) noexcept;
+
+        ~njTask();
+
+        /**
+         * @return True if the task ran to completion (or threw)
+         */
+        bool is_done() const;
+
+        Handle get_handle() const;
+
+        // awaiting a task starts it, and resumes the awaiting task with its
+        // result once it finishes
+        bool await_ready() const noexcept;
+
+        template<typename Promise>
+        std::coroutine_handle<>
+        await_suspend(std::coroutine_handle<Promise> awaiting) noexcept;
+
+        T await_resume();
+
+        private:
+        Handle handle_{};
+    };
+}  // namespace njin::ecs
+
+#include "ecs/njTask.tpp"
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+
+namespace njin::ecs {
+    inline bool njTaskPromiseBase::FinalAwaiter::await_ready() noexcept {
+        return false;
+    }
+
+    template<typename Promise>
+    std::coroutine_handle<> njTaskPromiseBase::FinalAwaiter::await_suspend(
+    std::coroutine_handle<Promise> handle) noexcept {
+        std::coroutine_handle<> continuation{ handle.promise().continuation };
+        if (continuation) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+    inline void njTaskPromiseBase::FinalAwaiter::await_resume() noexcept {}
+
+    inline std::suspend_always njTaskPromiseBase::initial_suspend() noexcept {
+        return {};
+    }
+
+    inline njTaskPromiseBase::FinalAwaiter
+    njTaskPromiseBase::final_suspend() noexcept {
+        return {};
+    }
+
+    inline void njTaskPromiseBase::unhandled_exception() {
+        exception = std::current_exception();
+    }
+
+    template<typename T>
+    njTask<T> njTaskPromise<T>::get_return_object() {
+        return njTask<T>{ njTask<T>::Handle::from_promise(*this) };
+    }
+
+    template<typename T>
+    void njTaskPromise<T>::return_value(T result) {
+        value = std::move(result);
+    }
+
+    inline njTask<void> njTaskPromise<void>::get_return_object() {
+        return njTask<void>{ njTask<void>::Handle::from_promise(*this) };
+    }
+
+    inline void njTaskPromise<void>::return_void() {}
+
+    template<typename T>
+    njTask<T>::njTask(Handle handle) : handle_{ handle } {}
+
+    template<typename T>
+    njTask<T>::njTask(njTask&& other) noexcept :
+        handle_{ std::exchange(other.handle_, {}) } {}
+
+    template<typename T>
+    njTask<T>& njTask<T>::operator=(njTask&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    template<typename T>
+    njTask<T>::~njTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    template<typename T>
+    bool njTask<T>::is_done() const {
+        return !handle_ || handle_.done();
+    }
+
+    template<typename T>
+    typename njTask<T>::Handle njTask<T>::get_handle() const {
+        return handle_;
+    }
+
+    template<typename T>
+    bool njTask<T>::await_ready() const noexcept {
+        return is_done();
+    }
+
+    template<typename T>
+    template<typename Promise>
+    std::coroutine_handle<>
+    njTask<T>::await_suspend(std::coroutine_handle<Promise> awaiting) noexcept {
+        // the awaited task waits on the same scheduler as its parent
+        handle_.promise().scheduler = awaiting.promise().scheduler;
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    template<typename T>
+    T njTask<T>::await_resume() {
+        promise_type& promise{ handle_.promise() };
+        if (promise.exception) {
+            std::rethrow_exception(promise.exception);
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*promise.value);
+        }
+    }
+}  // namespace njin::ecs
\ No newline at end of file
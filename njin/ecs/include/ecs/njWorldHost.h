@@ -0,0 +1,110 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ecs/njEngine.h"
+#include "physics/ThreadPool.h"
+
+namespace njin::ecs {
+    /**
+     * Hosts many independent worlds (engines) in a single process.
+     * Worlds are distributed round-robin over a fixed number of shards,
+     * and each shard updates its worlds in order on its own worker thread.
+     * Worlds never share mutable state with each other, so the only
+     * synchronisation needed is at the start and the end of
+     * njWorldHost::update. Asset registries are only read while updating,
+     * so one set can be shared by reference between all hosted worlds.
+     * The host also owns one thread pool for the parallel work inside
+     * worlds, such as physics, so that the number of threads does not grow
+     * with the number of worlds.
+     */
+    class njWorldHost {
+        public:
+        /**
+         * Constructor
+         * @param shard_count Number of shards (worker threads). Must be at
+         * least 1.
+         * @param pool_thread_count Number of threads of the shared thread
+         * pool. 0 picks the number of hardware threads.
+         */
+        explicit njWorldHost(uint32_t shard_count,
+                             uint32_t pool_thread_count = 0);
+
+        njWorldHost(const njWorldHost&) = delete;
+        njWorldHost& operator=(const njWorldHost&) = delete;
+
+        /**
+         * Stops and joins all worker threads
+         */
+        ~njWorldHost();
+
+        /**
+         * Add a world to the host
+         * @param world World to add
+         * @return Index of the world
+         * @note Must not be called while an update is in progress
+         */
+        size_t add_world(std::unique_ptr<njEngine> world);
+
+        /**
+         * Get a world that was added to the host
+         * @param index Index of the world
+         * @return World
+         */
+        njEngine& get_world(size_t index);
+
+        size_t get_world_count() const;
+
+        uint32_t get_shard_count() const;
+
+        /**
+         * @return Thread pool to hand to the systems of hosted worlds,
+         * @see nj3DPhysicsSystem
+         */
+        std::shared_ptr<physics::ThreadPool> get_thread_pool() const;
+
+        /**
+         * Update every world once. Shards update in parallel, and this
+         * blocks until all of them are done.
+         * @note If any world throws, the other worlds still finish their
+         * update, then the first exception is rethrown here
+         */
+        void update();
+
+        private:
+        std::vector<std::unique_ptr<njEngine>> worlds_{};
+
+        // worlds updated by each shard
+        std::vector<std::vector<njEngine*>> shard_worlds_{};
+
+        std::vector<std::thread> workers_{};
+
+        std::shared_ptr<physics::ThreadPool> pool_;
+
+        std::mutex mutex_{};
+        std::condition_variable start_{};
+        std::condition_variable done_{};
+
+        // incremented once per update to wake the workers
+        uint64_t generation_{ 0 };
+
+        // number of shards that have not finished the current update
+        uint32_t pending_{ 0 };
+
+        bool stopping_{ false };
+
+        // first exception thrown by a world during the current update
+        std::exception_ptr exception_{};
+
+        /**
+         * Worker loop of a single shard
+         * @param shard Index of the shard
+         */
+        void run_shard(size_t shard);
+    };
+}  // namespace njin::ecs
\ No newline at end of file
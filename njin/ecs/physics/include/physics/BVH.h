@@ -1,17 +1,62 @@
 #pragma once
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
 #include "physics/BVHNode.h"
-
-#include <set>
+#include "physics/Sweep.h"
+#include "physics/ThreadPool.h"
 
 namespace njin::ecs::physics {
 
+    enum class BVHBuilder : uint8_t {
+        Median,    // split at the median centroid along the widest axis
+        BinnedSAH,  // split at the cheapest of a set of binned candidates
+        // sort the centroids along a Morton curve and split where their
+        // codes first differ (LBVH). Much faster to build than the other
+        // builders, at the cost of a somewhat worse tree, so it suits
+        // rebuilding every tick.
+        Morton
+    };
+
+    /**
+     * What the surface area heuristic optimises the tree for
+     */
+    enum class SAHCost : uint8_t {
+        // the chance a box query visits a node grows with the volume of
+        // the node grown by the size of an average primitive
+        Overlap,
+        // the chance a ray visits a node grows with its surface area
+        Ray
+    };
+
+    /**
+     * Build settings of a BVH
+     * @param builder Partitioning strategy
+     * @param cost Query type to optimise for (BinnedSAH only)
+     * @param bin_count Number of bins per axis (BinnedSAH only)
+     * @param max_leaf_size Largest number of primitives the BinnedSAH
+     * builder may keep in one leaf when splitting is not worth it. The
+     * median and Morton builders always make leaves of a single primitive.
+     * @param traversal_cost Cost of testing a node, relative to
+     * intersection_cost
+     * @param intersection_cost Cost of testing a primitive
+     */
+    struct BVHBuildOptions {
+        BVHBuilder builder{ BVHBuilder::Median };
+        SAHCost cost{ SAHCost::Overlap };
+        uint32_t bin_count{ 16 };
+        uint32_t max_leaf_size{ 4 };
+        float traversal_cost{ 1.f };
+        float intersection_cost{ 1.f };
+    };
+
     /**
      * A binary Bounding Volume Hierarchy implementation. A "primitive" refers
      * to the unit of a BVH, an abstract representation of real rigid bodies
      * by a single bounding box around a centroid. For now, only AABBs are supported.
+     * Nodes are stored in a single contiguous array, with the root at index
+     * 0, and leaves refer to primitives through a separate index array.
      */
     class BVH {
         public:
@@ -21,19 +66,96 @@ namespace njin::ecs::physics {
          * @param type The axes the BVH should be concerned with. For example,
          * if we don't care about interactions along the Y-axis (i.e., for
          * all practical purposes our bounding box is 2D), then we specify
-         * BVHType::XYZ
+         * BVHType::XZ
+         * @param options Build settings
          */
         explicit BVH(const std::vector<Primitive>& primitives,
-                     BoundingBoxType type = BoundingBoxType::XYZ);
+                     BoundingBoxType type = BoundingBoxType::XYZ,
+                     const BVHBuildOptions& options = {});
+
+        /**
+         * Constructor that builds the BVH on a thread pool. The top levels
+         * are split one level at a time. While a level has fewer nodes
+         * than threads, each node's bounds, bins, median and partition are
+         * computed across all threads; after that the nodes of a level are
+         * split in parallel, and the subtrees below them are built as
+         * independent tasks. The result is identical to the serial build.
+         * @param primitives List of primitives to form the BVH with
+         * @param type The axes the BVH should be concerned with
+         * @param options Build settings
+         * @param pool Thread pool to build on
+         */
+        BVH(const std::vector<Primitive>& primitives,
+            BoundingBoxType type,
+            const BVHBuildOptions& options,
+            ThreadPool& pool);
 
+        /**
+         * @return Root node, or nullptr if the BVH is empty
+         */
         const BVHNode* get_root() const;
 
+        /**
+         * @return All nodes, root first
+         */
+        const std::vector<BVHNode>& get_nodes() const;
+
+        /**
+         * @return All primitives, in the order they were given
+         */
+        const std::vector<Primitive>& get_primitives() const;
+
+        /**
+         * @return Indices into the primitives, which leaves refer to
+         * contiguous ranges of
+         */
+        const std::vector<uint32_t>& get_primitive_indices() const;
+
+        /**
+         * @param node Node of this BVH
+         * @return Left child of the node, or nullptr if it is a leaf
+         */
+        const BVHNode* get_left(const BVHNode& node) const;
+
+        /**
+         * @param node Node of this BVH
+         * @return Right child of the node, or nullptr if it is a leaf
+         */
+        const BVHNode* get_right(const BVHNode& node) const;
+
+        /**
+         * Retrieve the list of entities beneath a node
+         * @param node Node of this BVH
+         * @return List of entity ids
+         */
+        std::vector<EntityId> get_entities(const BVHNode& node) const;
+
+        /**
+         * @param entity Entity to check for
+         * @return True if the entity is in the BVH
+         */
+        bool contains(EntityId entity) const;
+
+        /**
+         * @return Number of entities in the BVH
+         */
+        size_t size() const;
+
         /**
          * Retrieve the list of entities in the BVH
          * @return List of entity ids
          */
         std::vector<EntityId> get_entities() const;
 
+        /**
+         * Checks if the bounding boxes of two nodes overlap, along the axes
+         * this BVH is concerned with
+         * @param a First node
+         * @param b Second node
+         * @return True if both nodes overlap
+         */
+        bool does_overlap(const BVHNode& a, const BVHNode& b) const;
+
         /**
          * Returns a list of entities that overlap a given entity
          * @param entity Entity to test overlaps for
@@ -41,6 +163,30 @@ namespace njin::ecs::physics {
          */
         std::vector<EntityId> get_overlaps(EntityId entity) const;
 
+        /**
+         * Returns a list of entities that overlap a given bounding box
+         * @param box Bounding box to test overlaps for
+         * @return List of overlapping entities
+         */
+        std::vector<EntityId> get_overlaps(const BoundingBox& box) const;
+
+        /**
+         * Find the entities a bounding box moving along a displacement
+         * hits, descending only into nodes the box passes through, nearer
+         * child first
+         * @param box Bounding box at the start of the motion. A box of
+         * zero size casts a ray.
+         * @param displacement Motion of the box
+         * @param mode Whether to stop at the first hit found
+         * @param ignored Entity to leave out, such as the one casting
+         * @return Entity hit and the contact, or nothing
+         */
+        std::optional<CastHit> cast(const BoundingBox& box,
+                                    const math::njVec3f& displacement,
+                                    CastMode mode,
+                                    std::optional<EntityId> ignored =
+                                    std::nullopt) const;
+
         /**
          * Get the bounding box of a specified entity
          * @param entity Entity to get the bounding box for
@@ -48,21 +194,167 @@ namespace njin::ecs::physics {
          */
         BoundingBox get_bounding_box(EntityId entity) const;
 
+        /**
+         * Find all pairs of overlapping entities by descending the tree
+         * against itself, so that every pair is found exactly once
+         * @param pairs Buffer to write the pairs to. It is cleared first,
+         * so that it can be reused without reallocating.
+         */
+        void get_overlapping_pairs(OverlappingPairs& pairs) const;
+
+        BoundingBoxType get_type() const;
+
+        /**
+         * Estimate the cost of querying this tree under the cost model it
+         * was built with: the expected number of node and primitive tests
+         * of a single query, weighted by traversal_cost and
+         * intersection_cost. Lower is better.
+         * @return Expected cost of a query
+         */
+        float get_cost() const;
+
+        /**
+         * Update the bounding boxes of primitives and of every node above
+         * them, keeping the topology of the tree. This is O(n), but the
+         * tree degrades as primitives move away from where they were
+         * when it was built.
+         * @param primitives Primitives with their new bounding boxes. Each
+         * entity must already be in the BVH.
+         * @see get_degradation
+         */
+        void refit(const std::vector<Primitive>& primitives);
+
+        /**
+         * How much more expensive querying the tree has become since it
+         * was built, e.g. through refits
+         * @return Current cost over the cost right after building, so 1
+         * for a freshly built tree
+         */
+        float get_degradation() const;
+
         private:
-        std::unique_ptr<BVHNode> root_{ nullptr };
+        std::vector<BVHNode> nodes_{};
+
+        // primitives in the order they were given
+        std::vector<Primitive> primitives_{};
+
+        // leaves refer to ranges of this array, which holds indices into
+        // primitives_
+        std::vector<uint32_t> primitive_indices_{};
 
         BoundingBoxType type_{ BoundingBoxType::XYZ };
 
-        // mapping of an entity to the node that represents it
-        EntityNodeMap entity_to_node_{};
-    };
+        BVHBuildOptions options_{};
 
-    using OverlappingPairs = std::set<std::pair<EntityId, EntityId>>;
-    /**
-     * Get the set of pairs of overlapping entities within a given BVH
-     * @param bvh BVH to check for overlaps
-     * @return Set of overlapping pairs
-     */
-    OverlappingPairs get_overlapping_pairs(const BVH& bvh);
+        // average extents of the primitives, the query size assumed by
+        // the overlap cost model
+        math::njVec3f query_extent_{};
+
+        // cost of the tree right after building
+        float build_cost_{ 0.f };
+
+        // mapping of an entity to its index in primitives_
+        std::unordered_map<EntityId, uint32_t> entity_to_primitive_{};
+
+        /**
+         * Constructor that builds on a thread pool if one is given
+         */
+        BVH(const std::vector<Primitive>& primitives,
+            BoundingBoxType type,
+            const BVHBuildOptions& options,
+            ThreadPool* pool);
+
+        /**
+         * Build the subtree of a node, allocating its descendants at the
+         * end of a node array
+         * @param nodes Node array to build into
+         * @param node Index of the node in the array
+         * @param first First index in primitive_indices_ of the node
+         * @param count Number of primitives beneath the node
+         */
+        void build(std::vector<BVHNode>& nodes,
+                   uint32_t node,
+                   uint32_t first,
+                   uint32_t count);
+
+        /**
+         * Build the whole tree on a thread pool, producing the same nodes
+         * in the same order as build
+         * @param pool Thread pool to build on
+         */
+        void build_parallel(ThreadPool& pool);
+
+        /**
+         * Build the whole tree with the Morton builder. Centroids are
+         * quantized to 30-bit Morton codes, radix sorted, and the nodes
+         * are emitted one level at a time, each splitting its range where
+         * the codes first differ. The boxes are then fitted bottom up.
+         * Every step is spread over the pool if one is given, and the
+         * result does not depend on the number of threads.
+         * @param pool Thread pool to build on, or nullptr
+         */
+        void build_morton(ThreadPool* pool);
+
+        /**
+         * Calculate the bounding box of a range of primitives
+         * @param first First index in primitive_indices_ of the range
+         * @param count Number of primitives in the range
+         * @param pool Thread pool to split large ranges across, or nullptr
+         * @return Bounding box
+         */
+        BoundingBox get_bounds(uint32_t first,
+                               uint32_t count,
+                               ThreadPool* pool) const;
+
+        /**
+         * Decide how to split a range of primitives, using the configured
+         * builder
+         * @param bounds Bounding box of the primitives
+         * @param first First index in primitive_indices_ of the range
+         * @param count Number of primitives in the range
+         * @param pool Thread pool to split large ranges across, or nullptr
+         * @return Number of primitives in the left child after the range
+         * has been partitioned, or 0 if the range should become a leaf
+         */
+        uint32_t partition(const BoundingBox& bounds,
+                           uint32_t first,
+                           uint32_t count,
+                           ThreadPool* pool);
+
+        /**
+         * @see partition
+         */
+        uint32_t partition_median(const BoundingBox& bounds,
+                                  uint32_t first,
+                                  uint32_t count,
+                                  ThreadPool* pool);
+
+        /**
+         * @see partition
+         */
+        uint32_t partition_sah(const BoundingBox& bounds,
+                               uint32_t first,
+                               uint32_t count,
+                               ThreadPool* pool);
+
+        /**
+         * Relative chance that a query visits a bounding box, under the
+         * configured cost model
+         * @param box Bounding box
+         * @return Unnormalised probability
+         */
+        float get_hit_measure(const BoundingBox& box) const;
+
+        /**
+         * Call a function on every primitive in a leaf whose bounding box
+         * overlaps a given bounding box
+         * @param box Bounding box to test against
+         * @param function Function taking the index of the primitive in
+         * primitives_
+         */
+        template<typename Function>
+        void for_each_overlap(const BoundingBox& box,
+                              Function&& function) const;
+    };
 
 }  // namespace njin::ecs::physics
\ No newline at end of file
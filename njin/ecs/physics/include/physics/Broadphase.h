@@ -0,0 +1,224 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "physics/BVH.h"
+#include "physics/DynamicTree.h"
+#include "physics/PhysicsTypes.h"
+#include "physics/Sweep.h"
+#include "physics/WideBVH.h"
+
+namespace njin::ecs::physics {
+    enum class BroadphaseType : uint8_t {
+        BVH,            // refitted every update, rebuilt when it degrades
+        DynamicTree,    // persistent tree with fattened bounds
+        SweepAndPrune,  // persistent sorted endpoint lists
+        SpatialHash,    // uniform grid on the XZ plane
+        WideBVH         // BVH collapsed to 4 children per node for SIMD
+    };
+
+    /**
+     * Finds the pairs of entities whose bounding boxes overlap. A
+     * broadphase is kept across ticks and brought up to date with the
+     * bounding boxes of all simulated entities every tick, so that
+     * implementations can exploit how little bodies move between ticks.
+     */
+    class Broadphase {
+        public:
+        virtual ~Broadphase() = default;
+
+        /**
+         * Bring the broadphase in line with the simulated entities: entities
+         * already in it move, new ones are inserted, and those missing
+         * from the primitives are removed
+         * @param primitives Primitives of all simulated entities
+         */
+        virtual void update(const std::vector<Primitive>& primitives) = 0;
+
+        /**
+         * Find all pairs of overlapping entities
+         * @param pairs Buffer to write the pairs to. It is cleared first.
+         */
+        virtual void get_overlapping_pairs(OverlappingPairs& pairs) const = 0;
+
+        /**
+         * Returns a list of entities that overlap a given bounding box
+         * @param box Bounding box to test overlaps for
+         * @return List of overlapping entities
+         */
+        virtual std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const = 0;
+
+        /**
+         * Get the bounding box of an entity as of the last update
+         * @param entity Entity to get the bounding box for
+         * @return Bounding box
+         */
+        virtual BoundingBox get_bounding_box(EntityId entity) const = 0;
+
+        virtual BoundingBoxType get_type() const = 0;
+
+        /**
+         * Find the entities a bounding box moving along a displacement hits.
+         * By default, every entity overlapping the bounds of the whole
+         * motion is swept against, which broadphases over a tree improve
+         * on by descending only into the nodes the box passes through.
+         * @param box Bounding box at the start of the motion. A box of
+         * zero size casts a ray.
+         * @param displacement Motion of the box
+         * @param mode Whether to stop at the first hit found
+         * @param ignored Entity to leave out, such as the one casting
+         * @return Entity hit and the contact, or nothing
+         * @note Safe to call from several threads at once
+         */
+        virtual std::optional<CastHit>
+        cast(const BoundingBox& box,
+             const math::njVec3f& displacement,
+             CastMode mode,
+             std::optional<EntityId> ignored = std::nullopt) const;
+    };
+
+    /**
+     * Broadphase over a BVH. The BVH is refitted while the set of entities
+     * stays the same, and rebuilt when it changes or the refitted tree has
+     * degraded too far.
+     */
+    class BVHBroadphase final : public Broadphase {
+        public:
+        /**
+         * Constructor
+         * @param type The axes the broadphase should be concerned with
+         * @param options Build settings of the BVH
+         * @param max_degradation How much more expensive to query the
+         * refitted BVH may become before it is rebuilt. With the Morton
+         * builder, rebuilds are cheap enough to keep this close to 1 in
+         * scenes where everything moves.
+         * @param pool Thread pool to rebuild the BVH on, or nullptr to
+         * rebuild on the updating thread
+         */
+        explicit BVHBroadphase(BoundingBoxType type = BoundingBoxType::XYZ,
+                               const BVHBuildOptions& options = {},
+                               float max_degradation = 1.5f,
+                               std::shared_ptr<ThreadPool> pool = nullptr);
+
+        void update(const std::vector<Primitive>& primitives) override;
+
+        void get_overlapping_pairs(OverlappingPairs& pairs) const override;
+
+        std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const override;
+
+        BoundingBox get_bounding_box(EntityId entity) const override;
+
+        BoundingBoxType get_type() const override;
+
+        std::optional<CastHit>
+        cast(const BoundingBox& box,
+             const math::njVec3f& displacement,
+             CastMode mode,
+             std::optional<EntityId> ignored = std::nullopt) const override;
+
+        /**
+         * @return BVH as of the last update
+         */
+        const BVH& get_bvh() const;
+
+        private:
+        BVHBuildOptions options_{};
+        float max_degradation_{ 1.5f };
+        std::shared_ptr<ThreadPool> pool_;
+        BVH bvh_;
+    };
+
+    /**
+     * Broadphase over a 4-wide BVH. A binary BVH is kept up to date like
+     * in BVHBroadphase and collapsed into the wide BVH after every update,
+     * so that overlap queries test four children per node at once.
+     */
+    class WideBVHBroadphase final : public Broadphase {
+        public:
+        /**
+         * Constructor
+         * @param type The axes the broadphase should be concerned with
+         * @param options Build settings of the binary BVH
+         * @param max_degradation How much more expensive to query the
+         * refitted binary BVH may become before it is rebuilt
+         * @param pool Thread pool to rebuild the binary BVH on, or nullptr
+         * to rebuild on the updating thread
+         */
+        explicit WideBVHBroadphase(BoundingBoxType type = BoundingBoxType::XYZ,
+                                   const BVHBuildOptions& options = {},
+                                   float max_degradation = 1.5f,
+                                   std::shared_ptr<ThreadPool> pool = nullptr);
+
+        void update(const std::vector<Primitive>& primitives) override;
+
+        void get_overlapping_pairs(OverlappingPairs& pairs) const override;
+
+        std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const override;
+
+        BoundingBox get_bounding_box(EntityId entity) const override;
+
+        BoundingBoxType get_type() const override;
+
+        std::optional<CastHit>
+        cast(const BoundingBox& box,
+             const math::njVec3f& displacement,
+             CastMode mode,
+             std::optional<EntityId> ignored = std::nullopt) const override;
+
+        private:
+        BVHBroadphase binary_;
+        BVH4 wide_;
+    };
+
+    /**
+     * Broadphase over a DynamicTree
+     */
+    class DynamicTreeBroadphase final : public Broadphase {
+        public:
+        /**
+         * Constructor
+         * @param type The axes the broadphase should be concerned with
+         * @param margin Margin by which the tree fattens bounding boxes
+         */
+        explicit DynamicTreeBroadphase(BoundingBoxType type =
+                                       BoundingBoxType::XYZ,
+                                       float margin = 0.1f);
+
+        void update(const std::vector<Primitive>& primitives) override;
+
+        void get_overlapping_pairs(OverlappingPairs& pairs) const override;
+
+        std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const override;
+
+        BoundingBox get_bounding_box(EntityId entity) const override;
+
+        BoundingBoxType get_type() const override;
+
+        std::optional<CastHit>
+        cast(const BoundingBox& box,
+             const math::njVec3f& displacement,
+             CastMode mode,
+             std::optional<EntityId> ignored = std::nullopt) const override;
+
+        private:
+        DynamicTree tree_;
+    };
+
+    /**
+     * Create a broadphase with default settings
+     * @param broadphase Type of broadphase to create
+     * @param type The axes the broadphase should be concerned with
+     * @param pool Thread pool for broadphases that can build on one, or
+     * nullptr
+     * @return Broadphase
+     */
+    std::unique_ptr<Broadphase> make_broadphase(BroadphaseType broadphase,
+                                                BoundingBoxType type,
+                                                std::shared_ptr<ThreadPool>
+                                                pool = nullptr);
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "math/njVec3.h"
+#include "physics/PairBatches.h"
+#include "physics/PhysicsTypes.h"
+#include "physics/ThreadPool.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Settings of a contact solver
+     * @param velocity_iterations Passes over all contacts that resolve
+     * their relative velocities
+     * @param position_iterations Passes over all contacts that push
+     * penetrating bodies apart
+     * @param warm_starting Start from the impulses a contact ended the
+     * previous solve with, if it still exists
+     * @param restitution_threshold Closing speed below which contacts do
+     * not bounce, which keeps resting bodies from jittering
+     * @param penetration_tolerance Depth up to which bodies count as
+     * touching rather than penetrating. Away from the origin, bodies that
+     * were pushed apart can still touch at float precision.
+     */
+    struct ContactSolverSettings {
+        uint32_t velocity_iterations{ 8 };
+        uint32_t position_iterations{ 4 };
+        bool warm_starting{ true };
+        float restitution_threshold{ 1.f };
+        float penetration_tolerance{ 1e-4f };
+    };
+
+    /**
+     * What a single solve did
+     * @param contact_count Number of contacts solved
+     * @param batch_count Number of batches the contacts were split into
+     * @param velocity_iterations Velocity passes run
+     * @param position_iterations Position passes run
+     * @param warm_started_count Contacts that started from the previous
+     * solve's impulses
+     * @param max_penetration Deepest penetration before solving
+     * @param remaining_penetration Deepest penetration left after solving
+     * @param unresolved_count Contacts still penetrating after solving,
+     * deeper than the tolerance.
+     * These are left for the next solve.
+     */
+    struct ContactSolverStats {
+        size_t contact_count{ 0 };
+        uint32_t batch_count{ 0 };
+        uint32_t velocity_iterations{ 0 };
+        uint32_t position_iterations{ 0 };
+        size_t warm_started_count{ 0 };
+        float max_penetration{ 0.f };
+        float remaining_penetration{ 0.f };
+        size_t unresolved_count{ 0 };
+    };
+
+    /**
+     * A body as seen by the contact solver
+     * @param entity Entity of the body
+     * @param box Bounding box of the body before solving
+     * @param velocity Velocity of the body, updated by the solver
+     * @param displacement Translation the solver moved the body by
+     * @param inverse_mass Inverse of the mass, 0 for bodies that never move
+     * @param restitution How much of the closing speed is kept, in [0, 1]
+     * @param friction Coefficient of friction
+     */
+    struct SolverBody {
+        EntityId entity{ 0 };
+        BoundingBox box{};
+        math::njVec3f velocity{};
+        math::njVec3f displacement{};
+        float inverse_mass{ 0.f };
+        float restitution{ 0.f };
+        float friction{ 0.f };
+    };
+
+    /**
+     * Iterative solver for contacts between AABBs, with a fixed amount of
+     * work per solve.
+     * Velocities are resolved with sequential impulses, clamped so that
+     * contacts only push and friction stays within its cone. Penetration
+     * is then removed by moving bodies apart along the axis of least
+     * penetration, in proportion to their inverse masses.
+     * Contacts are split into batches in which no moving body appears
+     * twice. Batches run in order and the contacts of a batch run in
+     * parallel, so results do not depend on the number of threads.
+     */
+    class ContactSolver {
+        public:
+        /**
+         * Constructor
+         * @param settings Solver settings
+         */
+        explicit ContactSolver(const ContactSolverSettings& settings = {});
+
+        /**
+         * Solve the contacts between overlapping bodies
+         * @param bodies Bodies to solve. Velocities and displacements are
+         * written back to them.
+         * @param pairs Overlapping pairs of bodies
+         * @param pool Thread pool to solve batches on
+         */
+        void solve(std::vector<SolverBody>& bodies,
+                   const OverlappingPairs& pairs,
+                   ThreadPool& pool);
+
+        const ContactSolverSettings& get_settings() const;
+
+        void set_settings(const ContactSolverSettings& settings);
+
+        /**
+         * @return Stats of the last solve
+         */
+        const ContactSolverStats& get_stats() const;
+
+        private:
+        /**
+         * A pair of touching bodies, pushed apart along a single axis
+         */
+        struct Contact {
+            // indices of the bodies
+            uint32_t first{ 0 };
+            uint32_t second{ 0 };
+
+            // the first body moves along +axis if sign is 1, -axis if -1
+            int axis{ 0 };
+            float sign{ 1.f };
+
+            float inverse_mass_sum{ 0.f };
+            float restitution{ 0.f };
+            float friction{ 0.f };
+
+            // normal velocity the contact solves towards
+            float target_velocity{ 0.f };
+
+            // accumulated impulses
+            float normal_impulse{ 0.f };
+            math::njVec3f tangent_impulse{};
+        };
+
+        /**
+         * Impulses a contact ended a solve with
+         */
+        struct CachedImpulse {
+            int axis{ 0 };
+            float sign{ 1.f };
+            float normal_impulse{ 0.f };
+            math::njVec3f tangent_impulse{};
+        };
+
+        ContactSolverSettings settings_{};
+        ContactSolverStats stats_{};
+
+        // contacts grouped by batch, contacts_[batch_offsets_[i],
+        // batch_offsets_[i + 1]) being batch i
+        std::vector<Contact> contacts_{};
+        std::vector<uint32_t> batch_offsets_{};
+
+        PairBatches batches_{};
+
+        std::unordered_map<EntityId, uint32_t> entity_to_body_{};
+
+        // impulses of the last solve, by pair
+        std::unordered_map<uint64_t, CachedImpulse> cache_{};
+
+        /**
+         * Find the contacts of a set of pairs, batched
+         * @param bodies Bodies to solve
+         * @param pairs Overlapping pairs of bodies
+         */
+        void make_contacts(const std::vector<SolverBody>& bodies,
+                           const OverlappingPairs& pairs);
+
+        /**
+         * Find how far two bodies penetrate after being displaced
+         * @param first First body
+         * @param second Second body
+         * @return Vector the first body must move by to separate from the
+         * second, or 0 if they are apart or only touching
+         */
+        math::njVec3f get_penetration(const SolverBody& first,
+                                      const SolverBody& second) const;
+
+        /**
+         * Call a function on every contact, one batch after another, with
+         * the contacts of a batch spread across a thread pool
+         * @param pool Thread pool
+         * @param function Function taking a contact
+         */
+        template<typename Function>
+        void for_each_contact(ThreadPool& pool, Function&& function);
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/PhysicsTypes.h"
+#include "physics/Sweep.h"
+
+namespace njin::ecs::physics {
+    /**
+     * A single node of a DynamicTree. Nodes live in a pool and refer to
+     * each other by index, so that they can be reused once freed.
+     */
+    struct DynamicTreeNode {
+        static constexpr uint32_t NONE{ std::numeric_limits<uint32_t>::max() };
+
+        // leaf: fattened bounding box of the entity
+        // internal node: bounding box of both children
+        BoundingBox box{};
+
+        // entity of a leaf
+        EntityId entity{ 0 };
+
+        // parent of a node in the tree, next free node of a node in the
+        // free list
+        uint32_t parent_or_next{ NONE };
+
+        uint32_t left{ NONE };
+        uint32_t right{ NONE };
+
+        // leaves have height 0, free nodes -1
+        int32_t height{ -1 };
+
+        /**
+         * @return True if this node is a leaf (no children)
+         */
+        bool is_leaf() const {
+            return left == NONE;
+        }
+    };
+
+    /**
+     * A binary AABB tree that is updated incrementally instead of being
+     * rebuilt, meant to persist across ticks.
+     * Leaves store bounding boxes fattened by a margin, and an entity that
+     * moves is only reinserted once it leaves its fattened box. Insertion
+     * picks the sibling that grows the tree the least, and rotations keep
+     * the tree balanced. Queries are answered against the exact bounding
+     * boxes, so the margin never produces false overlaps.
+     */
+    class DynamicTree {
+        public:
+        /**
+         * Constructor
+         * @param type The axes the tree should be concerned with
+         * @param margin Distance by which the bounding boxes in leaves are
+         * grown along every axis of concern
+         */
+        explicit DynamicTree(BoundingBoxType type = BoundingBoxType::XYZ,
+                             float margin = 0.1f);
+
+        /**
+         * Insert an entity
+         * @param entity Entity to insert, which must not be in the tree yet
+         * @param box Bounding box of the entity
+         */
+        void insert(EntityId entity, const BoundingBox& box);
+
+        /**
+         * Remove an entity
+         * @param entity Entity to remove, which must be in the tree
+         */
+        void remove(EntityId entity);
+
+        /**
+         * Update the bounding box of an entity
+         * @param entity Entity to move, which must be in the tree
+         * @param box New bounding box of the entity
+         * @return True if the entity left its fattened bounding box and
+         * had to be reinserted
+         */
+        bool move(EntityId entity, const BoundingBox& box);
+
+        /**
+         * @param entity Entity to check for
+         * @return True if the entity is in the tree
+         */
+        bool contains(EntityId entity) const;
+
+        /**
+         * @return Number of entities in the tree
+         */
+        size_t size() const;
+
+        /**
+         * Retrieve the list of entities in the tree
+         * @return List of entity ids
+         */
+        std::vector<EntityId> get_entities() const;
+
+        /**
+         * Get the exact bounding box of an entity
+         * @param entity Entity to get the bounding box for
+         * @return Bounding box
+         */
+        BoundingBox get_bounding_box(EntityId entity) const;
+
+        /**
+         * Get the fattened bounding box stored for an entity
+         * @param entity Entity to get the bounding box for
+         * @return Fattened bounding box
+         */
+        BoundingBox get_fat_bounding_box(EntityId entity) const;
+
+        /**
+         * Returns a list of entities that overlap a given entity
+         * @param entity Entity to test overlaps for
+         * @return List of overlapping entities (excluding this one)
+         */
+        std::vector<EntityId> get_overlaps(EntityId entity) const;
+
+        /**
+         * Returns a list of entities that overlap a given bounding box
+         * @param box Bounding box to test overlaps for
+         * @return List of overlapping entities
+         */
+        std::vector<EntityId> get_overlaps(const BoundingBox& box) const;
+
+        /**
+         * Find the entities a bounding box moving along a displacement
+         * hits, descending only into nodes whose fattened boxes it
+         * passes through, nearer child first
+         * @param box Bounding box at the start of the motion. A box of
+         * zero size casts a ray.
+         * @param displacement Motion of the box
+         * @param mode Whether to stop at the first hit found
+         * @param ignored Entity to leave out, such as the one casting
+         * @return Entity hit and the contact, or nothing
+         */
+        std::optional<CastHit> cast(const BoundingBox& box,
+                                    const math::njVec3f& displacement,
+                                    CastMode mode,
+                                    std::optional<EntityId> ignored =
+                                    std::nullopt) const;
+
+        /**
+         * Find all pairs of overlapping entities by descending the tree
+         * against itself, so that every pair is found exactly once
+         * @param pairs Buffer to write the pairs to. It is cleared first,
+         * so that it can be reused without reallocating.
+         */
+        void get_overlapping_pairs(OverlappingPairs& pairs) const;
+
+        /**
+         * @return Height of the tree, 0 if it is empty or a single leaf
+         */
+        int32_t get_height() const;
+
+        BoundingBoxType get_type() const;
+
+        private:
+        // an entity's leaf and its exact bounding box
+        struct Proxy {
+            uint32_t leaf{ DynamicTreeNode::NONE };
+            BoundingBox box{};
+        };
+
+        std::vector<DynamicTreeNode> nodes_{};
+        uint32_t root_{ DynamicTreeNode::NONE };
+        uint32_t free_list_{ DynamicTreeNode::NONE };
+
+        BoundingBoxType type_{ BoundingBoxType::XYZ };
+        float margin_{ 0.1f };
+
+        std::unordered_map<EntityId, Proxy> entity_to_proxy_{};
+
+        /**
+         * Take a node from the free list, growing the pool if it is empty
+         * @return Index of the node
+         */
+        uint32_t allocate_node();
+
+        /**
+         * Return a node to the free list
+         * @param node Index of the node
+         */
+        void free_node(uint32_t node);
+
+        /**
+         * Link a leaf into the tree next to the sibling that grows the tree
+         * the least
+         * @param leaf Index of the leaf
+         */
+        void insert_leaf(uint32_t leaf);
+
+        /**
+         * Unlink a leaf from the tree, freeing its parent
+         * @param leaf Index of the leaf
+         */
+        void remove_leaf(uint32_t leaf);
+
+        /**
+         * Refit and rebalance every node from a given node up to the root
+         * @param node Index of the first node to fix
+         */
+        void fix_upwards(uint32_t node);
+
+        /**
+         * Rotate a node if its subtrees differ in height by more than one
+         * @param node Index of the node
+         * @return Index of the node now at the position of the given node
+         */
+        uint32_t balance(uint32_t node);
+
+        /**
+         * Grow a bounding box by the margin along the axes of concern
+         * @param box Bounding box
+         * @return Fattened bounding box
+         */
+        BoundingBox fatten(const BoundingBox& box) const;
+
+        /**
+         * Surface area of a bounding box (perimeter in 2D), the cost of a
+         * node when choosing where to insert
+         * @param box Bounding box
+         * @return Cost of the box
+         */
+        float get_cost(const BoundingBox& box) const;
+
+        /**
+         * Call a function on every entity whose exact bounding box
+         * overlaps a given bounding box
+         * @param box Bounding box to test against
+         * @param function Function taking the entity
+         */
+        template<typename Function>
+        void for_each_overlap(const BoundingBox& box,
+                              Function&& function) const;
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Bodies grouped into simulation islands: the connected components of
+     * the graph whose vertices are bodies and whose edges are touching
+     * pairs. Bodies in different islands cannot affect each other this
+     * tick, so an island can be put to sleep or woken up as a whole.
+     * Islands are found with a union-find over the pairs.
+     */
+    class Islands {
+        public:
+        /**
+         * Group bodies into islands
+         * @param bodies Bodies to group. A body without pairs is an island
+         * of its own.
+         * @param pairs Touching pairs. Pairs with a body that is not in
+         * the list are ignored, so bodies that should not link islands,
+         * such as static ones, are left out of the list.
+         * @note Islands are numbered by their first body in the list, and
+         * bodies within an island keep the order of the list
+         */
+        void build(std::span<const EntityId> bodies,
+                   const OverlappingPairs& pairs);
+
+        /**
+         * @return Number of islands
+         */
+        uint32_t get_island_count() const;
+
+        /**
+         * @param island Index of the island, less than get_island_count
+         * @return Bodies in the island
+         */
+        std::span<const EntityId> get_island(uint32_t island) const;
+
+        /**
+         * @param entity Body to check for
+         * @return True if the body was grouped into an island
+         */
+        bool contains(EntityId entity) const;
+
+        /**
+         * @param entity Body to look up
+         * @return Index of the island the body is in
+         * @throws std::out_of_range if the body was not grouped
+         */
+        uint32_t get_island_index(EntityId entity) const;
+
+        private:
+        // union-find forest over the indices of the bodies
+        std::vector<uint32_t> parent_{};
+
+        std::unordered_map<EntityId, uint32_t> entity_to_body_{};
+
+        std::vector<uint32_t> body_to_island_{};
+
+        // bodies grouped by island, island i being
+        // members_[offsets_[i], offsets_[i + 1])
+        std::vector<EntityId> members_{};
+        std::vector<uint32_t> offsets_{ 0 };
+
+        /**
+         * Find the root of the tree a body is in, halving the path to it
+         * @param body Index of the body
+         * @return Index of the root body
+         */
+        uint32_t find(uint32_t body);
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Overlapping pairs split into batches in which no body appears twice,
+     * so that the pairs of a batch can be resolved in parallel. Batches are
+     * found by greedily colouring the graph whose vertices are bodies and
+     * whose edges are pairs: every pair takes the lowest colour neither of
+     * its bodies has yet.
+     * Pairs are sorted before colouring, so the batches only depend on the
+     * set of pairs, and not on the order a broadphase found them in.
+     */
+    class PairBatches {
+        public:
+        /**
+         * Split a list of pairs into batches
+         * @param pairs Overlapping pairs, each appearing once
+         * @param is_fixed Optional predicate for bodies that resolving a
+         * pair never writes to, such as static bodies. A fixed body may
+         * appear in any number of pairs of one batch.
+         */
+        void build(const OverlappingPairs& pairs,
+                   const std::function<bool(EntityId)>& is_fixed = {});
+
+        /**
+         * @return Number of batches
+         */
+        uint32_t get_batch_count() const;
+
+        /**
+         * @param batch Index of the batch, less than get_batch_count
+         * @return Pairs of the batch, sorted
+         */
+        std::span<const EntityPair> get_batch(uint32_t batch) const;
+
+        /**
+         * @return Number of pairs across all batches
+         */
+        size_t size() const;
+
+        private:
+        // pairs grouped by batch
+        OverlappingPairs pairs_{};
+
+        // batch i holds pairs_[offsets_[i], offsets_[i + 1])
+        std::vector<uint32_t> offsets_{};
+
+        // scratch buffers, kept to reuse their allocations
+        OverlappingPairs sorted_{};
+        std::vector<uint32_t> colors_{};
+
+        // colours taken by each body in the current round, one bit each
+        std::unordered_map<EntityId, uint64_t> body_to_colors_{};
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
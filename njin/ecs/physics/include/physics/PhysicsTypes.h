@@ -1,4 +1,10 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "math/njVec3.h"
 
 namespace njin::ecs::physics {
     using EntityId = uint32_t;
@@ -42,15 +48,65 @@ namespace njin::ecs::physics {
         bool does_overlap(const BoundingBox& other,
                           BoundingBoxType type) const {
             bool result{ true };
-            if (type == BoundingBoxType::XZ) {
-                if (max_x < other.min_x || other.max_x < min_x)
-                    result = false;
-                if (max_z < other.min_z || other.max_z < min_z)
-                    result = false;
-            } else if (max_y < other.min_y || other.max_y < min_y)
+            if (max_x < other.min_x || other.max_x < min_x)
+                result = false;
+            if (max_z < other.min_z || other.max_z < min_z)
+                result = false;
+            if (type == BoundingBoxType::XYZ &&
+                (max_y < other.min_y || other.max_y < min_y))
                 result = false;
             return result;
         }
+
+        /**
+         * Checks if another AABB lies entirely within this one
+         * @param other Other AABB to check
+         * @param type Axes to check along
+         * @return True if this bounding box contains the other
+         */
+        bool does_contain(const BoundingBox& other,
+                          BoundingBoxType type) const {
+            bool result{ min_x <= other.min_x && other.max_x <= max_x &&
+                         min_z <= other.min_z && other.max_z <= max_z };
+            if (type == BoundingBoxType::XYZ) {
+                result = result && min_y <= other.min_y &&
+                         other.max_y <= max_y;
+            }
+            return result;
+        }
+
+        /**
+         * @param offset Offset to move by
+         * @return This AABB moved by an offset
+         */
+        BoundingBox translate(const math::njVec3f& offset) const {
+            return { .centroid = centroid + offset,
+                     .min_x = min_x + offset.x,
+                     .max_x = max_x + offset.x,
+                     .min_y = min_y + offset.y,
+                     .max_y = max_y + offset.y,
+                     .min_z = min_z + offset.z,
+                     .max_z = max_z + offset.z };
+        }
+
+        /**
+         * Calculate the smallest AABB enclosing two AABBs
+         * @param a First AABB
+         * @param b Second AABB
+         * @return Enclosing AABB
+         */
+        static BoundingBox merge(const BoundingBox& a, const BoundingBox& b) {
+            BoundingBox result{ .min_x = std::min(a.min_x, b.min_x),
+                                .max_x = std::max(a.max_x, b.max_x),
+                                .min_y = std::min(a.min_y, b.min_y),
+                                .max_y = std::max(a.max_y, b.max_y),
+                                .min_z = std::min(a.min_z, b.min_z),
+                                .max_z = std::max(a.max_z, b.max_z) };
+            result.centroid = { (result.min_x + result.max_x) / 2,
+                                (result.min_y + result.max_y) / 2,
+                                (result.min_z + result.max_z) / 2 };
+            return result;
+        }
     };
 
     inline std::ostream& operator<<(std::ostream& os, const BoundingBox& box) {
@@ -66,4 +122,20 @@ namespace njin::ecs::physics {
 
     // Bounding box coordinates are in world space
     using Primitive = std::pair<EntityId, BoundingBox>;
+
+    // pair of entities, the smaller one first
+    using EntityPair = std::pair<EntityId, EntityId>;
+
+    // flat buffer of overlapping pairs, each pair appearing once
+    using OverlappingPairs = std::vector<EntityPair>;
+
+    /**
+     * Order two entities into a pair
+     * @param a First entity
+     * @param b Second entity
+     * @return Pair with the smaller entity first
+     */
+    inline EntityPair make_entity_pair(EntityId a, EntityId b) {
+        return a < b ? EntityPair{ a, b } : EntityPair{ b, a };
+    }
 }  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "math/njVec3.h"
+#include "physics/PhysicsTypes.h"
+#include "physics/Sweep.h"
+
+namespace njin::ecs::physics {
+    class Broadphase;
+    class ThreadPool;
+
+    enum class QueryType : uint8_t {
+        Ray,      // from origin along a unit direction, up to max_distance
+        Segment,  // from origin to origin + direction
+        Sweep,    // box moving along direction
+        Overlap   // entities overlapping box
+    };
+
+    /**
+     * A query against the bounding boxes of the simulated entities, in
+     * world space
+     * @param type Shape of the query
+     * @param mode Whether any hit will do, or the closest one is needed.
+     * The closest overlap is the one whose centroid is nearest to that of
+     * box.
+     * @param origin Start of a ray or segment
+     * @param direction Unit direction of a ray, or the motion of a
+     * segment or sweep
+     * @param max_distance Length of a ray
+     * @param box Bounding box to sweep or test overlaps for
+     * @param ignored Entity to leave out, such as the one querying
+     */
+    struct Query {
+        QueryType type{ QueryType::Ray };
+        CastMode mode{ CastMode::Closest };
+        math::njVec3f origin{};
+        math::njVec3f direction{};
+        float max_distance{ 0.f };
+        BoundingBox box{};
+        std::optional<EntityId> ignored{};
+    };
+
+    /**
+     * Answer to a query
+     * @param is_hit True if anything was hit
+     * @param entity Entity that was hit
+     * @param time Fraction of the ray, segment or sweep covered before
+     * the hit, 0 for overlaps and for queries that start inside an entity
+     * @param point Point on a ray or segment where it hit, or the
+     * centroid of the swept box at the hit. For overlaps, the centroid of
+     * the entity.
+     * @param normal Normal of the face that was hit. Zero for overlaps
+     * and for queries that start inside an entity.
+     */
+    struct QueryResult {
+        bool is_hit{ false };
+        EntityId entity{ 0 };
+        float time{ 0.f };
+        math::njVec3f point{};
+        math::njVec3f normal{};
+    };
+
+    /**
+     * Answer a single query
+     * @param broadphase Broadphase holding the current bounding boxes
+     * @param query Query to answer
+     * @return Result of the query
+     */
+    QueryResult answer_query(const Broadphase& broadphase, const Query& query);
+
+    /**
+     * Answer a batch of queries in parallel
+     * @param broadphase Broadphase holding the current bounding boxes
+     * @param queries Queries to answer
+     * @param results Buffer to write the results to, in the order of the
+     * queries. It is resized to fit, so that it can be reused without
+     * reallocating.
+     * @param pool Thread pool to answer on
+     */
+    void answer_queries(const Broadphase& broadphase,
+                        std::span<const Query> queries,
+                        std::vector<QueryResult>& results,
+                        ThreadPool& pool);
+}  // namespace njin::ecs::physics
\ No newline at end of file
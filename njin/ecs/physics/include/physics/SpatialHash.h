@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/Broadphase.h"
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Broadphase that hashes bounding boxes into the cells of a uniform grid
+     * on the XZ plane. A body is inserted into every cell its bounding box
+     * touches, and only bodies sharing a cell are tested against each
+     * other. For bodies of roughly the cell size this makes insertion O(1)
+     * and keeps the tests local.
+     * For 3D broadphases the grid is still on the XZ plane, and the Y-axis
+     * is only checked when testing pairs.
+     * Bodies that would cover more than MAX_CELLS cells (floors, skyboxes)
+     * are kept out of the grid in an oversized list that is tested against
+     * every body instead, as are unbounded ones. Bodies with a NaN bound
+     * are kept out of the grid altogether, and overlap nothing.
+     */
+    class SpatialHash final : public Broadphase {
+        public:
+        // most cells a body may cover before it is treated as oversized
+        static constexpr int64_t MAX_CELLS{ 64 };
+
+        /**
+         * Constructor
+         * @param type The axes the broadphase should be concerned with
+         * @param cell_size Width of a cell along both X and Z
+         */
+        explicit SpatialHash(BoundingBoxType type = BoundingBoxType::XZ,
+                             float cell_size = 2.f);
+
+        void update(const std::vector<Primitive>& primitives) override;
+
+        void get_overlapping_pairs(OverlappingPairs& pairs) const override;
+
+        std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const override;
+
+        BoundingBox get_bounding_box(EntityId entity) const override;
+
+        BoundingBoxType get_type() const override;
+
+        /**
+         * @return Number of occupied cells
+         */
+        size_t get_cell_count() const;
+
+        /**
+         * @return Number of bodies kept out of the grid for being too large
+         */
+        size_t get_oversized_count() const;
+
+        private:
+        /**
+         * Inclusive range of cells covered by a bounding box
+         */
+        struct CellRange {
+            int32_t min_x{ 0 };
+            int32_t max_x{ 0 };
+            int32_t min_z{ 0 };
+            int32_t max_z{ 0 };
+
+            bool operator==(const CellRange& other) const = default;
+
+            /**
+             * @return Number of cells in the range
+             */
+            int64_t get_count() const;
+        };
+
+        // where a proxy is stored
+        enum class Placement {
+            Grid,       // in every cell of its range
+            Oversized,  // in the oversized list
+            Rejected    // nowhere, its bounding box has a NaN bound
+        };
+
+        /**
+         * An entity in the broadphase. Removed proxies are kept in a free
+         * list, so that the indices in cells stay valid.
+         */
+        struct Proxy {
+            EntityId entity{ 0 };
+            BoundingBox box{};
+            CellRange cells{};
+            Placement placement{ Placement::Grid };
+            bool updated{ false };
+            bool alive{ false };
+        };
+
+        BoundingBoxType type_{ BoundingBoxType::XZ };
+        float cell_size_{ 2.f };
+
+        std::vector<Proxy> proxies_{};
+        std::vector<uint32_t> free_proxies_{};
+        std::unordered_map<EntityId, uint32_t> entity_to_proxy_{};
+
+        // key of a cell to the indices of the proxies in it
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells_{};
+
+        // indices of the proxies too large for the grid
+        std::vector<uint32_t> oversized_{};
+
+        /**
+         * @param box Bounding box
+         * @return Range of cells the bounding box touches. Cells far from
+         * the origin are clamped to the edge of the grid.
+         */
+        CellRange get_cell_range(const BoundingBox& box) const;
+
+        /**
+         * @param box Bounding box
+         * @param cells Range of cells the bounding box touches
+         * @return Where a proxy with the bounding box is stored
+         */
+        static Placement get_placement(const BoundingBox& box,
+                                       const CellRange& cells);
+
+        /**
+         * Store a proxy according to its placement
+         * @param proxy Index of the proxy
+         */
+        void add_proxy(uint32_t proxy);
+
+        /**
+         * Remove a proxy from where it is stored
+         * @param proxy Index of the proxy
+         */
+        void remove_proxy(uint32_t proxy);
+
+        /**
+         * Add a proxy to every cell in its range
+         * @param proxy Index of the proxy
+         */
+        void add_to_cells(uint32_t proxy);
+
+        /**
+         * Remove a proxy from every cell in its range
+         * @param proxy Index of the proxy
+         */
+        void remove_from_cells(uint32_t proxy);
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
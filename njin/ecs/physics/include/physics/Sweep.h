@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+
+#include "math/njVec3.h"
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * First contact of a bounding box moving along a displacement
+     * @param time Fraction of the displacement covered before contact,
+     * in [0, 1]
+     * @param normal Axis-aligned normal of the face of the target that
+     * was hit, pointing back at the moving box. Zero if the boxes were
+     * already overlapping at the start.
+     */
+    struct SweepHit {
+        float time{ 0.f };
+        math::njVec3f normal{};
+    };
+
+    /**
+     * Which hit a cast looks for
+     */
+    enum class CastMode : uint8_t {
+        Any,     // stop at the first hit found, wherever it is
+        Closest  // find the hit closest to the start of the motion
+    };
+
+    /**
+     * Entity hit by a cast, and where it was hit
+     */
+    struct CastHit {
+        EntityId entity{ 0 };
+        SweepHit hit{};
+    };
+
+    /**
+     * Find the time of impact of a moving bounding box against a
+     * stationary one, by intersecting the intervals in which they overlap
+     * along each axis
+     * @param box Bounding box at the start of the motion
+     * @param displacement Motion of the box
+     * @param target Stationary bounding box
+     * @param type Axes to test along
+     * @return First contact, or nothing if the box does not reach the
+     * target. Boxes overlapping at the start give a hit at time 0 with a
+     * zero normal.
+     */
+    std::optional<SweepHit> sweep(const BoundingBox& box,
+                                  const math::njVec3f& displacement,
+                                  const BoundingBox& target,
+                                  BoundingBoxType type);
+
+    /**
+     * @param box Bounding box at the start of the motion
+     * @param displacement Motion of the box
+     * @return Bounding box enclosing the box along all of its motion
+     */
+    BoundingBox get_swept_bounds(const BoundingBox& box,
+                                 const math::njVec3f& displacement);
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/Broadphase.h"
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Incremental sweep-and-prune broadphase. The minimum and maximum of
+     * every bounding box along each axis of concern are kept in one sorted
+     * endpoint list per axis across updates. Since bodies move little
+     * between ticks, the lists are nearly sorted, and insertion sort
+     * restores their order in close to linear time. Pairs begin or stop
+     * overlapping exactly when a minimum and a maximum swap places, so the
+     * set of overlapping pairs is maintained from the swaps alone.
+     */
+    class SweepAndPrune final : public Broadphase {
+        public:
+        /**
+         * Constructor
+         * @param type The axes the broadphase should be concerned with
+         */
+        explicit SweepAndPrune(BoundingBoxType type = BoundingBoxType::XYZ);
+
+        void update(const std::vector<Primitive>& primitives) override;
+
+        void get_overlapping_pairs(OverlappingPairs& pairs) const override;
+
+        /**
+         * Returns a list of entities that overlap a given bounding box. This
+         * tests every entity, as the endpoint lists are not meant for
+         * spatial queries.
+         * @param box Bounding box to test overlaps for
+         * @return List of overlapping entities
+         */
+        std::vector<EntityId>
+        get_overlaps(const BoundingBox& box) const override;
+
+        BoundingBox get_bounding_box(EntityId entity) const override;
+
+        BoundingBoxType get_type() const override;
+
+        /**
+         * @return Pairs that began overlapping during the last update
+         */
+        const OverlappingPairs& get_added_pairs() const;
+
+        /**
+         * @return Pairs that stopped overlapping during the last update,
+         * including the pairs of entities that were removed
+         */
+        const OverlappingPairs& get_removed_pairs() const;
+
+        private:
+        /**
+         * The minimum or maximum of a proxy along an axis
+         */
+        struct Endpoint {
+            float value{ 0.f };
+            uint32_t proxy{ 0 };
+            bool is_max{ false };
+        };
+
+        /**
+         * An entity in the broadphase
+         */
+        struct Proxy {
+            EntityId entity{ 0 };
+            BoundingBox box{};
+            bool updated{ false };
+        };
+
+        BoundingBoxType type_{ BoundingBoxType::XYZ };
+
+        // X, Z, and Y for 3D
+        uint32_t axis_count_{ 3 };
+        std::array<std::vector<Endpoint>, 3> endpoints_{};
+
+        std::vector<Proxy> proxies_{};
+        std::unordered_map<EntityId, uint32_t> entity_to_proxy_{};
+
+        OverlappingPairs pairs_{};
+        // key of a pair to its index in pairs_
+        std::unordered_map<uint64_t, uint32_t> pair_to_index_{};
+
+        OverlappingPairs added_{};
+        OverlappingPairs removed_{};
+
+        /**
+         * Remove the proxies that were not updated, along with their pairs
+         * and endpoints
+         */
+        void remove_stale_proxies();
+
+        /**
+         * Restore the order of an axis' endpoints after their values
+         * changed, adding and removing pairs as endpoints swap
+         * @param axis Index of the axis
+         */
+        void sort_axis(uint32_t axis);
+
+        /**
+         * Add a pair if it is not present yet
+         * @param pair Pair to add
+         */
+        void add_pair(const EntityPair& pair);
+
+        /**
+         * Remove a pair if it is present
+         * @param pair Pair to remove
+         */
+        void remove_pair(const EntityPair& pair);
+
+        /**
+         * @param axis Index of the axis
+         * @param box Bounding box
+         * @param is_max True for the maximum, false for the minimum
+         * @return Value of an endpoint of a bounding box along an axis
+         */
+        static float get_value(uint32_t axis,
+                               const BoundingBox& box,
+                               bool is_max);
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
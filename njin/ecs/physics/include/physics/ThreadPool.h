@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace njin::ecs::physics {
+    /**
+     * A fixed set of worker threads that run the iterations of a parallel
+     * loop. The calling thread takes part in the loop as well, so a pool of
+     * n threads has n - 1 workers.
+     */
+    class ThreadPool {
+        public:
+        /**
+         * Constructor
+         * @param thread_count Number of threads loops run on, including the
+         * calling thread. 0 picks the number of hardware threads.
+         */
+        explicit ThreadPool(uint32_t thread_count = 0);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Stops and joins all worker threads
+         */
+        ~ThreadPool();
+
+        /**
+         * @return Number of threads loops run on, including the calling
+         * thread
+         */
+        uint32_t get_thread_count() const;
+
+        /**
+         * Call a function for every index in [0, count) and block until all
+         * calls are done. Calls run in no particular order, so they must be
+         * independent of each other. If any call throws, the first
+         * exception is rethrown once all calls are done.
+         * @param count Number of iterations
+         * @param function Function taking the index of an iteration
+         * @note Several threads may call this at once, e.g. the worlds of
+         * different shards sharing one pool: while the workers run one
+         * caller's loop, other callers run theirs on their own thread.
+         * Must not be called from within a loop of the same pool.
+         */
+        void parallel_for(uint32_t count,
+                          const std::function<void(uint32_t)>& function);
+
+        private:
+        std::vector<std::thread> workers_{};
+
+        // held by the caller whose loop the workers are running
+        std::mutex loop_mutex_{};
+
+        std::mutex mutex_{};
+        std::condition_variable start_{};
+        std::condition_variable done_{};
+
+        // the current loop
+        const std::function<void(uint32_t)>* function_{ nullptr };
+        uint32_t count_{ 0 };
+        std::atomic<uint32_t> next_{ 0 };
+        std::exception_ptr exception_{};
+
+        // incremented once per loop to wake the workers
+        uint64_t generation_{ 0 };
+
+        // number of workers that have not finished the current loop
+        uint32_t pending_{ 0 };
+
+        bool stopping_{ false };
+
+        /**
+         * Worker loop of a single thread
+         */
+        void run_worker();
+
+        /**
+         * Run iterations of the current loop until there are none left
+         */
+        void run_iterations();
+    };
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "physics/BVH.h"
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * A node of a WideBVH, holding the bounding boxes of up to Width
+     * children as one array per bound, so that all children can be tested
+     * in a single SIMD pass.
+     * Unused slots have NaN bounds, which fail every comparison, so they
+     * never overlap anything, not even an unbounded box. In 2D BVHs, the
+     * Y bounds are unbounded, so that the Y-axis never rejects a child.
+     * @tparam Width Number of children, 4 or 8
+     */
+    template<uint32_t Width>
+    struct WideBVHNode {
+        alignas(32) float min_x[Width];
+        alignas(32) float max_x[Width];
+        alignas(32) float min_y[Width];
+        alignas(32) float max_y[Width];
+        alignas(32) float min_z[Width];
+        alignas(32) float max_z[Width];
+
+        // internal child: index of its node
+        // leaf child: index of its first primitive
+        uint32_t child[Width];
+
+        // number of primitives of a leaf child, 0 for internal children
+        uint32_t count[Width];
+    };
+
+    /**
+     * Test the children of a wide node against a bounding box. Uses AVX or
+     * SSE when the target supports them.
+     * @tparam Width Number of children, 4 or 8
+     * @param node Node whose children to test
+     * @param box Bounding box to test against
+     * @return Mask with bit i set if child i overlaps the bounding box
+     */
+    template<uint32_t Width>
+    uint32_t get_hit_mask(const WideBVHNode<Width>& node,
+                          const BoundingBox& box);
+
+    /**
+     * Scalar version of get_hit_mask, used when SIMD is not available
+     * @see get_hit_mask
+     */
+    template<uint32_t Width>
+    uint32_t get_hit_mask_scalar(const WideBVHNode<Width>& node,
+                                 const BoundingBox& box);
+
+    /**
+     * A BVH with a branching factor of 4 or 8, made by collapsing a binary
+     * BVH. Each node tests all of its children at once, which makes the
+     * tree shallower and cuts the number of node visits of a query.
+     * @tparam Width Number of children per node, 4 or 8
+     */
+    template<uint32_t Width>
+    class WideBVH {
+        static_assert(Width == 4 || Width == 8,
+                      "wide BVHs have 4 or 8 children per node");
+
+        public:
+        using Node = WideBVHNode<Width>;
+
+        /**
+         * Constructor
+         * @param primitives List of primitives to form the BVH with
+         * @param type The axes the BVH should be concerned with
+         * @param options Build settings of the binary BVH that is collapsed
+         */
+        explicit WideBVH(const std::vector<Primitive>& primitives,
+                         BoundingBoxType type = BoundingBoxType::XYZ,
+                         const BVHBuildOptions& options = {});
+
+        /**
+         * Constructor
+         * @param bvh Binary BVH to collapse
+         */
+        explicit WideBVH(const BVH& bvh);
+
+        /**
+         * @return All nodes, root first
+         */
+        const std::vector<Node>& get_nodes() const;
+
+        /**
+         * @return Number of levels of nodes, 0 if the BVH is empty
+         */
+        uint32_t get_depth() const;
+
+        /**
+         * Returns a list of entities that overlap a given entity
+         * @param entity Entity to test overlaps for
+         * @return List of overlapping entities (excluding this one)
+         */
+        std::vector<EntityId> get_overlaps(EntityId entity) const;
+
+        /**
+         * Returns a list of entities that overlap a given bounding box
+         * @param box Bounding box to test overlaps for
+         * @return List of overlapping entities
+         */
+        std::vector<EntityId> get_overlaps(const BoundingBox& box) const;
+
+        /**
+         * Find all pairs of overlapping entities, by querying the BVH with
+         * the bounding box of every entity
+         * @param pairs Buffer to write the pairs to. It is cleared first.
+         */
+        void get_overlapping_pairs(OverlappingPairs& pairs) const;
+
+        /**
+         * Get the bounding box of a specified entity
+         * @param entity Entity to get the bounding box for
+         * @return Bounding box
+         */
+        BoundingBox get_bounding_box(EntityId entity) const;
+
+        BoundingBoxType get_type() const;
+
+        private:
+        std::vector<Node> nodes_{};
+
+        // primitives in leaf order, so that leaves refer to contiguous
+        // ranges of them
+        std::vector<Primitive> primitives_{};
+
+        BoundingBoxType type_{ BoundingBoxType::XYZ };
+
+        // mapping of an entity to its index in primitives_
+        std::unordered_map<EntityId, uint32_t> entity_to_primitive_{};
+
+        /**
+         * Collapse the subtree of a binary node into wide nodes
+         * @param bvh Binary BVH
+         * @param binary Index of the binary node
+         * @return Index of the wide node
+         */
+        uint32_t collapse(const BVH& bvh, uint32_t binary);
+
+        /**
+         * Call a function on every primitive whose bounding box overlaps a
+         * given bounding box
+         * @param box Bounding box to test against
+         * @param function Function taking the index of the primitive in
+         * primitives_
+         */
+        template<typename Function>
+        void for_each_overlap(const BoundingBox& box,
+                              Function&& function) const;
+    };
+
+    extern template class WideBVH<4>;
+    extern template class WideBVH<8>;
+
+    using BVH4 = WideBVH<4>;
+    using BVH8 = WideBVH<8>;
+}  // namespace njin::ecs::physics
\ No newline at end of file
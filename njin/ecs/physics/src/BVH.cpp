@@ -1,72 +1,1416 @@
 #include "physics/BVH.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace njin::ecs::physics {
-    BVH::BVH(const std::vector<Primitive>& primitives, BoundingBoxType type) :
-        type_{ type } {
-        if (!primitives.empty()) {
-            // recursive construction of bvh
-            root_ = std::make_unique<BVHNode>(primitives,
-                                              entity_to_node_,
-                                              type_);
+    namespace {
+        enum class Axis {
+            X,
+            Y,
+            Z
+        };
+
+        /**
+        *  Select the partition axis along which to split the primitives. We choose
+        *  the axis that has the largest extent (largest gap between smallest
+        *  min and largest max)
+        *  @param bounds Bounding box of the primitives to partition
+        *  @param type Axes of relevance. The Y-axis is never chosen for 2D
+        *  (XZ) BVHs.
+        */
+        Axis choose_partition_axis(const BoundingBox& bounds,
+                                   BoundingBoxType type) {
+            // calculate extents
+            float x_extent{ bounds.max_x - bounds.min_x };
+            float y_extent{ bounds.max_y - bounds.min_y };
+            float z_extent{ bounds.max_z - bounds.min_z };
+
+            Axis chosen_axis{ Axis::Z };
+            float largest_extent{ z_extent };
+            if (x_extent > largest_extent) {
+                chosen_axis = Axis::X;
+                largest_extent = x_extent;
+            }
+
+            // If our BVH node type is 2D (XZ plane), we will never choose
+            // the Y-axis, so we skip the following check.
+            if (type == BoundingBoxType::XYZ && y_extent > largest_extent) {
+                chosen_axis = Axis::Y;
+            }
+
+            return chosen_axis;
+        }
+
+        float get_centroid(const BoundingBox& box, Axis axis) {
+            if (axis == Axis::X) {
+                return box.centroid.x;
+            } else if (axis == Axis::Y) {
+                return box.centroid.y;
+            }
+            return box.centroid.z;
+        }
+
+        /**
+         * A bin of the binned SAH builder
+         */
+        struct Bin {
+            BoundingBox box{};
+            uint32_t count{ 0 };
+
+            void add(const BoundingBox& other) {
+                box = count == 0 ? other : BoundingBox::merge(box, other);
+                ++count;
+            }
+
+            void add(const Bin& other) {
+                if (other.count == 0) {
+                    return;
+                }
+                box = count == 0 ? other.box :
+                                   BoundingBox::merge(box, other.box);
+                count += other.count;
+            }
+        };
+
+        // ranges at least this large have their bounds and bins computed
+        // across all threads of a pool
+        constexpr uint32_t PARALLEL_RANGE_SIZE{ 4096 };
+
+        // the parallel builder hands ranges of at most this many
+        // primitives to the pool as whole subtrees
+        constexpr uint32_t MIN_TASK_SIZE{ 256 };
+
+        /**
+         * A node in the top levels of a parallel build
+         */
+        struct TopNode {
+            uint32_t first{ 0 };
+            uint32_t count{ 0 };
+            BoundingBox box{};
+
+            // primitives in the left child, 0 for leaves and tasks
+            uint32_t left_count{ 0 };
+
+            // index of the left child in the top nodes
+            uint32_t left{ 0 };
+
+            // the subtree of this node is built as a single task
+            bool is_task{ false };
+            uint32_t task{ 0 };
+        };
+
+        uint32_t get_chunk_count(ThreadPool* pool, uint32_t count) {
+            if (!pool || count < PARALLEL_RANGE_SIZE) {
+                return 1;
+            }
+            return pool->get_thread_count();
+        }
+
+        /**
+         * Split a range into get_chunk_count contiguous chunks and call a
+         * function on each, in parallel if there is more than one
+         * @param pool Thread pool, or nullptr
+         * @param first First index of the range
+         * @param count Number of indices in the range
+         * @param function Function taking the index of the chunk and the
+         * first and one past the last index of the chunk
+         */
+        template<typename Function>
+        void for_each_chunk(ThreadPool* pool,
+                            uint32_t first,
+                            uint32_t count,
+                            Function&& function) {
+            const uint32_t chunk_count{ get_chunk_count(pool, count) };
+            auto run_chunk = [&](uint32_t chunk) {
+                auto bound = [&](uint32_t i) {
+                    return first + static_cast<uint32_t>(uint64_t{ count } * i /
+                                                         chunk_count);
+                };
+                function(chunk, bound(chunk), bound(chunk + 1));
+            };
+
+            if (chunk_count == 1) {
+                run_chunk(0);
+            } else {
+                pool->parallel_for(chunk_count, run_chunk);
+            }
+        }
+
+        /**
+         * Map a float to an unsigned integer with the same order
+         * @param value Value to map
+         * @return Key that sorts like the value
+         */
+        uint32_t get_ordered_key(float value) {
+            const auto bits{ std::bit_cast<uint32_t>(value) };
+            return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+        }
+
+        /**
+         * Find the key of a given rank with a radix select, one byte at a
+         * time, counting the keys of each chunk in parallel
+         * @param pool Thread pool, or nullptr
+         * @param keys Keys to select from
+         * @param rank Number of keys that come before the one to find
+         * @return Key of the given rank
+         */
+        uint32_t select_key(ThreadPool* pool,
+                            const std::vector<uint32_t>& keys,
+                            uint32_t rank) {
+            const auto count{ static_cast<uint32_t>(keys.size()) };
+            const uint32_t chunk_count{ get_chunk_count(pool, count) };
+            std::vector<std::array<uint32_t, 256>> histograms(chunk_count);
+            uint32_t prefix{ 0 };
+            uint32_t prefix_mask{ 0 };
+            for (int shift{ 24 }; shift >= 0; shift -= 8) {
+                for_each_chunk(
+                pool,
+                0,
+                count,
+                [&](uint32_t chunk, uint32_t chunk_begin, uint32_t chunk_end) {
+                    std::array<uint32_t, 256>& histogram{ histograms[chunk] };
+                    histogram.fill(0);
+                    for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                        if ((keys[i] & prefix_mask) == prefix) {
+                            ++histogram[(keys[i] >> shift) & 0xFFu];
+                        }
+                    }
+                });
+
+                // the byte of the selected key is the bucket its rank
+                // falls into
+                uint32_t byte{ 0 };
+                for (;; ++byte) {
+                    uint32_t bucket{ 0 };
+                    for (const auto& histogram : histograms) {
+                        bucket += histogram[byte];
+                    }
+                    if (rank < bucket) {
+                        break;
+                    }
+                    rank -= bucket;
+                }
+                prefix |= byte << shift;
+                prefix_mask |= 0xFFu << shift;
+            }
+            return prefix;
+        }
+
+        /**
+         * Stably partition a range of indices into three classes, in
+         * parallel if the range is large. Each chunk counts its classes,
+         * and then writes its indices to where its share of each class
+         * starts. As the partition is stable, the result does not depend
+         * on the chunking.
+         * @param pool Thread pool, or nullptr
+         * @param indices Indices to partition
+         * @param first First index of the range
+         * @param count Number of indices in the range
+         * @param classify Function taking a position in indices and
+         * returning its class, 0, 1 or 2
+         * @return Number of indices in each class
+         */
+        template<typename Classify>
+        std::array<uint32_t, 3> partition_stable(ThreadPool* pool,
+                                                 std::vector<uint32_t>&
+                                                 indices,
+                                                 uint32_t first,
+                                                 uint32_t count,
+                                                 Classify&& classify) {
+            const uint32_t chunk_count{ get_chunk_count(pool, count) };
+            std::vector<uint8_t> classes(count);
+            std::vector<std::array<uint32_t, 3>> chunk_counts(chunk_count);
+            for_each_chunk(
+            pool,
+            first,
+            count,
+            [&](uint32_t chunk, uint32_t chunk_begin, uint32_t chunk_end) {
+                std::array<uint32_t, 3> counts{};
+                for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                    const uint8_t type{ classify(i) };
+                    classes[i - first] = type;
+                    ++counts[type];
+                }
+                chunk_counts[chunk] = counts;
+            });
+
+            // each chunk writes after the earlier classes, and after the
+            // earlier chunks' share of its own class
+            std::array<uint32_t, 3> totals{};
+            for (const auto& counts : chunk_counts) {
+                for (int type{ 0 }; type < 3; ++type) {
+                    totals[type] += counts[type];
+                }
+            }
+            std::vector<std::array<uint32_t, 3>> offsets(chunk_count);
+            std::array<uint32_t, 3> next{ 0, totals[0], totals[0] + totals[1] };
+            for (uint32_t chunk{ 0 }; chunk < chunk_count; ++chunk) {
+                offsets[chunk] = next;
+                for (int type{ 0 }; type < 3; ++type) {
+                    next[type] += chunk_counts[chunk][type];
+                }
+            }
+
+            std::vector<uint32_t> partitioned(count);
+            for_each_chunk(
+            pool,
+            first,
+            count,
+            [&](uint32_t chunk, uint32_t chunk_begin, uint32_t chunk_end) {
+                std::array<uint32_t, 3>& offset{ offsets[chunk] };
+                for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                    partitioned[offset[classes[i - first]]++] = indices[i];
+                }
+            });
+            for_each_chunk(
+            pool,
+            first,
+            count,
+            [&](uint32_t, uint32_t chunk_begin, uint32_t chunk_end) {
+                std::copy(partitioned.begin() + (chunk_begin - first),
+                          partitioned.begin() + (chunk_end - first),
+                          indices.begin() + chunk_begin);
+            });
+            return totals;
+        }
+
+        // bits of a Morton code per axis, for 30 bits in total
+        constexpr uint32_t MORTON_BITS{ 10 };
+
+        // bits of a Morton code sorted by each pass of the radix sort
+        constexpr uint32_t RADIX_BITS{ 8 };
+        constexpr uint32_t RADIX_SIZE{ 1u << RADIX_BITS };
+
+        /**
+         * Spread the lower 10 bits of a value out to every third bit
+         * @param value Value to spread
+         * @return Spread value
+         */
+        uint32_t expand_bits(uint32_t value) {
+            value = (value * 0x00010001u) & 0xFF0000FFu;
+            value = (value * 0x00000101u) & 0x0F00F00Fu;
+            value = (value * 0x00000011u) & 0xC30C30C3u;
+            value = (value * 0x00000005u) & 0x49249249u;
+            return value;
+        }
+
+        /**
+         * Calculate the Morton code of a point, interleaving the bits of
+         * its quantized coordinates
+         * @param point Point in the unit cube
+         * @return 30-bit Morton code
+         */
+        uint32_t get_morton_code(const math::njVec3f& point) {
+            auto quantize = [](float x) {
+                constexpr auto scale{
+                    static_cast<float>((1u << MORTON_BITS) - 1)
+                };
+                return static_cast<uint32_t>(std::clamp(x * scale, 0.f, scale));
+            };
+            return expand_bits(quantize(point.x)) << 2 |
+                   expand_bits(quantize(point.y)) << 1 |
+                   expand_bits(quantize(point.z));
+        }
+
+        /**
+         * Sort keys of 30 bits together with their values, a digit at a
+         * time from the least significant one. Each pass counts the digits
+         * of every chunk, then scatters the chunks in parallel, so the
+         * sort is stable and the result independent of the chunking.
+         * @param keys Keys to sort
+         * @param values Values to reorder along with the keys
+         * @param pool Thread pool, or nullptr
+         */
+        void radix_sort(std::vector<uint32_t>& keys,
+                        std::vector<uint32_t>& values,
+                        ThreadPool* pool) {
+            const auto count{ static_cast<uint32_t>(keys.size()) };
+            const uint32_t chunk_count{ get_chunk_count(pool, count) };
+            std::vector<uint32_t> sorted_keys(count);
+            std::vector<uint32_t> sorted_values(count);
+
+            // per chunk, the number of keys with each digit, which then
+            // becomes where the chunk writes the next key with that digit
+            std::vector<uint32_t> offsets(chunk_count * RADIX_SIZE);
+            for (uint32_t shift{ 0 }; shift < 3 * MORTON_BITS;
+                 shift += RADIX_BITS) {
+                auto get_digit = [shift](uint32_t key) {
+                    return key >> shift & (RADIX_SIZE - 1);
+                };
+
+                std::ranges::fill(offsets, 0);
+                for_each_chunk(
+                pool,
+                0,
+                count,
+                [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+                    uint32_t* histogram{ &offsets[chunk * RADIX_SIZE] };
+                    for (uint32_t i{ begin }; i < end; ++i) {
+                        ++histogram[get_digit(keys[i])];
+                    }
+                });
+
+                // keys go after those with smaller digits, and after keys
+                // with the same digit in earlier chunks
+                uint32_t sum{ 0 };
+                for (uint32_t digit{ 0 }; digit < RADIX_SIZE; ++digit) {
+                    for (uint32_t chunk{ 0 }; chunk < chunk_count; ++chunk) {
+                        uint32_t& offset{ offsets[chunk * RADIX_SIZE + digit] };
+                        const uint32_t digit_count{ offset };
+                        offset = sum;
+                        sum += digit_count;
+                    }
+                }
+
+                for_each_chunk(
+                pool,
+                0,
+                count,
+                [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+                    uint32_t* offset{ &offsets[chunk * RADIX_SIZE] };
+                    for (uint32_t i{ begin }; i < end; ++i) {
+                        const uint32_t slot{ offset[get_digit(keys[i])]++ };
+                        sorted_keys[slot] = keys[i];
+                        sorted_values[slot] = values[i];
+                    }
+                });
+                keys.swap(sorted_keys);
+                values.swap(sorted_values);
+            }
+        }
+
+        /**
+         * Decide how to split a range of sorted Morton codes
+         * @param codes Sorted Morton codes
+         * @param first First index of the range
+         * @param count Number of codes in the range, at least 2
+         * @return Number of codes in the left child: those that share the
+         * first code's value of the highest bit in which the range differs.
+         * A range of equal codes is split in the middle.
+         */
+        uint32_t find_morton_split(const std::vector<uint32_t>& codes,
+                                   uint32_t first,
+                                   uint32_t count) {
+            const uint32_t first_code{ codes[first] };
+            const uint32_t last_code{ codes[first + count - 1] };
+            if (first_code == last_code) {
+                return count / 2;
+            }
+
+            const int prefix{ std::countl_zero(first_code ^ last_code) };
+            const auto begin{ codes.begin() + first };
+            const auto split{ std::partition_point(begin,
+                                                   begin + count,
+                                                   [&](uint32_t code) {
+                return std::countl_zero(first_code ^ code) > prefix;
+            }) };
+            return static_cast<uint32_t>(split - begin);
+        }
+    }  // namespace
+
+    BVH::BVH(const std::vector<Primitive>& primitives,
+             BoundingBoxType type,
+             const BVHBuildOptions& options) :
+        BVH{ primitives, type, options, nullptr } {}
+
+    BVH::BVH(const std::vector<Primitive>& primitives,
+             BoundingBoxType type,
+             const BVHBuildOptions& options,
+             ThreadPool& pool) :
+        BVH{ primitives, type, options, &pool } {}
+
+    BVH::BVH(const std::vector<Primitive>& primitives,
+             BoundingBoxType type,
+             const BVHBuildOptions& options,
+             ThreadPool* pool) :
+        primitives_{ primitives },
+        type_{ type },
+        options_{ options } {
+        if (primitives_.empty()) {
+            return;
+        }
+
+        const auto count{ static_cast<uint32_t>(primitives_.size()) };
+        primitive_indices_.resize(count);
+        for (uint32_t i{ 0 }; i < count; ++i) {
+            primitive_indices_[i] = i;
+            entity_to_primitive_[primitives_[i].first] = i;
+
+            const BoundingBox& box{ primitives_[i].second };
+            const math::njVec3f extent{ box.max_x - box.min_x,
+                                        box.max_y - box.min_y,
+                                        box.max_z - box.min_z };
+            query_extent_ = query_extent_ + extent;
+        }
+        query_extent_ = query_extent_ * (1.f / static_cast<float>(count));
+
+        // a binary tree has at most 2n - 1 nodes
+        nodes_.reserve(2 * count - 1);
+        if (options_.builder == BVHBuilder::Morton) {
+            build_morton(pool);
+        } else if (pool && pool->get_thread_count() > 1) {
+            build_parallel(*pool);
+        } else {
+            nodes_.emplace_back();
+            build(nodes_, 0, 0, count);
+        }
+        build_cost_ = get_cost();
+    }
+
+    void BVH::build(std::vector<BVHNode>& nodes,
+                    uint32_t node,
+                    uint32_t first,
+                    uint32_t count) {
+        const BoundingBox bounds{ get_bounds(first, count, nullptr) };
+        const uint32_t left_count{ partition(bounds, first, count, nullptr) };
+        if (left_count == 0) {
+            nodes[node] = { .box = bounds,
+                            .left_or_first = first,
+                            .count = count };
+            return;
+        }
+
+        // children are allocated as an adjacent pair
+        const auto left{ static_cast<uint32_t>(nodes.size()) };
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[node] = { .box = bounds, .left_or_first = left, .count = 0 };
+
+        build(nodes, left, first, left_count);
+        build(nodes, left + 1, first + left_count, count - left_count);
+    }
+
+    void BVH::build_parallel(ThreadPool& pool) {
+        const auto count{ static_cast<uint32_t>(primitives_.size()) };
+        const uint32_t thread_count{ pool.get_thread_count() };
+
+        // leave a few tasks per thread, so that uneven subtrees even out
+        const uint32_t task_size{ std::max(count / (4 * thread_count),
+                                           MIN_TASK_SIZE) };
+
+        // split the top of the tree one level at a time. Partitioning a
+        // range only reorders that range, so the nodes of a level are
+        // independent of each other.
+        std::vector<TopNode> top{ { .first = 0, .count = count } };
+        uint32_t task_count{ 0 };
+        size_t level_begin{ 0 };
+        while (level_begin < top.size()) {
+            const size_t level_end{ top.size() };
+            const auto level_size{ static_cast<uint32_t>(level_end -
+                                                         level_begin) };
+            auto split = [&](uint32_t i, ThreadPool* range_pool) {
+                TopNode& node{ top[level_begin + i] };
+                if (node.count <= task_size) {
+                    node.is_task = true;
+                    return;
+                }
+                node.box = get_bounds(node.first, node.count, range_pool);
+                node.left_count =
+                partition(node.box, node.first, node.count, range_pool);
+            };
+
+            if (level_size < thread_count) {
+                // too few nodes to go around, so split each one's range
+                // across the threads instead
+                for (uint32_t i{ 0 }; i < level_size; ++i) {
+                    split(i, &pool);
+                }
+            } else {
+                pool.parallel_for(level_size,
+                                  [&](uint32_t i) { split(i, nullptr); });
+            }
+
+            for (size_t i{ level_begin }; i < level_end; ++i) {
+                const TopNode node{ top[i] };
+                if (node.is_task) {
+                    top[i].task = task_count++;
+                } else if (node.left_count > 0) {
+                    top[i].left = static_cast<uint32_t>(top.size());
+                    top.push_back({ .first = node.first,
+                                    .count = node.left_count });
+                    top.push_back({ .first = node.first + node.left_count,
+                                    .count = node.count - node.left_count });
+                }
+            }
+            level_begin = level_end;
+        }
+
+        // build the subtrees below the top, each into its own node array
+        // with its root at 0
+        std::vector<const TopNode*> tasks(task_count);
+        for (const TopNode& node : top) {
+            if (node.is_task) {
+                tasks[node.task] = &node;
+            }
+        }
+        std::vector<std::vector<BVHNode>> subtrees(task_count);
+        pool.parallel_for(task_count, [&](uint32_t i) {
+            std::vector<BVHNode>& nodes{ subtrees[i] };
+            nodes.reserve(2 * tasks[i]->count - 1);
+            nodes.emplace_back();
+            build(nodes, 0, tasks[i]->first, tasks[i]->count);
+        });
+
+        // assemble the tree depth first, left before right, which
+        // allocates nodes in the same order as the serial build
+        nodes_.emplace_back();
+        std::vector<std::pair<uint32_t, uint32_t>> stack{ { 0, 0 } };
+        while (!stack.empty()) {
+            const auto [index, slot]{ stack.back() };
+            stack.pop_back();
+            const TopNode& node{ top[index] };
+
+            if (node.is_task) {
+                // the descendants of the subtree's root follow on from the
+                // end of the array, so only internal links need shifting
+                const std::vector<BVHNode>& subtree{ subtrees[node.task] };
+                const auto offset{ static_cast<uint32_t>(nodes_.size()) - 1 };
+                auto relocate = [offset](BVHNode moved) {
+                    if (!moved.is_leaf()) {
+                        moved.left_or_first += offset;
+                    }
+                    return moved;
+                };
+                nodes_[slot] = relocate(subtree.front());
+                for (size_t i{ 1 }; i < subtree.size(); ++i) {
+                    nodes_.push_back(relocate(subtree[i]));
+                }
+            } else if (node.left_count == 0) {
+                nodes_[slot] = { .box = node.box,
+                                 .left_or_first = node.first,
+                                 .count = node.count };
+            } else {
+                const auto left{ static_cast<uint32_t>(nodes_.size()) };
+                nodes_.emplace_back();
+                nodes_.emplace_back();
+                nodes_[slot] = { .box = node.box,
+                                 .left_or_first = left,
+                                 .count = 0 };
+                stack.emplace_back(node.left + 1, left + 1);
+                stack.emplace_back(node.left, left);
+            }
+        }
+    }
+
+    BoundingBox BVH::get_bounds(uint32_t first,
+                                uint32_t count,
+                                ThreadPool* pool) const {
+        auto merge_range = [this](uint32_t begin, uint32_t end) {
+            BoundingBox bounds{ primitives_[primitive_indices_[begin]].second };
+            for (uint32_t i{ begin + 1 }; i < end; ++i) {
+                bounds = BoundingBox::merge(bounds,
+                                            primitives_[primitive_indices_[i]]
+                                            .second);
+            }
+            return bounds;
+        };
+
+        const uint32_t chunk_count{ get_chunk_count(pool, count) };
+        if (chunk_count == 1) {
+            return merge_range(first, first + count);
+        }
+
+        // merging only takes minima and maxima, so the result does not
+        // depend on how the range is chunked
+        std::vector<BoundingBox> chunk_bounds(chunk_count);
+        for_each_chunk(pool,
+                       first,
+                       count,
+                       [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+                           chunk_bounds[chunk] = merge_range(begin, end);
+                       });
+
+        BoundingBox bounds{ chunk_bounds.front() };
+        for (uint32_t i{ 1 }; i < chunk_count; ++i) {
+            bounds = BoundingBox::merge(bounds, chunk_bounds[i]);
+        }
+        return bounds;
+    }
+
+    void BVH::build_morton(ThreadPool* pool) {
+        const auto count{ static_cast<uint32_t>(primitives_.size()) };
+
+        // centroids are quantized within their bounds
+        const uint32_t chunk_count{ get_chunk_count(pool, count) };
+        std::vector<math::njVec3f> chunk_min(chunk_count);
+        std::vector<math::njVec3f> chunk_max(chunk_count);
+        for_each_chunk(
+        pool,
+        0,
+        count,
+        [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+            math::njVec3f min{ primitives_[begin].second.centroid };
+            math::njVec3f max{ min };
+            for (uint32_t i{ begin + 1 }; i < end; ++i) {
+                const math::njVec3f& centroid{ primitives_[i].second.centroid };
+                for (int axis{ 0 }; axis < 3; ++axis) {
+                    min[axis] = std::min(min[axis], centroid[axis]);
+                    max[axis] = std::max(max[axis], centroid[axis]);
+                }
+            }
+            chunk_min[chunk] = min;
+            chunk_max[chunk] = max;
+        });
+        math::njVec3f min{ chunk_min.front() };
+        math::njVec3f scale{};
+        for (int axis{ 0 }; axis < 3; ++axis) {
+            float max{ chunk_max.front()[axis] };
+            for (uint32_t chunk{ 1 }; chunk < chunk_count; ++chunk) {
+                min[axis] = std::min(min[axis], chunk_min[chunk][axis]);
+                max = std::max(max, chunk_max[chunk][axis]);
+            }
+            const float extent{ max - min[axis] };
+            scale[axis] = extent > 0.f ? 1.f / extent : 0.f;
+        }
+        // a 2D tree has no use for Y in its codes
+        if (type_ == BoundingBoxType::XZ) {
+            scale.y = 0.f;
+        }
+
+        std::vector<uint32_t> codes(count);
+        for_each_chunk(
+        pool,
+        0,
+        count,
+        [&](uint32_t, uint32_t begin, uint32_t end) {
+            for (uint32_t i{ begin }; i < end; ++i) {
+                const math::njVec3f offset{ primitives_[i].second.centroid -
+                                            min };
+                codes[i] = get_morton_code(offset * scale);
+            }
+        });
+        radix_sort(codes, primitive_indices_, pool);
+
+        // emit the nodes one level at a time. Each node of a level only
+        // needs its own range to find its split, so the nodes of a level
+        // are emitted independently, with their children allocated after
+        // the level as adjacent pairs.
+        struct Range {
+            uint32_t first{ 0 };
+            uint32_t count{ 0 };
+        };
+        std::vector<Range> ranges{ { .first = 0, .count = count } };
+        std::vector<Range> next_ranges{};
+        std::vector<uint32_t> left_counts{};
+        std::vector<uint32_t> children{};
+        std::vector<uint32_t> level_begins{};
+        nodes_.emplace_back();
+        uint32_t level_begin{ 0 };
+        while (level_begin < nodes_.size()) {
+            const auto level_end{ static_cast<uint32_t>(nodes_.size()) };
+            const uint32_t level_size{ level_end - level_begin };
+            level_begins.push_back(level_begin);
+
+            left_counts.resize(level_size);
+            for_each_chunk(
+            pool,
+            0,
+            level_size,
+            [&](uint32_t, uint32_t begin, uint32_t end) {
+                for (uint32_t i{ begin }; i < end; ++i) {
+                    const Range range{ ranges[i] };
+                    left_counts[i] =
+                    range.count > 1
+                    ? find_morton_split(codes, range.first, range.count)
+                    : 0;
+                }
+            });
+
+            children.resize(level_size);
+            uint32_t next{ level_end };
+            for (uint32_t i{ 0 }; i < level_size; ++i) {
+                children[i] = next;
+                next += left_counts[i] > 0 ? 2 : 0;
+            }
+            nodes_.resize(next);
+            next_ranges.resize(next - level_end);
+
+            for_each_chunk(
+            pool,
+            0,
+            level_size,
+            [&](uint32_t, uint32_t begin, uint32_t end) {
+                for (uint32_t i{ begin }; i < end; ++i) {
+                    const Range range{ ranges[i] };
+                    const uint32_t left_count{ left_counts[i] };
+                    BVHNode& node{ nodes_[level_begin + i] };
+                    if (left_count == 0) {
+                        node = { .left_or_first = range.first,
+                                 .count = range.count };
+                        continue;
+                    }
+                    node = { .left_or_first = children[i], .count = 0 };
+                    const uint32_t child{ children[i] - level_end };
+                    next_ranges[child] = { .first = range.first,
+                                           .count = left_count };
+                    next_ranges[child + 1] = {
+                        .first = range.first + left_count,
+                        .count = range.count - left_count
+                    };
+                }
+            });
+            ranges.swap(next_ranges);
+            level_begin = level_end;
+        }
+
+        // fit the boxes one level at a time from the bottom, as every
+        // child is in the level below its parent
+        level_begins.push_back(static_cast<uint32_t>(nodes_.size()));
+        for (size_t level{ level_begins.size() - 1 }; level-- > 0;) {
+            const uint32_t first{ level_begins[level] };
+            for_each_chunk(
+            pool,
+            first,
+            level_begins[level + 1] - first,
+            [&](uint32_t, uint32_t begin, uint32_t end) {
+                for (uint32_t i{ begin }; i < end; ++i) {
+                    BVHNode& node{ nodes_[i] };
+                    if (node.is_leaf()) {
+                        node.box = get_bounds(node.left_or_first,
+                                              node.count,
+                                              nullptr);
+                        continue;
+                    }
+                    node.box =
+                    BoundingBox::merge(nodes_[node.left_or_first].box,
+                                       nodes_[node.left_or_first + 1].box);
+                }
+            });
+        }
+    }
+
+    uint32_t BVH::partition(const BoundingBox& bounds,
+                            uint32_t first,
+                            uint32_t count,
+                            ThreadPool* pool) {
+        if (count <= 1) {
+            return 0;
+        }
+        if (options_.builder == BVHBuilder::BinnedSAH) {
+            return partition_sah(bounds, first, count, pool);
+        }
+        return partition_median(bounds, first, count, pool);
+    }
+
+    uint32_t BVH::partition_median(const BoundingBox& bounds,
+                                   uint32_t first,
+                                   uint32_t count,
+                                   ThreadPool* pool) {
+        // we partition such that each side has an equal number of
+        // primitives, split at the median centroid along the partition axis
+        const Axis axis{ choose_partition_axis(bounds, type_) };
+        const uint32_t half{ count / 2 };
+
+        // large ranges select the median and partition around it in
+        // parallel. They do so with or without a pool, so that serial and
+        // parallel builds make the same tree.
+        if (count >= PARALLEL_RANGE_SIZE) {
+            std::vector<uint32_t> keys(count);
+            for_each_chunk(
+            pool,
+            0,
+            count,
+            [&](uint32_t, uint32_t chunk_begin, uint32_t chunk_end) {
+                for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                    const BoundingBox& box{
+                        primitives_[primitive_indices_[first + i]].second
+                    };
+                    keys[i] = get_ordered_key(get_centroid(box, axis));
+                }
+            });
+            const uint32_t median{ select_key(pool, keys, half) };
+
+            // keys equal to the median come right after the smaller ones,
+            // so the first half of the range is the left child either way
+            partition_stable(pool,
+                             primitive_indices_,
+                             first,
+                             count,
+                             [&](uint32_t i) -> uint8_t {
+                                 const uint32_t key{ keys[i - first] };
+                                 return key < median ? 0 : key == median ? 1
+                                                                         : 2;
+                             });
+            return half;
         }
+
+        auto begin{ primitive_indices_.begin() + first };
+        std::nth_element(begin,
+                         begin + half,
+                         begin + count,
+                         [this, axis](uint32_t a, uint32_t b) {
+                             return get_centroid(primitives_[a].second, axis) <
+                                    get_centroid(primitives_[b].second, axis);
+                         });
+        return half;
+    }
+
+    uint32_t BVH::partition_sah(const BoundingBox& bounds,
+                                uint32_t first,
+                                uint32_t count,
+                                ThreadPool* pool) {
+        auto begin{ primitive_indices_.begin() + first };
+        auto end{ begin + count };
+
+        std::vector<Axis> axes{ Axis::X, Axis::Z };
+        if (type_ == BoundingBoxType::XYZ) {
+            axes.push_back(Axis::Y);
+        }
+        const auto axis_count{ static_cast<uint32_t>(axes.size()) };
+        const uint32_t bin_count{ std::max(options_.bin_count, 2u) };
+        const uint32_t chunk_count{ get_chunk_count(pool, count) };
+
+        // bins are spread over the centroids, not over the boxes
+        std::vector<math::njVec3f> chunk_min(chunk_count);
+        std::vector<math::njVec3f> chunk_max(chunk_count);
+        for_each_chunk(
+        pool,
+        first,
+        count,
+        [&](uint32_t chunk, uint32_t chunk_begin, uint32_t chunk_end) {
+            math::njVec3f min{
+                primitives_[primitive_indices_[chunk_begin]].second.centroid
+            };
+            math::njVec3f max{ min };
+            for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                const math::njVec3f& centroid{
+                    primitives_[primitive_indices_[i]].second.centroid
+                };
+                for (int axis{ 0 }; axis < 3; ++axis) {
+                    min[axis] = std::min(min[axis], centroid[axis]);
+                    max[axis] = std::max(max[axis], centroid[axis]);
+                }
+            }
+            chunk_min[chunk] = min;
+            chunk_max[chunk] = max;
+        });
+        math::njVec3f centroid_min{ chunk_min.front() };
+        math::njVec3f centroid_max{ chunk_max.front() };
+        for (uint32_t chunk{ 1 }; chunk < chunk_count; ++chunk) {
+            for (int axis{ 0 }; axis < 3; ++axis) {
+                centroid_min[axis] = std::min(centroid_min[axis],
+                                              chunk_min[chunk][axis]);
+                centroid_max[axis] = std::max(centroid_max[axis],
+                                              chunk_max[chunk][axis]);
+            }
+        }
+
+        // bin every axis in one pass. Each chunk fills its own bins, which
+        // are then merged in order; merging bins is exact, so the bins do
+        // not depend on the chunking.
+        math::njVec3f bin_scale{};
+        for (int axis{ 0 }; axis < 3; ++axis) {
+            const float extent{ centroid_max[axis] - centroid_min[axis] };
+            if (extent > 0.f) {
+                bin_scale[axis] = static_cast<float>(bin_count) / extent;
+            }
+        }
+        auto get_bin = [&](Axis axis, float centroid) {
+            const auto index{ static_cast<int>(axis) };
+            return std::min(bin_count - 1,
+                            static_cast<uint32_t>(
+                            (centroid - centroid_min[index]) *
+                            bin_scale[index]));
+        };
+        std::vector<std::vector<Bin>> chunk_bins(
+        chunk_count,
+        std::vector<Bin>(axis_count * bin_count));
+        for_each_chunk(
+        pool,
+        first,
+        count,
+        [&](uint32_t chunk, uint32_t chunk_begin, uint32_t chunk_end) {
+            std::vector<Bin>& bins{ chunk_bins[chunk] };
+            for (uint32_t a{ 0 }; a < axis_count; ++a) {
+                if (bin_scale[static_cast<int>(axes[a])] == 0.f) {
+                    continue;
+                }
+                for (uint32_t i{ chunk_begin }; i < chunk_end; ++i) {
+                    const BoundingBox& box{
+                        primitives_[primitive_indices_[i]].second
+                    };
+                    bins[a * bin_count +
+                         get_bin(axes[a], get_centroid(box, axes[a]))]
+                    .add(box);
+                }
+            }
+        });
+        std::vector<Bin>& bins{ chunk_bins.front() };
+        for (uint32_t chunk{ 1 }; chunk < chunk_count; ++chunk) {
+            for (size_t i{ 0 }; i < bins.size(); ++i) {
+                bins[i].add(chunk_bins[chunk][i]);
+            }
+        }
+
+        float parent_measure{ get_hit_measure(bounds) };
+        if (parent_measure <= 0.f) {
+            parent_measure = 1.f;
+        }
+
+        float best_cost{ std::numeric_limits<float>::infinity() };
+        Axis best_axis{ Axis::X };
+        uint32_t best_split{ 0 };
+        std::vector<float> right_measures(bin_count);
+        std::vector<uint32_t> right_counts(bin_count);
+        for (uint32_t a{ 0 }; a < axis_count; ++a) {
+            const Axis axis{ axes[a] };
+            if (bin_scale[static_cast<int>(axis)] == 0.f) {
+                continue;
+            }
+            const Bin* axis_bins{ bins.data() + a * bin_count };
+
+            // sweep from the right, accumulating everything right of a plane
+            Bin right{};
+            for (uint32_t i{ bin_count - 1 }; i > 0; --i) {
+                if (axis_bins[i].count > 0) {
+                    right.box = right.count == 0 ?
+                                axis_bins[i].box :
+                                BoundingBox::merge(right.box, axis_bins[i].box);
+                    right.count += axis_bins[i].count;
+                }
+                right_measures[i] = get_hit_measure(right.box);
+                right_counts[i] = right.count;
+            }
+
+            // then from the left, evaluating the plane after each bin
+            Bin left{};
+            for (uint32_t i{ 1 }; i < bin_count; ++i) {
+                if (axis_bins[i - 1].count > 0) {
+                    left.box = left.count == 0 ?
+                               axis_bins[i - 1].box :
+                               BoundingBox::merge(left.box,
+                                                  axis_bins[i - 1].box);
+                    left.count += axis_bins[i - 1].count;
+                }
+                if (left.count == 0 || right_counts[i] == 0) {
+                    continue;
+                }
+                const float cost{
+                    options_.traversal_cost +
+                    options_.intersection_cost *
+                    (get_hit_measure(left.box) * left.count +
+                     right_measures[i] * right_counts[i]) /
+                    parent_measure
+                };
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_split = i;
+                }
+            }
+        }
+
+        const bool fits_leaf{ count <= options_.max_leaf_size };
+        if (best_split == 0) {
+            // all centroids coincide, so no plane separates them
+            return fits_leaf ? 0
+                             : partition_median(bounds, first, count, pool);
+        }
+        const float leaf_cost{ options_.intersection_cost *
+                               static_cast<float>(count) };
+        if (fits_leaf && leaf_cost <= best_cost) {
+            return 0;
+        }
+
+        auto is_left = [&](uint32_t primitive) {
+            const float centroid{
+                get_centroid(primitives_[primitive].second, best_axis)
+            };
+            return get_bin(best_axis, centroid) < best_split;
+        };
+
+        // like the median split, large ranges are partitioned in parallel
+        // whether there is a pool or not
+        if (count >= PARALLEL_RANGE_SIZE) {
+            return partition_stable(pool,
+                                    primitive_indices_,
+                                    first,
+                                    count,
+                                    [&](uint32_t i) -> uint8_t {
+                                        return is_left(primitive_indices_[i])
+                                               ? 0
+                                               : 2;
+                                    })[0];
+        }
+        auto middle{ std::partition(begin, end, is_left) };
+
+        return static_cast<uint32_t>(middle - begin);
+    }
+
+    float BVH::get_hit_measure(const BoundingBox& box) const {
+        float x{ box.max_x - box.min_x };
+        float y{ box.max_y - box.min_y };
+        float z{ box.max_z - box.min_z };
+
+        if (options_.cost == SAHCost::Ray) {
+            // half the surface area (perimeter in 2D)
+            if (type_ == BoundingBoxType::XZ) {
+                return x + z;
+            }
+            return x * y + y * z + z * x;
+        }
+
+        // volume (area in 2D) of the box grown by an average query box,
+        // i.e. the region a query's centre must be in to overlap the box
+        x += query_extent_.x;
+        y += query_extent_.y;
+        z += query_extent_.z;
+        if (type_ == BoundingBoxType::XZ) {
+            return x * z;
+        }
+        return x * y * z;
     }
 
     const BVHNode* BVH::get_root() const {
-        return root_.get();
+        if (nodes_.empty()) {
+            return nullptr;
+        }
+        return &nodes_.front();
+    }
+
+    const std::vector<BVHNode>& BVH::get_nodes() const {
+        return nodes_;
+    }
+
+    const std::vector<Primitive>& BVH::get_primitives() const {
+        return primitives_;
+    }
+
+    const std::vector<uint32_t>& BVH::get_primitive_indices() const {
+        return primitive_indices_;
+    }
+
+    const BVHNode* BVH::get_left(const BVHNode& node) const {
+        if (node.is_leaf()) {
+            return nullptr;
+        }
+        return &nodes_[node.left_or_first];
+    }
+
+    const BVHNode* BVH::get_right(const BVHNode& node) const {
+        if (node.is_leaf()) {
+            return nullptr;
+        }
+        return &nodes_[node.left_or_first + 1];
+    }
+
+    std::vector<EntityId> BVH::get_entities(const BVHNode& node) const {
+        // the primitives beneath a node are contiguous in the index array,
+        // from the first of its leftmost leaf to the end of its rightmost
+        const BVHNode* leftmost{ &node };
+        while (!leftmost->is_leaf()) {
+            leftmost = &nodes_[leftmost->left_or_first];
+        }
+        const BVHNode* rightmost{ &node };
+        while (!rightmost->is_leaf()) {
+            rightmost = &nodes_[rightmost->left_or_first + 1];
+        }
+
+        std::vector<EntityId> entities{};
+        for (uint32_t i{ leftmost->left_or_first };
+             i < rightmost->left_or_first + rightmost->count;
+             ++i) {
+            entities.push_back(primitives_[primitive_indices_[i]].first);
+        }
+        return entities;
+    }
+
+    bool BVH::contains(EntityId entity) const {
+        return entity_to_primitive_.contains(entity);
+    }
+
+    size_t BVH::size() const {
+        return primitives_.size();
     }
 
     std::vector<EntityId> BVH::get_entities() const {
-        return root_->get_entities();
+        std::vector<EntityId> entities{};
+        entities.reserve(primitives_.size());
+        for (const auto& [entity, box] : primitives_) {
+            entities.push_back(entity);
+        }
+        return entities;
+    }
+
+    bool BVH::does_overlap(const BVHNode& a, const BVHNode& b) const {
+        return a.box.does_overlap(b.box, type_);
+    }
+
+    template<typename Function>
+    void BVH::for_each_overlap(const BoundingBox& box,
+                               Function&& function) const {
+        if (nodes_.empty()) {
+            return;
+        }
+
+        // explicit stack of node indices instead of recursion
+        std::vector<uint32_t> stack{};
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const BVHNode& node{ nodes_[stack.back()] };
+            stack.pop_back();
+            if (!node.box.does_overlap(box, type_)) {
+                continue;
+            }
+
+            if (node.is_leaf()) {
+                for (uint32_t i{ node.left_or_first };
+                     i < node.left_or_first + node.count;
+                     ++i) {
+                    const uint32_t primitive{ primitive_indices_[i] };
+                    if (primitives_[primitive].second.does_overlap(box,
+                                                                   type_)) {
+                        function(primitive);
+                    }
+                }
+            } else {
+                // right first, so that leaves are visited left to right
+                stack.push_back(node.left_or_first + 1);
+                stack.push_back(node.left_or_first);
+            }
+        }
     }
 
     std::vector<EntityId> BVH::get_overlaps(EntityId entity) const {
-        // we know that the entity (the BVHNode that represents it)
-        // always overlaps the root node by definition, since
-        // the root node contains all bounding boxes by definition,
-        // so we can skip checking the root node
-
-        const BVHNode* entity_node{ entity_to_node_.at(entity) };
-        std::vector<const BVHNode*> overlapping_leaves{
-            root_->get_overlapping_leaves(*entity_node)
-        };
+        const uint32_t self{ entity_to_primitive_.at(entity) };
 
         std::vector<EntityId> result{};
-        for (const BVHNode* leaf_node : overlapping_leaves) {
-            EntityId this_entity{ leaf_node->get_entities().at(0) };
-            if (this_entity != entity) {
-                result.push_back(leaf_node->get_entities().at(0));
+        for_each_overlap(primitives_[self].second, [&](uint32_t primitive) {
+            if (primitive != self) {
+                result.push_back(primitives_[primitive].first);
             }
-        }
+        });
 
         return result;
     }
 
-    BoundingBox BVH::get_bounding_box(EntityId entity) const {
-        const BVHNode* node{ entity_to_node_.at(entity) };
-        return node->get_bounding_box();
+    std::vector<EntityId> BVH::get_overlaps(const BoundingBox& box) const {
+        std::vector<EntityId> result{};
+        for_each_overlap(box, [&](uint32_t primitive) {
+            result.push_back(primitives_[primitive].first);
+        });
+
+        return result;
     }
 
-    OverlappingPairs get_overlapping_pairs(const BVH& bvh) {
-        // get all overlapping entity pairs
-        std::vector<EntityId> entities{ bvh.get_entities() };
-        OverlappingPairs overlapping{};
-        for (EntityId this_entity : entities) {
-            std::vector<EntityId> overlapping_entities{
-                bvh.get_overlaps(this_entity)
+    std::optional<CastHit> BVH::cast(const BoundingBox& box,
+                                    const math::njVec3f& displacement,
+                                    CastMode mode,
+                                    std::optional<EntityId> ignored) const {
+        std::optional<CastHit> first{};
+        if (nodes_.empty()) {
+            return first;
+        }
+
+        // node indices with the time the box reaches them
+        std::vector<std::pair<uint32_t, float>> stack{};
+        stack.reserve(64);
+        const auto root_hit{ sweep(box, displacement, nodes_[0].box, type_) };
+        if (!root_hit) {
+            return first;
+        }
+        stack.emplace_back(0, root_hit->time);
+        while (!stack.empty()) {
+            const auto [index, time]{ stack.back() };
+            stack.pop_back();
+            // a closer hit has been found since the node was pushed
+            if (first && time >= first->hit.time) {
+                continue;
+            }
+
+            const BVHNode& node{ nodes_[index] };
+            if (node.is_leaf()) {
+                for (uint32_t i{ node.left_or_first };
+                     i < node.left_or_first + node.count;
+                     ++i) {
+                    const auto& [entity, primitive_box]{
+                        primitives_[primitive_indices_[i]]
+                    };
+                    if (entity == ignored) {
+                        continue;
+                    }
+                    const auto hit{
+                        sweep(box, displacement, primitive_box, type_)
+                    };
+                    if (!hit || (first && hit->time >= first->hit.time)) {
+                        continue;
+                    }
+                    first = CastHit{ .entity = entity, .hit = *hit };
+                    if (mode == CastMode::Any) {
+                        return first;
+                    }
+                }
+                continue;
+            }
+
+            const uint32_t left{ node.left_or_first };
+            const uint32_t right{ left + 1 };
+            const auto left_hit{
+                sweep(box, displacement, nodes_[left].box, type_)
+            };
+            const auto right_hit{
+                sweep(box, displacement, nodes_[right].box, type_)
             };
-            for (EntityId other_entity : overlapping_entities) {
-                // Let (A, B) mean that entity A overlaps entity B
-                // Then (B, A) is true as well -> (A, B) is the same as (B, A)
-                // We avoid inserting such duplicates
-                if (!overlapping.contains({ other_entity, this_entity })) {
-                    overlapping.insert({ this_entity, other_entity });
+            // the nearer child goes on top, so that it is visited first
+            // and its hits can rule out the farther one
+            const bool is_right_nearer{ left_hit && right_hit &&
+                                        right_hit->time < left_hit->time };
+            if (is_right_nearer) {
+                stack.emplace_back(left, left_hit->time);
+                stack.emplace_back(right, right_hit->time);
+                continue;
+            }
+            if (right_hit) {
+                stack.emplace_back(right, right_hit->time);
+            }
+            if (left_hit) {
+                stack.emplace_back(left, left_hit->time);
+            }
+        }
+        return first;
+    }
+
+    BoundingBox BVH::get_bounding_box(EntityId entity) const {
+        return primitives_[entity_to_primitive_.at(entity)].second;
+    }
+
+    BoundingBoxType BVH::get_type() const {
+        return type_;
+    }
+
+    float BVH::get_cost() const {
+        if (nodes_.empty()) {
+            return 0.f;
+        }
+
+        float root_measure{ get_hit_measure(nodes_.front().box) };
+        if (root_measure <= 0.f) {
+            root_measure = 1.f;
+        }
+
+        // every node is visited with a probability relative to the root
+        float cost{ 0.f };
+        for (const BVHNode& node : nodes_) {
+            const float probability{ get_hit_measure(node.box) / root_measure };
+            if (node.is_leaf()) {
+                cost += probability * options_.intersection_cost *
+                        static_cast<float>(node.count);
+            } else {
+                cost += probability * options_.traversal_cost;
+            }
+        }
+        return cost;
+    }
+
+    void BVH::refit(const std::vector<Primitive>& primitives) {
+        for (const auto& [entity, box] : primitives) {
+            primitives_[entity_to_primitive_.at(entity)].second = box;
+        }
+
+        // children are always stored after their parent, so walking the
+        // nodes backwards refits every child before its parent
+        for (size_t i{ nodes_.size() }; i-- > 0;) {
+            BVHNode& node{ nodes_[i] };
+            if (node.is_leaf()) {
+                node.box = primitives_[primitive_indices_[node.left_or_first]]
+                           .second;
+                for (uint32_t j{ node.left_or_first + 1 };
+                     j < node.left_or_first + node.count;
+                     ++j) {
+                    node.box = BoundingBox::merge(node.box,
+                                                  primitives_
+                                                  [primitive_indices_[j]]
+                                                  .second);
                 }
+            } else {
+                node.box = BoundingBox::merge(nodes_[node.left_or_first].box,
+                                              nodes_[node.left_or_first + 1]
+                                              .box);
             }
         }
+    }
 
-        return overlapping;
+    float BVH::get_degradation() const {
+        if (build_cost_ <= 0.f) {
+            return 1.f;
+        }
+        return get_cost() / build_cost_;
+    }
+
+    void BVH::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        pairs.clear();
+        if (nodes_.empty()) {
+            return;
+        }
+
+        auto test_primitives = [&](uint32_t a, uint32_t b) {
+            const Primitive& first{ primitives_[primitive_indices_[a]] };
+            const Primitive& second{ primitives_[primitive_indices_[b]] };
+            if (first.second.does_overlap(second.second, type_)) {
+                pairs.push_back(make_entity_pair(first.first, second.first));
+            }
+        };
+
+        // pairs of nodes whose subtrees still have to be tested against
+        // each other. A node paired with itself stands for the pairs
+        // within its own subtree.
+        std::vector<std::pair<uint32_t, uint32_t>> stack{};
+        stack.reserve(64);
+        stack.emplace_back(0, 0);
+        while (!stack.empty()) {
+            const auto [a, b]{ stack.back() };
+            stack.pop_back();
+            const BVHNode& first{ nodes_[a] };
+            const BVHNode& second{ nodes_[b] };
+
+            if (a == b) {
+                if (first.is_leaf()) {
+                    const uint32_t end{ first.left_or_first + first.count };
+                    for (uint32_t i{ first.left_or_first }; i < end; ++i) {
+                        for (uint32_t j{ i + 1 }; j < end; ++j) {
+                            test_primitives(i, j);
+                        }
+                    }
+                } else {
+                    const uint32_t left{ first.left_or_first };
+                    stack.emplace_back(left, left + 1);
+                    stack.emplace_back(left + 1, left + 1);
+                    stack.emplace_back(left, left);
+                }
+                continue;
+            }
+
+            if (!first.box.does_overlap(second.box, type_)) {
+                continue;
+            }
+
+            if (first.is_leaf() && second.is_leaf()) {
+                for (uint32_t i{ first.left_or_first };
+                     i < first.left_or_first + first.count;
+                     ++i) {
+                    for (uint32_t j{ second.left_or_first };
+                         j < second.left_or_first + second.count;
+                         ++j) {
+                        test_primitives(i, j);
+                    }
+                }
+            } else if (second.is_leaf() ||
+                       (!first.is_leaf() && get_hit_measure(first.box) >=
+                                            get_hit_measure(second.box))) {
+                // descend into the larger node, so both shrink evenly
+                stack.emplace_back(first.left_or_first, b);
+                stack.emplace_back(first.left_or_first + 1, b);
+            } else {
+                stack.emplace_back(a, second.left_or_first);
+                stack.emplace_back(a, second.left_or_first + 1);
+            }
+        }
     }
 
 }  // namespace njin::ecs::physics
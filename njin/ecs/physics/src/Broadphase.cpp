@@ -0,0 +1,216 @@
+#include "physics/Broadphase.h"
+
+#include <unordered_set>
+#include <utility>
+
+#include "physics/SpatialHash.h"
+#include "physics/SweepAndPrune.h"
+
+namespace njin::ecs::physics {
+    std::optional<CastHit>
+    Broadphase::cast(const BoundingBox& box,
+                     const math::njVec3f& displacement,
+                     CastMode mode,
+                     std::optional<EntityId> ignored) const {
+        std::optional<CastHit> first{};
+        const BoundingBox bounds{ get_swept_bounds(box, displacement) };
+        for (EntityId entity : get_overlaps(bounds)) {
+            if (entity == ignored) {
+                continue;
+            }
+            const auto hit{ sweep(box,
+                                  displacement,
+                                  get_bounding_box(entity),
+                                  get_type()) };
+            if (!hit || (first && hit->time >= first->hit.time)) {
+                continue;
+            }
+            first = CastHit{ .entity = entity, .hit = *hit };
+            if (mode == CastMode::Any) {
+                break;
+            }
+        }
+        return first;
+    }
+
+    BVHBroadphase::BVHBroadphase(BoundingBoxType type,
+                                 const BVHBuildOptions& options,
+                                 float max_degradation,
+                                 std::shared_ptr<ThreadPool> pool) :
+        options_{ options },
+        max_degradation_{ max_degradation },
+        pool_{ std::move(pool) },
+        bvh_{ {}, type, options } {}
+
+    void BVHBroadphase::update(const std::vector<Primitive>& primitives) {
+        // the topology can only be kept if the entities stay the same
+        bool same_entities{ bvh_.size() == primitives.size() };
+        for (const auto& [entity, box] : primitives) {
+            if (!same_entities) {
+                break;
+            }
+            same_entities = bvh_.contains(entity);
+        }
+
+        if (same_entities) {
+            bvh_.refit(primitives);
+            if (bvh_.get_degradation() <= max_degradation_) {
+                return;
+            }
+        }
+        if (pool_) {
+            bvh_ = BVH{ primitives, bvh_.get_type(), options_, *pool_ };
+        } else {
+            bvh_ = BVH{ primitives, bvh_.get_type(), options_ };
+        }
+    }
+
+    void BVHBroadphase::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        bvh_.get_overlapping_pairs(pairs);
+    }
+
+    std::vector<EntityId>
+    BVHBroadphase::get_overlaps(const BoundingBox& box) const {
+        return bvh_.get_overlaps(box);
+    }
+
+    BoundingBox BVHBroadphase::get_bounding_box(EntityId entity) const {
+        return bvh_.get_bounding_box(entity);
+    }
+
+    BoundingBoxType BVHBroadphase::get_type() const {
+        return bvh_.get_type();
+    }
+
+    std::optional<CastHit>
+    BVHBroadphase::cast(const BoundingBox& box,
+                        const math::njVec3f& displacement,
+                        CastMode mode,
+                        std::optional<EntityId> ignored) const {
+        return bvh_.cast(box, displacement, mode, ignored);
+    }
+
+    const BVH& BVHBroadphase::get_bvh() const {
+        return bvh_;
+    }
+
+    WideBVHBroadphase::WideBVHBroadphase(BoundingBoxType type,
+                                         const BVHBuildOptions& options,
+                                         float max_degradation,
+                                         std::shared_ptr<ThreadPool> pool) :
+        binary_{ type, options, max_degradation, std::move(pool) },
+        wide_{ {}, type } {}
+
+    void WideBVHBroadphase::update(const std::vector<Primitive>& primitives) {
+        binary_.update(primitives);
+        wide_ = BVH4{ binary_.get_bvh() };
+    }
+
+    void
+    WideBVHBroadphase::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        wide_.get_overlapping_pairs(pairs);
+    }
+
+    std::vector<EntityId>
+    WideBVHBroadphase::get_overlaps(const BoundingBox& box) const {
+        return wide_.get_overlaps(box);
+    }
+
+    BoundingBox WideBVHBroadphase::get_bounding_box(EntityId entity) const {
+        return wide_.get_bounding_box(entity);
+    }
+
+    BoundingBoxType WideBVHBroadphase::get_type() const {
+        return wide_.get_type();
+    }
+
+    std::optional<CastHit>
+    WideBVHBroadphase::cast(const BoundingBox& box,
+                            const math::njVec3f& displacement,
+                            CastMode mode,
+                            std::optional<EntityId> ignored) const {
+        // the binary BVH already descends only into the nodes swept through
+        return binary_.cast(box, displacement, mode, ignored);
+    }
+
+    DynamicTreeBroadphase::DynamicTreeBroadphase(BoundingBoxType type,
+                                                 float margin) :
+        tree_{ type, margin } {}
+
+    void
+    DynamicTreeBroadphase::update(const std::vector<Primitive>& primitives) {
+        for (const auto& [entity, box] : primitives) {
+            if (tree_.contains(entity)) {
+                tree_.move(entity, box);
+            } else {
+                tree_.insert(entity, box);
+            }
+        }
+
+        // every primitive is in the tree now, so it can only be larger if
+        // some entities are gone
+        if (tree_.size() == primitives.size()) {
+            return;
+        }
+        std::unordered_set<EntityId> current{};
+        for (const auto& [entity, box] : primitives) {
+            current.insert(entity);
+        }
+        for (EntityId entity : tree_.get_entities()) {
+            if (!current.contains(entity)) {
+                tree_.remove(entity);
+            }
+        }
+    }
+
+    void
+    DynamicTreeBroadphase::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        tree_.get_overlapping_pairs(pairs);
+    }
+
+    std::vector<EntityId>
+    DynamicTreeBroadphase::get_overlaps(const BoundingBox& box) const {
+        return tree_.get_overlaps(box);
+    }
+
+    BoundingBox DynamicTreeBroadphase::get_bounding_box(EntityId entity) const {
+        return tree_.get_bounding_box(entity);
+    }
+
+    BoundingBoxType DynamicTreeBroadphase::get_type() const {
+        return tree_.get_type();
+    }
+
+    std::optional<CastHit>
+    DynamicTreeBroadphase::cast(const BoundingBox& box,
+                                const math::njVec3f& displacement,
+                                CastMode mode,
+                                std::optional<EntityId> ignored) const {
+        return tree_.cast(box, displacement, mode, ignored);
+    }
+
+    std::unique_ptr<Broadphase> make_broadphase(BroadphaseType broadphase,
+                                                BoundingBoxType type,
+                                                std::shared_ptr<ThreadPool>
+                                                pool) {
+        switch (broadphase) {
+            case BroadphaseType::BVH:
+                return std::make_unique<BVHBroadphase>(type,
+                                                       BVHBuildOptions{},
+                                                       1.5f,
+                                                       std::move(pool));
+            case BroadphaseType::DynamicTree:
+                return std::make_unique<DynamicTreeBroadphase>(type);
+            case BroadphaseType::SweepAndPrune:
+                return std::make_unique<SweepAndPrune>(type);
+            case BroadphaseType::SpatialHash:
+                return std::make_unique<SpatialHash>(type);
+            case BroadphaseType::WideBVH:
+                return std::make_unique<WideBVHBroadphase>(type,
+                                                           BVHBuildOptions{},
+                                                           1.5f,
+                                                           std::move(pool));
+        }
+        return nullptr;
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,351 @@
+#include "physics/ContactSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace njin::ecs::physics {
+    namespace {
+        // contacts of a batch handed to a thread at a time
+        constexpr uint32_t CONTACTS_PER_TASK{ 64 };
+
+        /**
+         * Find the axis-aligned penetration vector that separates two AABBs.
+         * @param first First AABB
+         * @param second Second AABB
+         * @return Penetration vector. This is the direction the first bounding
+         * box must move in to separate from the second bounding box
+         * @note This assumes the two AABBs overlap at least along one axis
+         */
+        math::njVec3f
+        find_penetration_vector(const BoundingBox& first,
+                                const BoundingBox& second) {
+            // each overlap value is signed because it is the vector that first
+            // needs to move to separate from second along that axis
+
+            // we know that either first has to move along the positive
+            // direction of the given axis, or the negative direction, to
+            // separate from second
+            // therefore we can just take the minimum of the two
+            // to find the minimum depenetration vector along a given axis
+            using namespace std;
+            float x_minus{ second.min_x - first.max_x };
+            float x_plus{ second.max_x - first.min_x };
+            float x_overlap{ 0.f };
+            if (abs(x_minus) < abs(x_plus)) {
+                x_overlap = x_minus;
+            } else {
+                x_overlap = x_plus;
+            }
+
+            float y_minus{ second.min_y - first.max_y };
+            float y_plus{ second.max_y - first.min_y };
+            float y_overlap{ 0.f };
+            if (abs(y_minus) < abs(y_plus)) {
+                y_overlap = y_minus;
+            } else {
+                y_overlap = y_plus;
+            }
+
+            float z_minus{ second.min_z - first.max_z };
+            float z_plus{ second.max_z - first.min_z };
+            float z_overlap{ 0.f };
+            if (abs(z_minus) < abs(z_plus)) {
+                z_overlap = z_minus;
+            } else {
+                z_overlap = z_plus;
+            }
+
+            // when we depenetrate we move objects apart by an extra 2 * machine epsilon
+            // to avoid the situation where the objects were moved apart
+            // by their original depenetrating vector but still count as
+            // "overlapping" due to floating point imprecisions
+
+            // we can't use 1 * machine epsilon because if objects are moved
+            // away from each other by moving each object half the length of the
+            // depenetrating vector it would imply the extra offset is halved,
+            // and we can't have half of a machine epsilon by definition
+
+            // you can just remove the "* 2" portion below to see what happens
+            // -- objects are not moved apart enough and still count as overlapping
+            // and every contact is reported as unresolved
+
+            float epsilon{ std::numeric_limits<float>::epsilon() * 2 };
+            // x is the smallest
+            if (abs(x_overlap) < abs(y_overlap) &&
+                abs(x_overlap) < abs(z_overlap)) {
+                if (x_overlap < 0) {
+                    return { x_overlap - epsilon, 0.f, 0.f };
+                } else {
+                    return { x_overlap + epsilon, 0.f, 0.f };
+                }
+            } else if (abs(y_overlap) < abs(x_overlap) &&
+                       abs(y_overlap) < abs(z_overlap)) {
+                // y is the smallest
+                if (y_overlap < 0) {
+                    return { 0.f, y_overlap - epsilon, 0.f };
+                } else {
+                    return { 0.f, y_overlap + epsilon, 0.f };
+                }
+            } else {
+                // z is the smallest
+                if (z_overlap < 0) {
+                    return { 0.f, 0.f, z_overlap - epsilon };
+                } else {
+                    return { 0.f, 0.f, z_overlap + epsilon };
+                }
+            }
+        }
+
+        uint64_t make_key(EntityId first, EntityId second) {
+            return uint64_t{ first } << 32 | second;
+        }
+    }  // namespace
+
+    ContactSolver::ContactSolver(const ContactSolverSettings& settings) :
+        settings_{ settings } {}
+
+    template<typename Function>
+    void ContactSolver::for_each_contact(ThreadPool& pool,
+                                         Function&& function) {
+        for (size_t batch{ 0 }; batch + 1 < batch_offsets_.size(); ++batch) {
+            const uint32_t begin{ batch_offsets_[batch] };
+            const uint32_t count{ batch_offsets_[batch + 1] - begin };
+            const uint32_t task_count{ (count + CONTACTS_PER_TASK - 1) /
+                                       CONTACTS_PER_TASK };
+            pool.parallel_for(task_count, [&](uint32_t task) {
+                const uint32_t first{ begin + task * CONTACTS_PER_TASK };
+                const uint32_t last{ std::min(first + CONTACTS_PER_TASK,
+                                              begin + count) };
+                for (uint32_t i{ first }; i < last; ++i) {
+                    function(contacts_[i]);
+                }
+            });
+        }
+    }
+
+    void ContactSolver::solve(std::vector<SolverBody>& bodies,
+                              const OverlappingPairs& pairs,
+                              ThreadPool& pool) {
+        stats_ = {};
+        for (SolverBody& body : bodies) {
+            body.displacement = {};
+        }
+        make_contacts(bodies, pairs);
+
+        // bodies that never move are shared between the contacts of a
+        // batch, so they must not be written to, even with a 0 change
+        auto apply_impulse = [&bodies](const Contact& contact,
+                                       const math::njVec3f& impulse) {
+            SolverBody& first{ bodies[contact.first] };
+            SolverBody& second{ bodies[contact.second] };
+            if (first.inverse_mass > 0.f) {
+                first.velocity = first.velocity + impulse * first.inverse_mass;
+            }
+            if (second.inverse_mass > 0.f) {
+                second.velocity = second.velocity -
+                                  impulse * second.inverse_mass;
+            }
+        };
+        auto get_normal = [](const Contact& contact) {
+            math::njVec3f normal{};
+            normal[contact.axis] = contact.sign;
+            return normal;
+        };
+
+        if (settings_.warm_starting) {
+            for_each_contact(pool, [&](Contact& contact) {
+                apply_impulse(contact,
+                              get_normal(contact) * contact.normal_impulse +
+                              contact.tangent_impulse);
+            });
+        }
+
+        for (uint32_t i{ 0 }; i < settings_.velocity_iterations; ++i) {
+            for_each_contact(pool, [&](Contact& contact) {
+                const SolverBody& first{ bodies[contact.first] };
+                const SolverBody& second{ bodies[contact.second] };
+
+                // push until the bodies stop closing in (or bounce apart).
+                // The accumulated impulse may only ever push.
+                math::njVec3f relative{ first.velocity - second.velocity };
+                const float normal_velocity{ relative[contact.axis] *
+                                             contact.sign };
+                const float accumulated{
+                    std::max(contact.normal_impulse +
+                             (contact.target_velocity - normal_velocity) /
+                             contact.inverse_mass_sum,
+                             0.f)
+                };
+                apply_impulse(contact,
+                              get_normal(contact) *
+                              (accumulated - contact.normal_impulse));
+                contact.normal_impulse = accumulated;
+
+                // stop sliding, within the friction cone of the impulse
+                relative = first.velocity - second.velocity;
+                relative[contact.axis] = 0.f;
+                math::njVec3f tangent{ contact.tangent_impulse -
+                                       relative *
+                                       (1.f / contact.inverse_mass_sum) };
+                const float limit{ contact.friction * contact.normal_impulse };
+                const float length{ math::magnitude(tangent) };
+                if (length > limit) {
+                    tangent = tangent * (limit / length);
+                }
+                apply_impulse(contact, tangent - contact.tangent_impulse);
+                contact.tangent_impulse = tangent;
+            });
+        }
+        stats_.velocity_iterations = settings_.velocity_iterations;
+
+        for (uint32_t i{ 0 }; i < settings_.position_iterations; ++i) {
+            for_each_contact(pool, [&](Contact& contact) {
+                SolverBody& first{ bodies[contact.first] };
+                SolverBody& second{ bodies[contact.second] };
+
+                // the lighter body moves further
+                const math::njVec3f penetration{ get_penetration(first,
+                                                                 second) };
+                if (first.inverse_mass > 0.f) {
+                    first.displacement = first.displacement +
+                                         penetration *
+                                         (first.inverse_mass /
+                                          contact.inverse_mass_sum);
+                }
+                if (second.inverse_mass > 0.f) {
+                    second.displacement = second.displacement -
+                                          penetration *
+                                          (second.inverse_mass /
+                                           contact.inverse_mass_sum);
+                }
+            });
+        }
+        stats_.position_iterations = settings_.position_iterations;
+
+        cache_.clear();
+        for (const Contact& contact : contacts_) {
+            const SolverBody& first{ bodies[contact.first] };
+            const SolverBody& second{ bodies[contact.second] };
+            cache_[make_key(first.entity, second.entity)] = {
+                .axis = contact.axis,
+                .sign = contact.sign,
+                .normal_impulse = contact.normal_impulse,
+                .tangent_impulse = contact.tangent_impulse
+            };
+
+            const float remaining{ math::magnitude(get_penetration(first,
+                                                                   second)) };
+            if (remaining > 0.f) {
+                ++stats_.unresolved_count;
+                stats_.remaining_penetration =
+                std::max(stats_.remaining_penetration, remaining);
+            }
+        }
+    }
+
+    math::njVec3f ContactSolver::get_penetration(const SolverBody& first,
+                                                 const SolverBody& second)
+    const {
+        const BoundingBox first_box{ first.box.translate(first.displacement) };
+        const BoundingBox second_box{
+            second.box.translate(second.displacement)
+        };
+        if (!first_box.does_overlap(second_box, BoundingBoxType::XYZ)) {
+            return {};
+        }
+
+        const math::njVec3f penetration{
+            find_penetration_vector(first_box, second_box)
+        };
+        if (math::magnitude(penetration) <= settings_.penetration_tolerance) {
+            return {};
+        }
+        return penetration;
+    }
+
+    void ContactSolver::make_contacts(const std::vector<SolverBody>& bodies,
+                                      const OverlappingPairs& pairs) {
+        entity_to_body_.clear();
+        for (uint32_t i{ 0 }; i < bodies.size(); ++i) {
+            entity_to_body_[bodies[i].entity] = i;
+        }
+        batches_.build(pairs, [this, &bodies](EntityId entity) {
+            return bodies[entity_to_body_.at(entity)].inverse_mass == 0.f;
+        });
+
+        contacts_.clear();
+        batch_offsets_.assign(1, 0);
+        for (uint32_t batch{ 0 }; batch < batches_.get_batch_count(); ++batch) {
+            for (const auto& [first_entity, second_entity] :
+                 batches_.get_batch(batch)) {
+                const uint32_t first{ entity_to_body_.at(first_entity) };
+                const uint32_t second{ entity_to_body_.at(second_entity) };
+                const SolverBody& a{ bodies[first] };
+                const SolverBody& b{ bodies[second] };
+                if (a.inverse_mass + b.inverse_mass == 0.f) {
+                    // neither body can move
+                    continue;
+                }
+
+                // the penetration vector lies along exactly one axis
+                const math::njVec3f penetration{
+                    find_penetration_vector(a.box, b.box)
+                };
+                const int axis{ penetration.x != 0.f ? 0 :
+                                penetration.y != 0.f ? 1 :
+                                                       2 };
+                Contact contact{
+                    .first = first,
+                    .second = second,
+                    .axis = axis,
+                    .sign = penetration[axis] < 0.f ? -1.f : 1.f,
+                    .inverse_mass_sum = a.inverse_mass + b.inverse_mass,
+                    .restitution = std::max(a.restitution, b.restitution),
+                    .friction = std::sqrt(a.friction * b.friction)
+                };
+                stats_.max_penetration = std::max(stats_.max_penetration,
+                                                  std::abs(penetration[axis]));
+
+                // only bounce off fast approaches
+                const float normal_velocity{
+                    (a.velocity[axis] - b.velocity[axis]) * contact.sign
+                };
+                if (normal_velocity < -settings_.restitution_threshold) {
+                    contact.target_velocity = -contact.restitution *
+                                              normal_velocity;
+                }
+
+                if (settings_.warm_starting) {
+                    const auto it{ cache_.find(make_key(first_entity,
+                                                        second_entity)) };
+                    if (it != cache_.end() && it->second.axis == axis &&
+                        it->second.sign == contact.sign) {
+                        contact.normal_impulse = it->second.normal_impulse;
+                        contact.tangent_impulse = it->second.tangent_impulse;
+                        ++stats_.warm_started_count;
+                    }
+                }
+                contacts_.push_back(contact);
+            }
+            if (contacts_.size() > batch_offsets_.back()) {
+                batch_offsets_.push_back(
+                static_cast<uint32_t>(contacts_.size()));
+            }
+        }
+        stats_.contact_count = contacts_.size();
+        stats_.batch_count = static_cast<uint32_t>(batch_offsets_.size() - 1);
+    }
+
+    const ContactSolverSettings& ContactSolver::get_settings() const {
+        return settings_;
+    }
+
+    void ContactSolver::set_settings(const ContactSolverSettings& settings) {
+        settings_ = settings;
+    }
+
+    const ContactSolverStats& ContactSolver::get_stats() const {
+        return stats_;
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,467 @@
+#include "physics/DynamicTree.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace njin::ecs::physics {
+    DynamicTree::DynamicTree(BoundingBoxType type, float margin) :
+        type_{ type },
+        margin_{ margin } {}
+
+    void DynamicTree::insert(EntityId entity, const BoundingBox& box) {
+        if (entity_to_proxy_.contains(entity)) {
+            throw std::invalid_argument("entity is already in the tree");
+        }
+
+        const uint32_t leaf{ allocate_node() };
+        nodes_[leaf].box = fatten(box);
+        nodes_[leaf].entity = entity;
+        nodes_[leaf].height = 0;
+        entity_to_proxy_[entity] = { .leaf = leaf, .box = box };
+
+        insert_leaf(leaf);
+    }
+
+    void DynamicTree::remove(EntityId entity) {
+        const uint32_t leaf{ entity_to_proxy_.at(entity).leaf };
+        remove_leaf(leaf);
+        free_node(leaf);
+        entity_to_proxy_.erase(entity);
+    }
+
+    bool DynamicTree::move(EntityId entity, const BoundingBox& box) {
+        Proxy& proxy{ entity_to_proxy_.at(entity) };
+        proxy.box = box;
+
+        // small movements stay within the fattened box, so the tree does
+        // not need to change at all
+        if (nodes_[proxy.leaf].box.does_contain(box, type_)) {
+            return false;
+        }
+
+        remove_leaf(proxy.leaf);
+        nodes_[proxy.leaf].box = fatten(box);
+        insert_leaf(proxy.leaf);
+        return true;
+    }
+
+    bool DynamicTree::contains(EntityId entity) const {
+        return entity_to_proxy_.contains(entity);
+    }
+
+    size_t DynamicTree::size() const {
+        return entity_to_proxy_.size();
+    }
+
+    std::vector<EntityId> DynamicTree::get_entities() const {
+        std::vector<EntityId> entities{};
+        entities.reserve(entity_to_proxy_.size());
+        for (const auto& [entity, proxy] : entity_to_proxy_) {
+            entities.push_back(entity);
+        }
+        return entities;
+    }
+
+    BoundingBox DynamicTree::get_bounding_box(EntityId entity) const {
+        return entity_to_proxy_.at(entity).box;
+    }
+
+    BoundingBox DynamicTree::get_fat_bounding_box(EntityId entity) const {
+        return nodes_[entity_to_proxy_.at(entity).leaf].box;
+    }
+
+    template<typename Function>
+    void DynamicTree::for_each_overlap(const BoundingBox& box,
+                                       Function&& function) const {
+        if (root_ == DynamicTreeNode::NONE) {
+            return;
+        }
+
+        std::vector<uint32_t> stack{};
+        stack.reserve(64);
+        stack.push_back(root_);
+        while (!stack.empty()) {
+            const DynamicTreeNode& node{ nodes_[stack.back()] };
+            stack.pop_back();
+            if (!node.box.does_overlap(box, type_)) {
+                continue;
+            }
+
+            if (node.is_leaf()) {
+                // the leaf only holds the fattened box
+                const BoundingBox& exact{
+                    entity_to_proxy_.at(node.entity).box
+                };
+                if (exact.does_overlap(box, type_)) {
+                    function(node.entity);
+                }
+            } else {
+                stack.push_back(node.right);
+                stack.push_back(node.left);
+            }
+        }
+    }
+
+    std::vector<EntityId> DynamicTree::get_overlaps(EntityId entity) const {
+        std::vector<EntityId> overlaps{};
+        for_each_overlap(get_bounding_box(entity), [&](EntityId other) {
+            if (other != entity) {
+                overlaps.push_back(other);
+            }
+        });
+        return overlaps;
+    }
+
+    std::vector<EntityId>
+    DynamicTree::get_overlaps(const BoundingBox& box) const {
+        std::vector<EntityId> overlaps{};
+        for_each_overlap(box,
+                         [&](EntityId other) { overlaps.push_back(other); });
+        return overlaps;
+    }
+
+    int32_t DynamicTree::get_height() const {
+        if (root_ == DynamicTreeNode::NONE) {
+            return 0;
+        }
+        return nodes_[root_].height;
+    }
+
+    BoundingBoxType DynamicTree::get_type() const {
+        return type_;
+    }
+
+    uint32_t DynamicTree::allocate_node() {
+        if (free_list_ == DynamicTreeNode::NONE) {
+            nodes_.emplace_back();
+            return static_cast<uint32_t>(nodes_.size() - 1);
+        }
+
+        const uint32_t node{ free_list_ };
+        free_list_ = nodes_[node].parent_or_next;
+        nodes_[node] = {};
+        return node;
+    }
+
+    void DynamicTree::free_node(uint32_t node) {
+        nodes_[node] = { .parent_or_next = free_list_, .height = -1 };
+        free_list_ = node;
+    }
+
+    void DynamicTree::insert_leaf(uint32_t leaf) {
+        if (root_ == DynamicTreeNode::NONE) {
+            root_ = leaf;
+            nodes_[leaf].parent_or_next = DynamicTreeNode::NONE;
+            return;
+        }
+
+        // descend towards the sibling that grows the tree the least
+        const BoundingBox leaf_box{ nodes_[leaf].box };
+        uint32_t index{ root_ };
+        while (!nodes_[index].is_leaf()) {
+            const DynamicTreeNode& node{ nodes_[index] };
+            const float combined{
+                get_cost(BoundingBox::merge(node.box, leaf_box))
+            };
+
+            // cost of making the leaf a sibling of this node
+            const float cost{ 2 * combined };
+
+            // every ancestor of a deeper sibling grows as well
+            const float inherited{ 2 * (combined - get_cost(node.box)) };
+
+            auto get_descent_cost = [&](uint32_t child) {
+                const BoundingBox& child_box{ nodes_[child].box };
+                float grown{
+                    get_cost(BoundingBox::merge(child_box, leaf_box))
+                };
+                if (!nodes_[child].is_leaf()) {
+                    grown -= get_cost(child_box);
+                }
+                return grown + inherited;
+            };
+            const float left_cost{ get_descent_cost(node.left) };
+            const float right_cost{ get_descent_cost(node.right) };
+
+            if (cost < left_cost && cost < right_cost) {
+                break;
+            }
+            index = left_cost < right_cost ? node.left : node.right;
+        }
+
+        // replace the sibling by a new parent of the sibling and the leaf
+        const uint32_t sibling{ index };
+        const uint32_t old_parent{ nodes_[sibling].parent_or_next };
+        const uint32_t new_parent{ allocate_node() };
+        nodes_[new_parent] = {
+            .box = BoundingBox::merge(leaf_box, nodes_[sibling].box),
+            .parent_or_next = old_parent,
+            .left = sibling,
+            .right = leaf,
+            .height = nodes_[sibling].height + 1
+        };
+        nodes_[sibling].parent_or_next = new_parent;
+        nodes_[leaf].parent_or_next = new_parent;
+
+        if (old_parent == DynamicTreeNode::NONE) {
+            root_ = new_parent;
+        } else if (nodes_[old_parent].left == sibling) {
+            nodes_[old_parent].left = new_parent;
+        } else {
+            nodes_[old_parent].right = new_parent;
+        }
+
+        fix_upwards(new_parent);
+    }
+
+    void DynamicTree::remove_leaf(uint32_t leaf) {
+        if (leaf == root_) {
+            root_ = DynamicTreeNode::NONE;
+            return;
+        }
+
+        // the sibling takes the place of the parent
+        const uint32_t parent{ nodes_[leaf].parent_or_next };
+        const uint32_t grandparent{ nodes_[parent].parent_or_next };
+        const uint32_t sibling{ nodes_[parent].left == leaf ?
+                                nodes_[parent].right :
+                                nodes_[parent].left };
+
+        nodes_[sibling].parent_or_next = grandparent;
+        free_node(parent);
+        if (grandparent == DynamicTreeNode::NONE) {
+            root_ = sibling;
+            return;
+        }
+
+        if (nodes_[grandparent].left == parent) {
+            nodes_[grandparent].left = sibling;
+        } else {
+            nodes_[grandparent].right = sibling;
+        }
+        fix_upwards(grandparent);
+    }
+
+    void DynamicTree::fix_upwards(uint32_t node) {
+        uint32_t index{ node };
+        while (index != DynamicTreeNode::NONE) {
+            index = balance(index);
+
+            DynamicTreeNode& current{ nodes_[index] };
+            const DynamicTreeNode& left{ nodes_[current.left] };
+            const DynamicTreeNode& right{ nodes_[current.right] };
+            current.height = 1 + std::max(left.height, right.height);
+            current.box = BoundingBox::merge(left.box, right.box);
+
+            index = current.parent_or_next;
+        }
+    }
+
+    uint32_t DynamicTree::balance(uint32_t node) {
+        const uint32_t a{ node };
+        if (nodes_[a].is_leaf() || nodes_[a].height < 2) {
+            return a;
+        }
+
+        const uint32_t b{ nodes_[a].left };
+        const uint32_t c{ nodes_[a].right };
+        const int32_t difference{ nodes_[c].height - nodes_[b].height };
+        if (difference >= -1 && difference <= 1) {
+            return a;
+        }
+
+        // the taller child takes the place of a, and a takes the place of
+        // the taller grandchild's shorter sibling
+        const bool right_is_taller{ difference > 1 };
+        const uint32_t up{ right_is_taller ? c : b };
+        const uint32_t other{ right_is_taller ? b : c };
+        const uint32_t f{ nodes_[up].left };
+        const uint32_t g{ nodes_[up].right };
+
+        const uint32_t parent{ nodes_[a].parent_or_next };
+        nodes_[up].left = a;
+        nodes_[up].parent_or_next = parent;
+        nodes_[a].parent_or_next = up;
+        if (parent == DynamicTreeNode::NONE) {
+            root_ = up;
+        } else if (nodes_[parent].left == a) {
+            nodes_[parent].left = up;
+        } else {
+            nodes_[parent].right = up;
+        }
+
+        // the taller grandchild stays beneath up, the shorter moves to a
+        const bool f_is_taller{ nodes_[f].height > nodes_[g].height };
+        const uint32_t keep{ f_is_taller ? f : g };
+        const uint32_t give{ f_is_taller ? g : f };
+        nodes_[up].right = keep;
+        if (right_is_taller) {
+            nodes_[a].right = give;
+        } else {
+            nodes_[a].left = give;
+        }
+        nodes_[give].parent_or_next = a;
+
+        nodes_[a].box = BoundingBox::merge(nodes_[other].box,
+                                           nodes_[give].box);
+        nodes_[a].height = 1 + std::max(nodes_[other].height,
+                                        nodes_[give].height);
+        nodes_[up].box = BoundingBox::merge(nodes_[a].box, nodes_[keep].box);
+        nodes_[up].height = 1 + std::max(nodes_[a].height,
+                                         nodes_[keep].height);
+        return up;
+    }
+
+    BoundingBox DynamicTree::fatten(const BoundingBox& box) const {
+        BoundingBox fat{ box };
+        fat.min_x -= margin_;
+        fat.max_x += margin_;
+        fat.min_z -= margin_;
+        fat.max_z += margin_;
+        if (type_ == BoundingBoxType::XYZ) {
+            fat.min_y -= margin_;
+            fat.max_y += margin_;
+        }
+        return fat;
+    }
+
+    float DynamicTree::get_cost(const BoundingBox& box) const {
+        const float x{ box.max_x - box.min_x };
+        const float y{ box.max_y - box.min_y };
+        const float z{ box.max_z - box.min_z };
+        if (type_ == BoundingBoxType::XZ) {
+            return x + z;
+        }
+        return x * y + y * z + z * x;
+    }
+
+    std::optional<CastHit>
+    DynamicTree::cast(const BoundingBox& box,
+                      const math::njVec3f& displacement,
+                      CastMode mode,
+                      std::optional<EntityId> ignored) const {
+        std::optional<CastHit> first{};
+        if (root_ == DynamicTreeNode::NONE) {
+            return first;
+        }
+
+        // node indices with the time the box reaches them
+        std::vector<std::pair<uint32_t, float>> stack{};
+        stack.reserve(64);
+        const auto root_hit{
+            sweep(box, displacement, nodes_[root_].box, type_)
+        };
+        if (!root_hit) {
+            return first;
+        }
+        stack.emplace_back(root_, root_hit->time);
+        while (!stack.empty()) {
+            const auto [index, time]{ stack.back() };
+            stack.pop_back();
+            // a closer hit has been found since the node was pushed
+            if (first && time >= first->hit.time) {
+                continue;
+            }
+
+            const DynamicTreeNode& node{ nodes_[index] };
+            if (node.is_leaf()) {
+                // the leaf only holds the fattened box
+                const BoundingBox& exact{
+                    entity_to_proxy_.at(node.entity).box
+                };
+                if (node.entity == ignored) {
+                    continue;
+                }
+                const auto hit{ sweep(box, displacement, exact, type_) };
+                if (!hit || (first && hit->time >= first->hit.time)) {
+                    continue;
+                }
+                first = CastHit{ .entity = node.entity, .hit = *hit };
+                if (mode == CastMode::Any) {
+                    return first;
+                }
+                continue;
+            }
+
+            const auto left_hit{
+                sweep(box, displacement, nodes_[node.left].box, type_)
+            };
+            const auto right_hit{
+                sweep(box, displacement, nodes_[node.right].box, type_)
+            };
+            // the nearer child goes on top, so that it is visited first
+            // and its hits can rule out the farther one
+            const bool is_right_nearer{ left_hit && right_hit &&
+                                        right_hit->time < left_hit->time };
+            if (is_right_nearer) {
+                stack.emplace_back(node.left, left_hit->time);
+                stack.emplace_back(node.right, right_hit->time);
+                continue;
+            }
+            if (right_hit) {
+                stack.emplace_back(node.right, right_hit->time);
+            }
+            if (left_hit) {
+                stack.emplace_back(node.left, left_hit->time);
+            }
+        }
+        return first;
+    }
+
+    void DynamicTree::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        pairs.clear();
+        if (root_ == DynamicTreeNode::NONE) {
+            return;
+        }
+
+        // pairs of nodes whose subtrees still have to be tested against
+        // each other. A node paired with itself stands for the pairs
+        // within its own subtree.
+        std::vector<std::pair<uint32_t, uint32_t>> stack{};
+        stack.reserve(64);
+        stack.emplace_back(root_, root_);
+        while (!stack.empty()) {
+            const auto [a, b]{ stack.back() };
+            stack.pop_back();
+            const DynamicTreeNode& first{ nodes_[a] };
+            const DynamicTreeNode& second{ nodes_[b] };
+
+            if (a == b) {
+                if (!first.is_leaf()) {
+                    stack.emplace_back(first.left, first.right);
+                    stack.emplace_back(first.right, first.right);
+                    stack.emplace_back(first.left, first.left);
+                }
+                continue;
+            }
+
+            if (!first.box.does_overlap(second.box, type_)) {
+                continue;
+            }
+
+            if (first.is_leaf() && second.is_leaf()) {
+                // leaves only hold the fattened boxes
+                const BoundingBox& first_box{
+                    entity_to_proxy_.at(first.entity).box
+                };
+                const BoundingBox& second_box{
+                    entity_to_proxy_.at(second.entity).box
+                };
+                if (first_box.does_overlap(second_box, type_)) {
+                    pairs.push_back(make_entity_pair(first.entity,
+                                                     second.entity));
+                }
+            } else if (second.is_leaf() ||
+                       (!first.is_leaf() &&
+                        get_cost(first.box) >= get_cost(second.box))) {
+                // descend into the larger node, so both shrink evenly
+                stack.emplace_back(first.left, b);
+                stack.emplace_back(first.right, b);
+            } else {
+                stack.emplace_back(a, second.left);
+                stack.emplace_back(a, second.right);
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
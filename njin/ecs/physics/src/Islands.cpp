@@ -0,0 +1,90 @@
+#include "physics/Islands.h"
+
+#include <limits>
+#include <numeric>
+
+namespace njin::ecs::physics {
+    namespace {
+        constexpr uint32_t NO_ISLAND{ std::numeric_limits<uint32_t>::max() };
+    }  // namespace
+
+    void Islands::build(std::span<const EntityId> bodies,
+                        const OverlappingPairs& pairs) {
+        const auto body_count{ static_cast<uint32_t>(bodies.size()) };
+        entity_to_body_.clear();
+        for (uint32_t i{ 0 }; i < body_count; ++i) {
+            entity_to_body_[bodies[i]] = i;
+        }
+
+        parent_.resize(body_count);
+        std::iota(parent_.begin(), parent_.end(), 0);
+        for (const auto& [first, second] : pairs) {
+            const auto first_it{ entity_to_body_.find(first) };
+            const auto second_it{ entity_to_body_.find(second) };
+            if (first_it == entity_to_body_.end() ||
+                second_it == entity_to_body_.end()) {
+                continue;
+            }
+
+            // the smaller root wins, so the root of a tree is always its
+            // first body in the list
+            const uint32_t a{ find(first_it->second) };
+            const uint32_t b{ find(second_it->second) };
+            if (a < b) {
+                parent_[b] = a;
+            } else if (b < a) {
+                parent_[a] = b;
+            }
+        }
+
+        // number the islands in order of their roots, and count them
+        body_to_island_.assign(body_count, NO_ISLAND);
+        offsets_.assign(1, 0);
+        for (uint32_t i{ 0 }; i < body_count; ++i) {
+            const uint32_t root{ find(i) };
+            if (body_to_island_[root] == NO_ISLAND) {
+                body_to_island_[root] =
+                static_cast<uint32_t>(offsets_.size() - 1);
+                offsets_.push_back(0);
+            }
+            body_to_island_[i] = body_to_island_[root];
+            ++offsets_[body_to_island_[i] + 1];
+        }
+        for (size_t i{ 1 }; i < offsets_.size(); ++i) {
+            offsets_[i] += offsets_[i - 1];
+        }
+
+        // counting sort of the bodies by island
+        members_.resize(body_count);
+        std::vector<uint32_t> next{ offsets_.begin(), offsets_.end() - 1 };
+        for (uint32_t i{ 0 }; i < body_count; ++i) {
+            members_[next[body_to_island_[i]]++] = bodies[i];
+        }
+    }
+
+    uint32_t Islands::get_island_count() const {
+        return static_cast<uint32_t>(offsets_.size()) - 1;
+    }
+
+    std::span<const EntityId> Islands::get_island(uint32_t island) const {
+        return std::span{ members_ }.subspan(offsets_[island],
+                                             offsets_[island + 1] -
+                                             offsets_[island]);
+    }
+
+    bool Islands::contains(EntityId entity) const {
+        return entity_to_body_.contains(entity);
+    }
+
+    uint32_t Islands::get_island_index(EntityId entity) const {
+        return body_to_island_[entity_to_body_.at(entity)];
+    }
+
+    uint32_t Islands::find(uint32_t body) {
+        while (parent_[body] != body) {
+            parent_[body] = parent_[parent_[body]];
+            body = parent_[body];
+        }
+        return body;
+    }
+}  // namespace njin::ecs::physics
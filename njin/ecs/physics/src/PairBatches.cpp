@@ -0,0 +1,93 @@
+#include "physics/PairBatches.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace njin::ecs::physics {
+    namespace {
+        constexpr uint32_t UNCOLORED{ std::numeric_limits<uint32_t>::max() };
+
+        // colours handed out per round, one per bit of a body's mask
+        constexpr uint32_t ROUND_COLORS{ 64 };
+    }  // namespace
+
+    void PairBatches::build(const OverlappingPairs& pairs,
+                            const std::function<bool(EntityId)>& is_fixed) {
+        sorted_.assign(pairs.begin(), pairs.end());
+        std::ranges::sort(sorted_);
+
+        auto is_shared = [&](EntityId body) {
+            return !is_fixed || !is_fixed(body);
+        };
+
+        // colour greedily. Masks only hold 64 colours, so pairs that find
+        // all of them taken wait for the next round, which hands out the
+        // next 64 colours with cleared masks.
+        colors_.assign(sorted_.size(), UNCOLORED);
+        size_t remaining{ sorted_.size() };
+        uint32_t color_count{ 0 };
+        for (uint32_t base{ 0 }; remaining > 0; base += ROUND_COLORS) {
+            body_to_colors_.clear();
+            for (size_t i{ 0 }; i < sorted_.size(); ++i) {
+                if (colors_[i] != UNCOLORED) {
+                    continue;
+                }
+
+                const auto [first, second]{ sorted_[i] };
+                uint64_t taken{ 0 };
+                if (is_shared(first)) {
+                    taken |= body_to_colors_[first];
+                }
+                if (is_shared(second)) {
+                    taken |= body_to_colors_[second];
+                }
+                if (taken == std::numeric_limits<uint64_t>::max()) {
+                    continue;
+                }
+
+                const auto color{ static_cast<uint32_t>(
+                std::countr_zero(~taken)) };
+                const uint64_t bit{ uint64_t{ 1 } << color };
+                if (is_shared(first)) {
+                    body_to_colors_[first] |= bit;
+                }
+                if (is_shared(second)) {
+                    body_to_colors_[second] |= bit;
+                }
+                colors_[i] = base + color;
+                color_count = std::max(color_count, base + color + 1);
+                --remaining;
+            }
+        }
+
+        // counting sort by colour, which keeps each batch sorted
+        offsets_.assign(color_count + 1, 0);
+        for (uint32_t color : colors_) {
+            ++offsets_[color + 1];
+        }
+        for (uint32_t i{ 1 }; i <= color_count; ++i) {
+            offsets_[i] += offsets_[i - 1];
+        }
+        pairs_.resize(sorted_.size());
+        std::vector<uint32_t> next{ offsets_.begin(), offsets_.end() - 1 };
+        for (size_t i{ 0 }; i < sorted_.size(); ++i) {
+            pairs_[next[colors_[i]]++] = sorted_[i];
+        }
+    }
+
+    uint32_t PairBatches::get_batch_count() const {
+        return offsets_.empty() ? 0 :
+                                  static_cast<uint32_t>(offsets_.size() - 1);
+    }
+
+    std::span<const EntityPair> PairBatches::get_batch(uint32_t batch) const {
+        return std::span{ pairs_ }.subspan(offsets_[batch],
+                                           offsets_[batch + 1] -
+                                           offsets_[batch]);
+    }
+
+    size_t PairBatches::size() const {
+        return pairs_.size();
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,102 @@
+#include "physics/Queries.h"
+
+#include <algorithm>
+
+#include "physics/Broadphase.h"
+#include "physics/ThreadPool.h"
+
+namespace njin::ecs::physics {
+    namespace {
+        // queries handed to a thread at a time
+        constexpr uint32_t QUERIES_PER_TASK{ 64 };
+
+        /**
+         * @param a First point
+         * @param b Second point
+         * @return Squared distance between the points
+         */
+        float get_distance_squared(const math::njVec3f& a,
+                                   const math::njVec3f& b) {
+            const math::njVec3f d{ a - b };
+            return d.x * d.x + d.y * d.y + d.z * d.z;
+        }
+
+        /**
+         * Find the entity overlapping a box that best fits a query
+         * @param broadphase Broadphase holding the current bounding boxes
+         * @param query Overlap query
+         * @return Result of the query
+         */
+        QueryResult answer_overlap(const Broadphase& broadphase,
+                                   const Query& query) {
+            QueryResult result{};
+            float best{ 0.f };
+            for (EntityId entity : broadphase.get_overlaps(query.box)) {
+                if (entity == query.ignored) {
+                    continue;
+                }
+                const math::njVec3f centroid{
+                    broadphase.get_bounding_box(entity).centroid
+                };
+                const float distance{
+                    get_distance_squared(centroid, query.box.centroid)
+                };
+                if (result.is_hit && distance >= best) {
+                    continue;
+                }
+                result = { .is_hit = true,
+                           .entity = entity,
+                           .point = centroid };
+                best = distance;
+                if (query.mode == CastMode::Any) {
+                    break;
+                }
+            }
+            return result;
+        }
+    }  // namespace
+
+    QueryResult answer_query(const Broadphase& broadphase, const Query& query) {
+        if (query.type == QueryType::Overlap) {
+            return answer_overlap(broadphase, query);
+        }
+
+        // rays and segments are sweeps of a box of zero size
+        BoundingBox box{ BoundingBox::make(query.origin, 0.f, 0.f, 0.f) };
+        math::njVec3f displacement{ query.direction };
+        if (query.type == QueryType::Ray) {
+            displacement = query.direction * query.max_distance;
+        } else if (query.type == QueryType::Sweep) {
+            box = query.box;
+        }
+
+        const auto hit{
+            broadphase.cast(box, displacement, query.mode, query.ignored)
+        };
+        if (!hit) {
+            return {};
+        }
+        return { .is_hit = true,
+                 .entity = hit->entity,
+                 .time = hit->hit.time,
+                 .point = box.centroid + displacement * hit->hit.time,
+                 .normal = hit->hit.normal };
+    }
+
+    void answer_queries(const Broadphase& broadphase,
+                        std::span<const Query> queries,
+                        std::vector<QueryResult>& results,
+                        ThreadPool& pool) {
+        const auto count{ static_cast<uint32_t>(queries.size()) };
+        results.resize(count);
+        const uint32_t task_count{ (count + QUERIES_PER_TASK - 1) /
+                                   QUERIES_PER_TASK };
+        pool.parallel_for(task_count, [&](uint32_t task) {
+            const uint32_t first{ task * QUERIES_PER_TASK };
+            const uint32_t last{ std::min(first + QUERIES_PER_TASK, count) };
+            for (uint32_t i{ first }; i < last; ++i) {
+                results[i] = answer_query(broadphase, queries[i]);
+            }
+        });
+    }
+}  // namespace njin::ecs::physics
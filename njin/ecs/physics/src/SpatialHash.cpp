@@ -0,0 +1,284 @@
+#include "physics/SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace njin::ecs::physics {
+    namespace {
+        uint64_t get_key(int32_t x, int32_t z) {
+            return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 |
+                   static_cast<uint32_t>(z);
+        }
+
+        int32_t get_x(uint64_t key) {
+            return static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+        }
+
+        int32_t get_z(uint64_t key) {
+            return static_cast<int32_t>(static_cast<uint32_t>(key));
+        }
+
+        // cells further from the origin than this are clamped to it
+        constexpr double CELL_LIMIT{ 1 << 20 };
+
+        bool has_nan(const BoundingBox& box) {
+            return std::isnan(box.min_x) || std::isnan(box.max_x) ||
+                   std::isnan(box.min_y) || std::isnan(box.max_y) ||
+                   std::isnan(box.min_z) || std::isnan(box.max_z);
+        }
+    }  // namespace
+
+    SpatialHash::SpatialHash(BoundingBoxType type, float cell_size) :
+        type_{ type },
+        cell_size_{ cell_size } {}
+
+    void SpatialHash::update(const std::vector<Primitive>& primitives) {
+        for (Proxy& proxy : proxies_) {
+            proxy.updated = false;
+        }
+
+        for (const auto& [entity, box] : primitives) {
+            const CellRange cells{ get_cell_range(box) };
+            const Placement placement{ get_placement(box, cells) };
+            auto it{ entity_to_proxy_.find(entity) };
+            if (it != entity_to_proxy_.end()) {
+                Proxy& proxy{ proxies_[it->second] };
+                proxy.box = box;
+                proxy.updated = true;
+                // most bodies stay within the same cells between ticks
+                if (proxy.cells != cells || proxy.placement != placement) {
+                    remove_proxy(it->second);
+                    proxy.cells = cells;
+                    proxy.placement = placement;
+                    add_proxy(it->second);
+                }
+                continue;
+            }
+
+            uint32_t index{ 0 };
+            if (free_proxies_.empty()) {
+                index = static_cast<uint32_t>(proxies_.size());
+                proxies_.emplace_back();
+            } else {
+                index = free_proxies_.back();
+                free_proxies_.pop_back();
+            }
+            proxies_[index] = { .entity = entity,
+                                .box = box,
+                                .cells = cells,
+                                .placement = placement,
+                                .updated = true,
+                                .alive = true };
+            entity_to_proxy_[entity] = index;
+            add_proxy(index);
+        }
+
+        // every primitive has a proxy now, so there can only be more
+        // proxies if some entities are gone
+        if (entity_to_proxy_.size() == primitives.size()) {
+            return;
+        }
+        for (uint32_t i{ 0 }; i < proxies_.size(); ++i) {
+            Proxy& proxy{ proxies_[i] };
+            if (proxy.alive && !proxy.updated) {
+                remove_proxy(i);
+                entity_to_proxy_.erase(proxy.entity);
+                proxy.alive = false;
+                free_proxies_.push_back(i);
+            }
+        }
+    }
+
+    void SpatialHash::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        pairs.clear();
+        for (const auto& [key, cell] : cells_) {
+            const int32_t x{ get_x(key) };
+            const int32_t z{ get_z(key) };
+            for (size_t i{ 0 }; i < cell.size(); ++i) {
+                const Proxy& a{ proxies_[cell[i]] };
+                for (size_t j{ i + 1 }; j < cell.size(); ++j) {
+                    const Proxy& b{ proxies_[cell[j]] };
+                    // bodies can share several cells, but a pair is only
+                    // reported from the first cell they share
+                    if (std::max(a.cells.min_x, b.cells.min_x) != x ||
+                        std::max(a.cells.min_z, b.cells.min_z) != z) {
+                        continue;
+                    }
+                    if (a.box.does_overlap(b.box, type_)) {
+                        pairs.push_back(make_entity_pair(a.entity, b.entity));
+                    }
+                }
+            }
+        }
+
+        // oversized bodies are not in any cell, so test them against all
+        for (size_t i{ 0 }; i < oversized_.size(); ++i) {
+            const Proxy& a{ proxies_[oversized_[i]] };
+            for (const Proxy& b : proxies_) {
+                if (!b.alive || b.placement != Placement::Grid) {
+                    continue;
+                }
+                if (a.box.does_overlap(b.box, type_)) {
+                    pairs.push_back(make_entity_pair(a.entity, b.entity));
+                }
+            }
+            for (size_t j{ i + 1 }; j < oversized_.size(); ++j) {
+                const Proxy& b{ proxies_[oversized_[j]] };
+                if (a.box.does_overlap(b.box, type_)) {
+                    pairs.push_back(make_entity_pair(a.entity, b.entity));
+                }
+            }
+        }
+    }
+
+    std::vector<EntityId>
+    SpatialHash::get_overlaps(const BoundingBox& box) const {
+        std::vector<EntityId> overlaps{};
+        if (has_nan(box)) {
+            return overlaps;
+        }
+
+        for (uint32_t index : oversized_) {
+            const Proxy& proxy{ proxies_[index] };
+            if (proxy.box.does_overlap(box, type_)) {
+                overlaps.push_back(proxy.entity);
+            }
+        }
+
+        // a query covering more cells than there are bodies is cheaper to
+        // answer by testing every body
+        const CellRange range{ get_cell_range(box) };
+        if (range.get_count() > MAX_CELLS &&
+            range.get_count() > static_cast<int64_t>(proxies_.size())) {
+            for (const Proxy& proxy : proxies_) {
+                if (proxy.alive && proxy.placement == Placement::Grid &&
+                    proxy.box.does_overlap(box, type_)) {
+                    overlaps.push_back(proxy.entity);
+                }
+            }
+            return overlaps;
+        }
+
+        for (int32_t x{ range.min_x }; x <= range.max_x; ++x) {
+            for (int32_t z{ range.min_z }; z <= range.max_z; ++z) {
+                auto it{ cells_.find(get_key(x, z)) };
+                if (it == cells_.end()) {
+                    continue;
+                }
+                for (uint32_t index : it->second) {
+                    const Proxy& proxy{ proxies_[index] };
+                    // only report from the first cell shared with the box
+                    if (std::max(range.min_x, proxy.cells.min_x) != x ||
+                        std::max(range.min_z, proxy.cells.min_z) != z) {
+                        continue;
+                    }
+                    if (proxy.box.does_overlap(box, type_)) {
+                        overlaps.push_back(proxy.entity);
+                    }
+                }
+            }
+        }
+        return overlaps;
+    }
+
+    BoundingBox SpatialHash::get_bounding_box(EntityId entity) const {
+        return proxies_[entity_to_proxy_.at(entity)].box;
+    }
+
+    BoundingBoxType SpatialHash::get_type() const {
+        return type_;
+    }
+
+    size_t SpatialHash::get_cell_count() const {
+        return cells_.size();
+    }
+
+    size_t SpatialHash::get_oversized_count() const {
+        return oversized_.size();
+    }
+
+    int64_t SpatialHash::CellRange::get_count() const {
+        return (static_cast<int64_t>(max_x) - min_x + 1) *
+               (static_cast<int64_t>(max_z) - min_z + 1);
+    }
+
+    SpatialHash::CellRange
+    SpatialHash::get_cell_range(const BoundingBox& box) const {
+        auto to_cell = [this](float value) {
+            const double cell{ std::floor(static_cast<double>(value) /
+                                          cell_size_) };
+            // boxes with NaN bounds are never stored in the grid, so any
+            // cell does, as long as the conversion is defined
+            if (std::isnan(cell)) {
+                return 0;
+            }
+            return static_cast<int32_t>(
+            std::clamp(cell, -CELL_LIMIT, CELL_LIMIT));
+        };
+        return { .min_x = to_cell(box.min_x),
+                 .max_x = to_cell(box.max_x),
+                 .min_z = to_cell(box.min_z),
+                 .max_z = to_cell(box.max_z) };
+    }
+
+    SpatialHash::Placement
+    SpatialHash::get_placement(const BoundingBox& box,
+                               const CellRange& cells) {
+        if (has_nan(box)) {
+            return Placement::Rejected;
+        }
+        if (cells.get_count() > MAX_CELLS) {
+            return Placement::Oversized;
+        }
+        return Placement::Grid;
+    }
+
+    void SpatialHash::add_proxy(uint32_t proxy) {
+        switch (proxies_[proxy].placement) {
+            case Placement::Grid:
+                add_to_cells(proxy);
+                break;
+            case Placement::Oversized:
+                oversized_.push_back(proxy);
+                break;
+            case Placement::Rejected:
+                break;
+        }
+    }
+
+    void SpatialHash::remove_proxy(uint32_t proxy) {
+        switch (proxies_[proxy].placement) {
+            case Placement::Grid:
+                remove_from_cells(proxy);
+                break;
+            case Placement::Oversized:
+                std::erase(oversized_, proxy);
+                break;
+            case Placement::Rejected:
+                break;
+        }
+    }
+
+    void SpatialHash::add_to_cells(uint32_t proxy) {
+        const CellRange& range{ proxies_[proxy].cells };
+        for (int32_t x{ range.min_x }; x <= range.max_x; ++x) {
+            for (int32_t z{ range.min_z }; z <= range.max_z; ++z) {
+                cells_[get_key(x, z)].push_back(proxy);
+            }
+        }
+    }
+
+    void SpatialHash::remove_from_cells(uint32_t proxy) {
+        const CellRange& range{ proxies_[proxy].cells };
+        for (int32_t x{ range.min_x }; x <= range.max_x; ++x) {
+            for (int32_t z{ range.min_z }; z <= range.max_z; ++z) {
+                auto it{ cells_.find(get_key(x, z)) };
+                std::vector<uint32_t>& cell{ it->second };
+                std::erase(cell, proxy);
+                if (cell.empty()) {
+                    cells_.erase(it);
+                }
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,80 @@
+#include "physics/Sweep.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace njin::ecs::physics {
+    namespace {
+        /**
+         * Extents of a bounding box along an axis
+         * @param box Bounding box
+         * @param axis 0, 1 or 2 for x, y or z
+         * @return Minimum and maximum along the axis
+         */
+        std::array<float, 2> get_extents(const BoundingBox& box, int axis) {
+            switch (axis) {
+                case 0:  return { box.min_x, box.max_x };
+                case 1:  return { box.min_y, box.max_y };
+                default: return { box.min_z, box.max_z };
+            }
+        }
+    }  // namespace
+
+    std::optional<SweepHit> sweep(const BoundingBox& box,
+                                  const math::njVec3f& displacement,
+                                  const BoundingBox& target,
+                                  BoundingBoxType type) {
+        constexpr float INFINITY_F{ std::numeric_limits<float>::infinity() };
+
+        // the boxes overlap from enter to exit, as fractions of the
+        // displacement
+        float enter{ -INFINITY_F };
+        float exit{ INFINITY_F };
+        int enter_axis{ -1 };
+        for (int axis{ 0 }; axis < 3; ++axis) {
+            if (axis == 1 && type == BoundingBoxType::XZ) {
+                continue;
+            }
+            const auto [min, max]{ get_extents(box, axis) };
+            const auto [target_min, target_max]{ get_extents(target, axis) };
+            const float d{ displacement[axis] };
+            if (d == 0.f) {
+                // never overlaps along this axis if it does not already
+                if (max < target_min || target_max < min) {
+                    return std::nullopt;
+                }
+                continue;
+            }
+
+            float axis_enter{ (target_min - max) / d };
+            float axis_exit{ (target_max - min) / d };
+            if (d < 0.f) {
+                axis_enter = (target_max - min) / d;
+                axis_exit = (target_min - max) / d;
+            }
+            if (axis_enter > enter) {
+                enter = axis_enter;
+                enter_axis = axis;
+            }
+            exit = std::min(exit, axis_exit);
+        }
+
+        if (enter > exit || enter > 1.f || exit < 0.f) {
+            return std::nullopt;
+        }
+        // overlapping along every axis from the start
+        if (enter <= 0.f) {
+            return SweepHit{};
+        }
+
+        SweepHit hit{ .time = enter, .normal = math::njVec3f::zero() };
+        hit.normal[enter_axis] = displacement[enter_axis] > 0.f ? -1.f : 1.f;
+        return hit;
+    }
+
+    BoundingBox get_swept_bounds(const BoundingBox& box,
+                                 const math::njVec3f& displacement) {
+        return BoundingBox::merge(box, box.translate(displacement));
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,201 @@
+#include "physics/SweepAndPrune.h"
+
+#include <limits>
+
+namespace njin::ecs::physics {
+    namespace {
+        uint64_t get_key(const EntityPair& pair) {
+            return static_cast<uint64_t>(pair.first) << 32 | pair.second;
+        }
+    }  // namespace
+
+    SweepAndPrune::SweepAndPrune(BoundingBoxType type) :
+        type_{ type },
+        axis_count_{ type == BoundingBoxType::XYZ ? 3u : 2u } {}
+
+    void SweepAndPrune::update(const std::vector<Primitive>& primitives) {
+        added_.clear();
+        removed_.clear();
+
+        for (Proxy& proxy : proxies_) {
+            proxy.updated = false;
+        }
+        for (const auto& [entity, box] : primitives) {
+            auto it{ entity_to_proxy_.find(entity) };
+            if (it != entity_to_proxy_.end()) {
+                proxies_[it->second].box = box;
+                proxies_[it->second].updated = true;
+                continue;
+            }
+
+            // the endpoints of a new proxy start at the end of each list,
+            // and sorting them into place finds the pairs of the proxy
+            const auto proxy{ static_cast<uint32_t>(proxies_.size()) };
+            proxies_.push_back({ .entity = entity,
+                                 .box = box,
+                                 .updated = true });
+            entity_to_proxy_[entity] = proxy;
+            for (uint32_t axis{ 0 }; axis < axis_count_; ++axis) {
+                endpoints_[axis].push_back({ .proxy = proxy, .is_max = false });
+                endpoints_[axis].push_back({ .proxy = proxy, .is_max = true });
+            }
+        }
+
+        // every primitive has a proxy now, so there can only be more
+        // proxies if some entities are gone
+        if (proxies_.size() > primitives.size()) {
+            remove_stale_proxies();
+        }
+
+        for (uint32_t axis{ 0 }; axis < axis_count_; ++axis) {
+            for (Endpoint& endpoint : endpoints_[axis]) {
+                endpoint.value = get_value(axis,
+                                           proxies_[endpoint.proxy].box,
+                                           endpoint.is_max);
+            }
+            sort_axis(axis);
+        }
+    }
+
+    void SweepAndPrune::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        pairs.assign(pairs_.begin(), pairs_.end());
+    }
+
+    std::vector<EntityId>
+    SweepAndPrune::get_overlaps(const BoundingBox& box) const {
+        std::vector<EntityId> overlaps{};
+        for (const Proxy& proxy : proxies_) {
+            if (proxy.box.does_overlap(box, type_)) {
+                overlaps.push_back(proxy.entity);
+            }
+        }
+        return overlaps;
+    }
+
+    BoundingBox SweepAndPrune::get_bounding_box(EntityId entity) const {
+        return proxies_[entity_to_proxy_.at(entity)].box;
+    }
+
+    BoundingBoxType SweepAndPrune::get_type() const {
+        return type_;
+    }
+
+    const OverlappingPairs& SweepAndPrune::get_added_pairs() const {
+        return added_;
+    }
+
+    const OverlappingPairs& SweepAndPrune::get_removed_pairs() const {
+        return removed_;
+    }
+
+    void SweepAndPrune::remove_stale_proxies() {
+        // removing a pair moves the last pair into its place, which has
+        // already been visited when walking backwards
+        for (size_t i{ pairs_.size() }; i-- > 0;) {
+            const EntityPair pair{ pairs_[i] };
+            if (!proxies_[entity_to_proxy_.at(pair.first)].updated ||
+                !proxies_[entity_to_proxy_.at(pair.second)].updated) {
+                remove_pair(pair);
+            }
+        }
+
+        constexpr uint32_t REMOVED{ std::numeric_limits<uint32_t>::max() };
+        std::vector<uint32_t> new_indices(proxies_.size(), REMOVED);
+        std::vector<Proxy> proxies{};
+        proxies.reserve(proxies_.size());
+        for (uint32_t i{ 0 }; i < proxies_.size(); ++i) {
+            const Proxy& proxy{ proxies_[i] };
+            if (!proxy.updated) {
+                entity_to_proxy_.erase(proxy.entity);
+                continue;
+            }
+            new_indices[i] = static_cast<uint32_t>(proxies.size());
+            entity_to_proxy_[proxy.entity] = new_indices[i];
+            proxies.push_back(proxy);
+        }
+        proxies_ = std::move(proxies);
+
+        // erasing keeps the remaining endpoints sorted
+        for (uint32_t axis{ 0 }; axis < axis_count_; ++axis) {
+            std::erase_if(endpoints_[axis], [&](const Endpoint& endpoint) {
+                return new_indices[endpoint.proxy] == REMOVED;
+            });
+            for (Endpoint& endpoint : endpoints_[axis]) {
+                endpoint.proxy = new_indices[endpoint.proxy];
+            }
+        }
+    }
+
+    void SweepAndPrune::sort_axis(uint32_t axis) {
+        // at equal values minimums come first, so that touching boxes
+        // overlap as they do in BoundingBox::does_overlap
+        auto is_before = [](const Endpoint& a, const Endpoint& b) {
+            return a.value < b.value ||
+                   (a.value == b.value && !a.is_max && b.is_max);
+        };
+
+        std::vector<Endpoint>& endpoints{ endpoints_[axis] };
+        for (size_t i{ 1 }; i < endpoints.size(); ++i) {
+            const Endpoint endpoint{ endpoints[i] };
+            size_t j{ i };
+            while (j > 0 && is_before(endpoint, endpoints[j - 1])) {
+                const Endpoint& other{ endpoints[j - 1] };
+                const Proxy& a{ proxies_[endpoint.proxy] };
+                const Proxy& b{ proxies_[other.proxy] };
+                if (!endpoint.is_max && other.is_max) {
+                    // a minimum passed a maximum, so both overlap along
+                    // this axis now, but maybe not along the others
+                    if (a.box.does_overlap(b.box, type_)) {
+                        add_pair(make_entity_pair(a.entity, b.entity));
+                    }
+                } else if (endpoint.is_max && !other.is_max) {
+                    // a maximum passed a minimum, so both are apart
+                    remove_pair(make_entity_pair(a.entity, b.entity));
+                }
+                endpoints[j] = other;
+                --j;
+            }
+            endpoints[j] = endpoint;
+        }
+    }
+
+    void SweepAndPrune::add_pair(const EntityPair& pair) {
+        const auto [it, inserted]{
+            pair_to_index_.try_emplace(get_key(pair),
+                                       static_cast<uint32_t>(pairs_.size()))
+        };
+        if (!inserted) {
+            return;
+        }
+        pairs_.push_back(pair);
+        added_.push_back(pair);
+    }
+
+    void SweepAndPrune::remove_pair(const EntityPair& pair) {
+        auto it{ pair_to_index_.find(get_key(pair)) };
+        if (it == pair_to_index_.end()) {
+            return;
+        }
+
+        // move the last pair into the gap
+        const uint32_t index{ it->second };
+        pair_to_index_.erase(it);
+        if (index != pairs_.size() - 1) {
+            pairs_[index] = pairs_.back();
+            pair_to_index_[get_key(pairs_[index])] = index;
+        }
+        pairs_.pop_back();
+        removed_.push_back(pair);
+    }
+
+    float SweepAndPrune::get_value(uint32_t axis,
+                                   const BoundingBox& box,
+                                   bool is_max) {
+        if (axis == 0) {
+            return is_max ? box.max_x : box.min_x;
+        } else if (axis == 1) {
+            return is_max ? box.max_z : box.min_z;
+        }
+        return is_max ? box.max_y : box.min_y;
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,108 @@
+#include "physics/ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace njin::ecs::physics {
+    ThreadPool::ThreadPool(uint32_t thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        for (uint32_t i{ 1 }; i < thread_count; ++i) {
+            workers_.emplace_back(&ThreadPool::run_worker, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock{ mutex_ };
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    uint32_t ThreadPool::get_thread_count() const {
+        return static_cast<uint32_t>(workers_.size()) + 1;
+    }
+
+    void
+    ThreadPool::parallel_for(uint32_t count,
+                             const std::function<void(uint32_t)>& function) {
+        if (count == 0) {
+            return;
+        }
+        // the workers are busy with another caller's loop, so this one
+        // runs on the calling thread alone
+        std::unique_lock loop{ loop_mutex_, std::defer_lock };
+        if (workers_.empty() || count == 1 || !loop.try_lock()) {
+            for (uint32_t i{ 0 }; i < count; ++i) {
+                function(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard lock{ mutex_ };
+            function_ = &function;
+            count_ = count;
+            next_ = 0;
+            exception_ = nullptr;
+            pending_ = static_cast<uint32_t>(workers_.size());
+            ++generation_;
+        }
+        start_.notify_all();
+
+        run_iterations();
+
+        std::unique_lock lock{ mutex_ };
+        done_.wait(lock, [this] { return pending_ == 0; });
+        function_ = nullptr;
+        if (exception_) {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
+    }
+
+    void ThreadPool::run_worker() {
+        uint64_t seen{ 0 };
+        std::unique_lock lock{ mutex_ };
+        while (true) {
+            start_.wait(lock,
+                        [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+
+            lock.unlock();
+            run_iterations();
+            lock.lock();
+
+            --pending_;
+            if (pending_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::run_iterations() {
+        while (true) {
+            const uint32_t i{ next_.fetch_add(1) };
+            if (i >= count_) {
+                return;
+            }
+
+            try {
+                (*function_)(i);
+            } catch (...) {
+                std::lock_guard lock{ mutex_ };
+                if (!exception_) {
+                    exception_ = std::current_exception();
+                }
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
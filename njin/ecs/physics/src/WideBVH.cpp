@@ -0,0 +1,353 @@
+#include "physics/WideBVH.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#define NJIN_PHYSICS_SSE
+#endif
+
+namespace njin::ecs::physics {
+    namespace {
+        constexpr float INF{ std::numeric_limits<float>::infinity() };
+        constexpr float NaN{ std::numeric_limits<float>::quiet_NaN() };
+
+        /**
+         * Half the surface area (perimeter in 2D) of a bounding box
+         */
+        float get_area(const BoundingBox& box, BoundingBoxType type) {
+            const float x{ box.max_x - box.min_x };
+            const float y{ box.max_y - box.min_y };
+            const float z{ box.max_z - box.min_z };
+            if (type == BoundingBoxType::XZ) {
+                return x + z;
+            }
+            return x * y + y * z + z * x;
+        }
+
+#ifdef NJIN_PHYSICS_SSE
+        /**
+         * Test four consecutive children of a wide node with SSE
+         * @param first First of the four children, a multiple of 4
+         */
+        template<uint32_t Width>
+        uint32_t get_hit_mask_sse(const WideBVHNode<Width>& node,
+                                  uint32_t first,
+                                  const BoundingBox& box) {
+            __m128 hit{ _mm_and_ps(
+            _mm_cmple_ps(_mm_load_ps(node.min_x + first),
+                         _mm_set1_ps(box.max_x)),
+            _mm_cmpge_ps(_mm_load_ps(node.max_x + first),
+                         _mm_set1_ps(box.min_x))) };
+            hit = _mm_and_ps(hit,
+                             _mm_cmple_ps(_mm_load_ps(node.min_y + first),
+                                          _mm_set1_ps(box.max_y)));
+            hit = _mm_and_ps(hit,
+                             _mm_cmpge_ps(_mm_load_ps(node.max_y + first),
+                                          _mm_set1_ps(box.min_y)));
+            hit = _mm_and_ps(hit,
+                             _mm_cmple_ps(_mm_load_ps(node.min_z + first),
+                                          _mm_set1_ps(box.max_z)));
+            hit = _mm_and_ps(hit,
+                             _mm_cmpge_ps(_mm_load_ps(node.max_z + first),
+                                          _mm_set1_ps(box.min_z)));
+            return static_cast<uint32_t>(_mm_movemask_ps(hit));
+        }
+#endif
+
+#if defined(__AVX__)
+        /**
+         * Test all eight children of a wide node with AVX
+         */
+        uint32_t get_hit_mask_avx(const WideBVHNode<8>& node,
+                                  const BoundingBox& box) {
+            __m256 hit{ _mm256_and_ps(
+            _mm256_cmp_ps(_mm256_load_ps(node.min_x),
+                          _mm256_set1_ps(box.max_x),
+                          _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_load_ps(node.max_x),
+                          _mm256_set1_ps(box.min_x),
+                          _CMP_GE_OQ)) };
+            hit = _mm256_and_ps(hit,
+                                _mm256_cmp_ps(_mm256_load_ps(node.min_y),
+                                              _mm256_set1_ps(box.max_y),
+                                              _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit,
+                                _mm256_cmp_ps(_mm256_load_ps(node.max_y),
+                                              _mm256_set1_ps(box.min_y),
+                                              _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit,
+                                _mm256_cmp_ps(_mm256_load_ps(node.min_z),
+                                              _mm256_set1_ps(box.max_z),
+                                              _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit,
+                                _mm256_cmp_ps(_mm256_load_ps(node.max_z),
+                                              _mm256_set1_ps(box.min_z),
+                                              _CMP_GE_OQ));
+            return static_cast<uint32_t>(_mm256_movemask_ps(hit));
+        }
+#endif
+    }  // namespace
+
+    template<uint32_t Width>
+    uint32_t get_hit_mask_scalar(const WideBVHNode<Width>& node,
+                                 const BoundingBox& box) {
+        uint32_t mask{ 0 };
+        for (uint32_t i{ 0 }; i < Width; ++i) {
+            const bool hit{ node.min_x[i] <= box.max_x &&
+                            node.max_x[i] >= box.min_x &&
+                            node.min_y[i] <= box.max_y &&
+                            node.max_y[i] >= box.min_y &&
+                            node.min_z[i] <= box.max_z &&
+                            node.max_z[i] >= box.min_z };
+            mask |= static_cast<uint32_t>(hit) << i;
+        }
+        return mask;
+    }
+
+    template<uint32_t Width>
+    uint32_t get_hit_mask(const WideBVHNode<Width>& node,
+                          const BoundingBox& box) {
+#if defined(__AVX__)
+        if constexpr (Width == 8) {
+            return get_hit_mask_avx(node, box);
+        }
+#endif
+#ifdef NJIN_PHYSICS_SSE
+        uint32_t mask{ 0 };
+        for (uint32_t first{ 0 }; first < Width; first += 4) {
+            mask |= get_hit_mask_sse(node, first, box) << first;
+        }
+        return mask;
+#else
+        return get_hit_mask_scalar(node, box);
+#endif
+    }
+
+    template<uint32_t Width>
+    WideBVH<Width>::WideBVH(const std::vector<Primitive>& primitives,
+                            BoundingBoxType type,
+                            const BVHBuildOptions& options) :
+        WideBVH{ BVH{ primitives, type, options } } {}
+
+    template<uint32_t Width>
+    WideBVH<Width>::WideBVH(const BVH& bvh) : type_{ bvh.get_type() } {
+        // reorder the primitives so that leaves can refer to them directly
+        const std::vector<Primitive>& primitives{ bvh.get_primitives() };
+        const std::vector<uint32_t>& indices{ bvh.get_primitive_indices() };
+        primitives_.reserve(indices.size());
+        for (uint32_t i{ 0 }; i < indices.size(); ++i) {
+            primitives_.push_back(primitives[indices[i]]);
+            entity_to_primitive_[primitives_.back().first] = i;
+        }
+
+        if (bvh.get_root() == nullptr) {
+            return;
+        }
+        collapse(bvh, 0);
+    }
+
+    template<uint32_t Width>
+    uint32_t WideBVH<Width>::collapse(const BVH& bvh, uint32_t binary) {
+        const std::vector<BVHNode>& binary_nodes{ bvh.get_nodes() };
+
+        // gather the children by repeatedly opening up the internal node
+        // with the largest area, until there are Width of them
+        std::vector<uint32_t> children{};
+        children.reserve(Width);
+        if (binary_nodes[binary].is_leaf()) {
+            children.push_back(binary);
+        } else {
+            children.push_back(binary_nodes[binary].left_or_first);
+            children.push_back(binary_nodes[binary].left_or_first + 1);
+        }
+        while (children.size() < Width) {
+            int32_t largest{ -1 };
+            float largest_area{ -1.f };
+            for (uint32_t i{ 0 }; i < children.size(); ++i) {
+                const BVHNode& child{ binary_nodes[children[i]] };
+                if (child.is_leaf()) {
+                    continue;
+                }
+                const float area{ get_area(child.box, type_) };
+                if (area > largest_area) {
+                    largest = static_cast<int32_t>(i);
+                    largest_area = area;
+                }
+            }
+            if (largest < 0) {
+                break;
+            }
+            const uint32_t left{ binary_nodes[children[largest]].left_or_first };
+            children[largest] = left;
+            children.push_back(left + 1);
+        }
+
+        // children are collapsed after their parent, which may grow nodes_,
+        // so the parent is filled in locally
+        const auto index{ static_cast<uint32_t>(nodes_.size()) };
+        nodes_.emplace_back();
+
+        Node node{};
+        for (uint32_t i{ 0 }; i < Width; ++i) {
+            // every ordered comparison with NaN is false, so not even an
+            // unbounded query box overlaps an unused slot
+            node.min_x[i] = node.min_y[i] = node.min_z[i] = NaN;
+            node.max_x[i] = node.max_y[i] = node.max_z[i] = NaN;
+            node.child[i] = 0;
+            node.count[i] = 0;
+        }
+        for (uint32_t i{ 0 }; i < children.size(); ++i) {
+            const BVHNode& child{ binary_nodes[children[i]] };
+            node.min_x[i] = child.box.min_x;
+            node.max_x[i] = child.box.max_x;
+            node.min_z[i] = child.box.min_z;
+            node.max_z[i] = child.box.max_z;
+            if (type_ == BoundingBoxType::XYZ) {
+                node.min_y[i] = child.box.min_y;
+                node.max_y[i] = child.box.max_y;
+            } else {
+                node.min_y[i] = -INF;
+                node.max_y[i] = INF;
+            }
+
+            if (child.is_leaf()) {
+                node.child[i] = child.left_or_first;
+                node.count[i] = child.count;
+            } else {
+                node.child[i] = collapse(bvh, children[i]);
+            }
+        }
+        nodes_[index] = node;
+        return index;
+    }
+
+    template<uint32_t Width>
+    const std::vector<typename WideBVH<Width>::Node>&
+    WideBVH<Width>::get_nodes() const {
+        return nodes_;
+    }
+
+    template<uint32_t Width>
+    uint32_t WideBVH<Width>::get_depth() const {
+        if (nodes_.empty()) {
+            return 0;
+        }
+
+        uint32_t depth{ 0 };
+        std::vector<std::pair<uint32_t, uint32_t>> stack{ { 0, 1 } };
+        while (!stack.empty()) {
+            const auto [index, level]{ stack.back() };
+            stack.pop_back();
+            depth = std::max(depth, level);
+            const Node& node{ nodes_[index] };
+            for (uint32_t i{ 0 }; i < Width; ++i) {
+                // unused slots have NaN bounds
+                if (node.count[i] == 0 && node.min_x[i] <= node.max_x[i]) {
+                    stack.emplace_back(node.child[i], level + 1);
+                }
+            }
+        }
+        return depth;
+    }
+
+    template<uint32_t Width>
+    template<typename Function>
+    void WideBVH<Width>::for_each_overlap(const BoundingBox& box,
+                                          Function&& function) const {
+        if (nodes_.empty()) {
+            return;
+        }
+
+        std::vector<uint32_t> stack{};
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const Node& node{ nodes_[stack.back()] };
+            stack.pop_back();
+
+            uint32_t mask{ get_hit_mask(node, box) };
+            while (mask != 0) {
+                const auto i{ static_cast<uint32_t>(std::countr_zero(mask)) };
+                mask &= mask - 1;
+                if (node.count[i] == 0) {
+                    stack.push_back(node.child[i]);
+                    continue;
+                }
+                for (uint32_t primitive{ node.child[i] };
+                     primitive < node.child[i] + node.count[i];
+                     ++primitive) {
+                    if (primitives_[primitive].second.does_overlap(box,
+                                                                   type_)) {
+                        function(primitive);
+                    }
+                }
+            }
+        }
+    }
+
+    template<uint32_t Width>
+    std::vector<EntityId> WideBVH<Width>::get_overlaps(EntityId entity) const {
+        std::vector<EntityId> overlaps{};
+        for_each_overlap(get_bounding_box(entity), [&](uint32_t primitive) {
+            if (primitives_[primitive].first != entity) {
+                overlaps.push_back(primitives_[primitive].first);
+            }
+        });
+        return overlaps;
+    }
+
+    template<uint32_t Width>
+    std::vector<EntityId>
+    WideBVH<Width>::get_overlaps(const BoundingBox& box) const {
+        std::vector<EntityId> overlaps{};
+        for_each_overlap(box, [&](uint32_t primitive) {
+            overlaps.push_back(primitives_[primitive].first);
+        });
+        return overlaps;
+    }
+
+    template<uint32_t Width>
+    void WideBVH<Width>::get_overlapping_pairs(OverlappingPairs& pairs) const {
+        pairs.clear();
+        for (uint32_t i{ 0 }; i < primitives_.size(); ++i) {
+            const auto& [entity, box]{ primitives_[i] };
+            for_each_overlap(box, [&](uint32_t primitive) {
+                // each pair is found from both sides, keep one
+                if (primitive > i) {
+                    pairs.push_back(
+                    make_entity_pair(entity, primitives_[primitive].first));
+                }
+            });
+        }
+    }
+
+    template<uint32_t Width>
+    BoundingBox WideBVH<Width>::get_bounding_box(EntityId entity) const {
+        return primitives_[entity_to_primitive_.at(entity)].second;
+    }
+
+    template<uint32_t Width>
+    BoundingBoxType WideBVH<Width>::get_type() const {
+        return type_;
+    }
+
+    template uint32_t get_hit_mask<4>(const WideBVHNode<4>&,
+                                      const BoundingBox&);
+    template uint32_t get_hit_mask<8>(const WideBVHNode<8>&,
+                                      const BoundingBox&);
+    template uint32_t get_hit_mask_scalar<4>(const WideBVHNode<4>&,
+                                             const BoundingBox&);
+    template uint32_t get_hit_mask_scalar<8>(const WideBVHNode<8>&,
+                                             const BoundingBox&);
+    template class WideBVH<4>;
+    template class WideBVH<8>;
+}  // namespace njin::ecs::physics
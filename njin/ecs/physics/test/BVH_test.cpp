@@ -1,7 +1,13 @@
 #include "physics/BVH.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <catch2/catch_test_macros.hpp>
 
+#include "BruteForce.h"
+
 namespace njin::ecs::physics {
     TEST_CASE("bvh", "[ecs][physics][BVH]") {
         BoundingBox box_0{
@@ -36,7 +42,7 @@ namespace njin::ecs::physics {
                 const BVHNode* root{ bvh.get_root() };
                 REQUIRE(root);
                 REQUIRE(root->is_leaf());
-                REQUIRE(root->get_entities().size() == 1);
+                REQUIRE(bvh.get_entities(*root).size() == 1);
             }
 
             SECTION("two nodes") {
@@ -45,27 +51,35 @@ namespace njin::ecs::physics {
                 REQUIRE(root);
                 REQUIRE(!root->is_leaf());
 
-                const BVHNode* left{ root->get_left() };
-                const BVHNode* right{ root->get_right() };
+                const BVHNode* left{ bvh.get_left(*root) };
+                const BVHNode* right{ bvh.get_right(*root) };
 
                 REQUIRE(left);
                 REQUIRE(right);
 
                 REQUIRE(left->is_leaf());
-                REQUIRE(left->get_entities().size() == 1);
+                REQUIRE(bvh.get_entities(*left).size() == 1);
                 REQUIRE(right->is_leaf());
-                REQUIRE(right->get_entities().size() == 1);
+                REQUIRE(bvh.get_entities(*right).size() == 1);
+                REQUIRE(bvh.get_entities(*root).size() == 2);
+
+                REQUIRE(!bvh.get_left(*left));
+                REQUIRE(!bvh.get_right(*right));
 
-                REQUIRE(!left->get_left());
-                REQUIRE(!right->get_right());
+                // one contiguous array, children after their parent
+                REQUIRE(bvh.get_nodes().size() == 3);
+                REQUIRE(left == &bvh.get_nodes()[1]);
+                REQUIRE(right == left + 1);
             }
         }
         SECTION("overlap") {
             BVH bvh{ { prim_0, prim_1 } };
             const BVHNode* root{ bvh.get_root() };
 
-            REQUIRE(root->get_left()->does_overlap(*root->get_right()));
-            REQUIRE(root->get_right()->does_overlap(*root->get_left()));
+            const BVHNode* left{ bvh.get_left(*root) };
+            const BVHNode* right{ bvh.get_right(*root) };
+            REQUIRE(bvh.does_overlap(*left, *right));
+            REQUIRE(bvh.does_overlap(*right, *left));
 
             std::vector<EntityId> expected_overlaps_zero{ 1 };
             REQUIRE(bvh.get_overlaps(0) == expected_overlaps_zero);
@@ -125,6 +139,12 @@ namespace njin::ecs::physics {
 
             // it doesn't overlap with box_3, which is too high up
             REQUIRE(!box_0.does_overlap(box_3, BoundingBoxType::XYZ));
+
+            // nor with a box that only shares its Y range
+            BoundingBox box_4{
+                BoundingBox::make({ 5.f, 0.5f, 5.f }, 1.f, 1.f, 1.f)
+            };
+            REQUIRE(!box_0.does_overlap(box_4, BoundingBoxType::XYZ));
         }
 
         SECTION("2D overlaps") {
@@ -167,4 +187,337 @@ namespace njin::ecs::physics {
             REQUIRE(prim_3_overlaps.size() == 0);
         }
     }
+
+    TEST_CASE("BVH overlaps match brute force", "[ecs][physics][BVH]") {
+        // a row of boxes, each overlapping its neighbours, plus a few
+        // scattered ones
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 20; ++i) {
+            const float x{ static_cast<float>(i) * 0.75f };
+            primitives.emplace_back(i,
+                                    BoundingBox::make({ x, 0.f, 0.f },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+        }
+        for (EntityId i{ 20 }; i < 25; ++i) {
+            const float z{ static_cast<float>(i) * 3.f };
+            primitives.emplace_back(i,
+                                    BoundingBox::make({ 0.f, 0.f, z },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+        }
+
+        BVH bvh{ primitives };
+        REQUIRE(bvh.get_nodes().size() == 2 * primitives.size() - 1);
+        require_brute_force(bvh, primitives);
+
+        // 19 pairs along the row
+        OverlappingPairs pairs{};
+        bvh.get_overlapping_pairs(pairs);
+        std::ranges::sort(pairs);
+        OverlappingPairs expected{};
+        for (EntityId i{ 0 }; i < 19; ++i) {
+            expected.emplace_back(i, i + 1);
+        }
+        REQUIRE(pairs == expected);
+    }
+
+    TEST_CASE("binned SAH BVH", "[ecs][physics][BVH]") {
+        // two clusters far apart plus a long box spanning both
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 12; ++i) {
+            const float offset{ static_cast<float>(i % 4) * 0.5f };
+            const float x{ i < 6 ? offset : 100.f + offset };
+            const float z{ static_cast<float>(i) };
+            primitives.emplace_back(i,
+                                    BoundingBox::make({ x, 0.f, z },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+        }
+        primitives.emplace_back(12,
+                                BoundingBox::make({ 50.f, 0.f, 5.f },
+                                                  120.f,
+                                                  1.f,
+                                                  1.f));
+
+        SECTION("overlap cost") {
+            BVH median{ primitives };
+            BVH sah{ primitives,
+                     BoundingBoxType::XYZ,
+                     { .builder = BVHBuilder::BinnedSAH } };
+            require_brute_force(sah, primitives);
+            REQUIRE(sah.get_cost() <= median.get_cost());
+        }
+
+        SECTION("ray cost") {
+            BVHBuildOptions options{ .builder = BVHBuilder::BinnedSAH,
+                                     .cost = SAHCost::Ray };
+            BVH sah{ primitives, BoundingBoxType::XYZ, options };
+            require_brute_force(sah, primitives);
+        }
+
+        SECTION("2D") {
+            BVH sah{ primitives,
+                     BoundingBoxType::XZ,
+                     { .builder = BVHBuilder::BinnedSAH } };
+            require_brute_force(sah, primitives);
+        }
+
+        SECTION("leaves hold several primitives") {
+            BVH sah{ primitives,
+                     BoundingBoxType::XYZ,
+                     { .builder = BVHBuilder::BinnedSAH,
+                       .max_leaf_size = 13,
+                       .intersection_cost = 0.01f } };
+            // intersection is so cheap that a single leaf is best
+            REQUIRE(sah.get_nodes().size() == 1);
+            REQUIRE(sah.get_root()->count == primitives.size());
+            require_brute_force(sah, primitives);
+        }
+    }
+
+    TEST_CASE("2D BVH ignores Y when partitioning", "[ecs][physics][BVH]") {
+        // tall boxes, side by side along X
+        std::vector<Primitive> primitives{
+            { 0, BoundingBox::make({ 0.f, 0.f, 0.f }, 1.f, 100.f, 1.f) },
+            { 1, BoundingBox::make({ 5.f, 50.f, 0.f }, 1.f, 100.f, 1.f) }
+        };
+        for (BVHBuilder builder :
+             { BVHBuilder::Median, BVHBuilder::BinnedSAH }) {
+            BVH bvh{ primitives, BoundingBoxType::XZ, { .builder = builder } };
+            const BVHNode* left{ bvh.get_left(*bvh.get_root()) };
+            const BVHNode* right{ bvh.get_right(*bvh.get_root()) };
+            REQUIRE(left != nullptr);
+            REQUIRE(right != nullptr);
+            REQUIRE(bvh.get_entities(*left) == std::vector<EntityId>{ 0 });
+            REQUIRE(bvh.get_entities(*right) == std::vector<EntityId>{ 1 });
+        }
+    }
+
+    TEST_CASE("BVH refit", "[ecs][physics][BVH]") {
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 16; ++i) {
+            const float x{ static_cast<float>(i) * 2.f };
+            primitives.emplace_back(i,
+                                    BoundingBox::make({ x, 0.f, 0.f },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+        }
+        BVH bvh{ primitives };
+        const size_t node_count{ bvh.get_nodes().size() };
+        REQUIRE(bvh.get_degradation() == 1.f);
+
+        SECTION("refitted boxes") {
+            // pull every other box onto its neighbour
+            std::vector<Primitive> moved{};
+            for (EntityId i{ 1 }; i < 16; i += 2) {
+                const float x{ static_cast<float>(i - 1) * 2.f + 0.5f };
+                moved.emplace_back(i,
+                                   BoundingBox::make({ x, 0.f, 0.f },
+                                                     1.f,
+                                                     1.f,
+                                                     1.f));
+                primitives[i] = moved.back();
+            }
+            bvh.refit(moved);
+
+            REQUIRE(bvh.get_nodes().size() == node_count);
+            for (const auto& [entity, box] : primitives) {
+                REQUIRE(bvh.get_bounding_box(entity).min_x == box.min_x);
+            }
+            require_brute_force(bvh, primitives);
+        }
+
+        SECTION("degradation") {
+            // mirror the row, so that every subtree spans the whole row
+            std::vector<Primitive> moved{};
+            for (const auto& [entity, box] : primitives) {
+                const float x{ static_cast<float>(entity % 2 == 0 ?
+                                                  entity :
+                                                  15 - entity) * 2.f };
+                moved.emplace_back(entity,
+                                   BoundingBox::make({ x, 0.f, 0.f },
+                                                     1.f,
+                                                     1.f,
+                                                     1.f));
+            }
+            bvh.refit(moved);
+            REQUIRE(bvh.get_degradation() > 1.5f);
+            REQUIRE(BVH{ moved }.get_degradation() == 1.f);
+        }
+
+        SECTION("unknown entity") {
+            std::vector<Primitive> unknown{
+                { 100, BoundingBox::make({ 0.f, 0.f, 0.f }, 1.f, 1.f, 1.f) }
+            };
+            REQUIRE_THROWS(bvh.refit(unknown));
+        }
+    }
+
+    TEST_CASE("Morton BVH", "[ecs][physics][BVH]") {
+        // scattered boxes of different sizes, some with equal centroids
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 300; ++i) {
+            const auto phase{ static_cast<float>(i) };
+            math::njVec3f centroid{ std::sin(phase * 1.3f) * 15.f,
+                                    std::cos(phase * 0.7f) * 5.f,
+                                    std::sin(phase * 0.4f) * 15.f };
+            if (i % 50 == 0) {
+                centroid = { 1.f, 1.f, 1.f };
+            }
+            const float size{ 1.f + static_cast<float>(i % 4) };
+            primitives.emplace_back(i,
+                                    BoundingBox::make(centroid,
+                                                      size,
+                                                      size * 0.5f,
+                                                      size));
+        }
+
+        for (BoundingBoxType type :
+             { BoundingBoxType::XYZ, BoundingBoxType::XZ }) {
+            BVH bvh{ primitives, type, { .builder = BVHBuilder::Morton } };
+            const std::vector<BVHNode>& nodes{ bvh.get_nodes() };
+            REQUIRE(nodes.size() == 2 * primitives.size() - 1);
+
+            // every primitive is in exactly one leaf, children follow
+            // their parent, and every box encloses its children
+            std::vector<uint32_t> leaf_count(primitives.size());
+            bool is_valid{ true };
+            for (uint32_t i{ 0 }; i < nodes.size(); ++i) {
+                const BVHNode& node{ nodes[i] };
+                if (node.is_leaf()) {
+                    const uint32_t primitive{
+                        bvh.get_primitive_indices()[node.left_or_first]
+                    };
+                    ++leaf_count[primitive];
+                    is_valid = is_valid && node.count == 1 &&
+                               node.box.does_contain(primitives[primitive]
+                                                     .second,
+                                                     BoundingBoxType::XYZ);
+                    continue;
+                }
+                for (const BVHNode* child :
+                     { bvh.get_left(node), bvh.get_right(node) }) {
+                    is_valid = is_valid && child > &node &&
+                               node.box.does_contain(child->box,
+                                                     BoundingBoxType::XYZ);
+                }
+            }
+            REQUIRE(is_valid);
+            REQUIRE(std::ranges::all_of(leaf_count, [](uint32_t count) {
+                return count == 1;
+            }));
+
+            // overlaps are the same as with any other builder
+            OverlappingPairs expected{};
+            BVH{ primitives, type }.get_overlapping_pairs(expected);
+            std::ranges::sort(expected);
+            OverlappingPairs pairs{};
+            bvh.get_overlapping_pairs(pairs);
+            std::ranges::sort(pairs);
+            REQUIRE(pairs == expected);
+
+            // and refitting keeps it valid
+            bvh.refit(primitives);
+            REQUIRE(bvh.get_degradation() == 1.f);
+        }
+
+        SECTION("a single primitive") {
+            BVH bvh{ { primitives.front() },
+                     BoundingBoxType::XYZ,
+                     { .builder = BVHBuilder::Morton } };
+            REQUIRE(bvh.get_nodes().size() == 1);
+            REQUIRE(bvh.get_root()->count == 1);
+        }
+    }
+
+    TEST_CASE("parallel BVH build matches serial build",
+              "[ecs][physics][BVH]") {
+        // enough primitives to split the top levels across threads, with
+        // a clump of coincident centroids to force median fallbacks
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 20000; ++i) {
+            const auto phase{ static_cast<float>(i) };
+            math::njVec3f centroid{ static_cast<float>(i % 100) * 1.3f,
+                                    std::sin(phase * 0.37f) * 20.f,
+                                    static_cast<float>(i / 100) * 0.9f +
+                                    std::cos(phase * 1.7f) };
+            if (i % 97 == 0) {
+                centroid = { 5.f, 5.f, 5.f };
+            }
+            const float size{ 1.f + std::cos(phase * 0.13f) * 0.5f };
+            primitives.emplace_back(i,
+                                    BoundingBox::make(centroid,
+                                                      size,
+                                                      size,
+                                                      size));
+        }
+
+        auto require_identical = [](const BVH& serial, const BVH& parallel) {
+            REQUIRE(parallel.get_primitive_indices() ==
+                    serial.get_primitive_indices());
+            auto is_same = [](const BVHNode& a, const BVHNode& b) {
+                return a.left_or_first == b.left_or_first &&
+                       a.count == b.count && a.box.min_x == b.box.min_x &&
+                       a.box.max_x == b.box.max_x &&
+                       a.box.min_y == b.box.min_y &&
+                       a.box.max_y == b.box.max_y &&
+                       a.box.min_z == b.box.min_z &&
+                       a.box.max_z == b.box.max_z;
+            };
+            REQUIRE(std::ranges::equal(parallel.get_nodes(),
+                                       serial.get_nodes(),
+                                       is_same));
+            REQUIRE(parallel.get_cost() == serial.get_cost());
+        };
+
+        for (uint32_t threads : { 1u, 2u, 4u, 7u }) {
+            ThreadPool pool{ threads };
+            for (BoundingBoxType type :
+                 { BoundingBoxType::XYZ, BoundingBoxType::XZ }) {
+                for (BVHBuilder builder : { BVHBuilder::Median,
+                                            BVHBuilder::BinnedSAH,
+                                            BVHBuilder::Morton }) {
+                    const BVHBuildOptions options{ .builder = builder };
+                    require_identical(BVH{ primitives, type, options },
+                                      BVH{ primitives, type, options, pool });
+                }
+            }
+        }
+
+        SECTION("the top split is partitioned around the median") {
+            ThreadPool pool{ 4 };
+            const BVH bvh{ primitives, BoundingBoxType::XYZ, {}, pool };
+            const BVHNode* left{ bvh.get_left(*bvh.get_root()) };
+            const BVHNode* right{ bvh.get_right(*bvh.get_root()) };
+            REQUIRE(bvh.get_entities(*left).size() == primitives.size() / 2);
+
+            // the root is split along Z, its widest axis
+            float left_max{ -std::numeric_limits<float>::infinity() };
+            for (EntityId entity : bvh.get_entities(*left)) {
+                left_max = std::max(left_max,
+                                    primitives[entity].second.centroid.z);
+            }
+            float right_min{ std::numeric_limits<float>::infinity() };
+            for (EntityId entity : bvh.get_entities(*right)) {
+                right_min = std::min(right_min,
+                                     primitives[entity].second.centroid.z);
+            }
+            REQUIRE(left_max <= right_min);
+        }
+
+        SECTION("small inputs") {
+            ThreadPool pool{ 4 };
+            std::vector<Primitive> few{ primitives.begin(),
+                                        primitives.begin() + 3 };
+            require_identical(BVH{ few },
+                              BVH{ few, BoundingBoxType::XYZ, {}, pool });
+            BVH empty{ {}, BoundingBoxType::XYZ, {}, pool };
+            REQUIRE(!empty.get_root());
+        }
+    }
 }  // namespace njin::ecs::physics
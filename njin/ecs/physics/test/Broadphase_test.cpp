@@ -0,0 +1,88 @@
+#include "physics/Broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BruteForce.h"
+
+namespace njin::ecs::physics {
+    namespace {
+        /**
+         * Boxes drifting around a grid, a little further every tick
+         * @param tick Tick to get the boxes at
+         * @param count Number of boxes
+         * @return Primitives at the tick
+         */
+        std::vector<Primitive> make_primitives(int tick, EntityId count) {
+            std::vector<Primitive> primitives{};
+            for (EntityId i{ 0 }; i < count; ++i) {
+                const float t{ static_cast<float>(tick) * 0.2f };
+                const auto phase{ static_cast<float>(i) };
+                const math::njVec3f centroid{
+                    static_cast<float>(i % 6) * 1.5f + std::sin(t + phase),
+                    std::cos(t * 0.5f + phase),
+                    static_cast<float>(i / 6) * 1.5f + std::cos(t - phase)
+                };
+                primitives.emplace_back(i,
+                                        BoundingBox::make(centroid,
+                                                          1.f,
+                                                          1.f,
+                                                          1.f));
+            }
+            return primitives;
+        }
+
+        /**
+         * Run a broadphase through ticks of drifting boxes, with entities
+         * coming and going, and compare it to brute force every tick
+         * @param broadphase Broadphase to test
+         * @param type The axes the broadphase is concerned with
+         */
+        void require_brute_force_each_tick(std::unique_ptr<Broadphase>
+                                           broadphase,
+                                           BoundingBoxType type) {
+            REQUIRE(broadphase->get_type() == type);
+
+            for (int tick{ 0 }; tick < 30; ++tick) {
+                // entities come and go
+                const EntityId count{ tick < 10 ? 30u :
+                                      tick < 20 ? 24u :
+                                                  36u };
+                std::vector<Primitive> primitives{
+                    make_primitives(tick, count)
+                };
+                broadphase->update(primitives);
+                require_brute_force(*broadphase, primitives);
+
+                const BoundingBox& box{ primitives[7].second };
+                REQUIRE(broadphase->get_bounding_box(7).min_x == box.min_x);
+            }
+        }
+    }  // namespace
+
+    TEST_CASE("broadphases match brute force", "[ecs][physics][Broadphase]") {
+        // broadphases over a BVH rebuild on the pool if they are given one
+        const std::vector<std::shared_ptr<ThreadPool>> pools{
+            nullptr,
+            std::make_shared<ThreadPool>(4)
+        };
+        for (const std::shared_ptr<ThreadPool>& pool : pools) {
+            for (BoundingBoxType type :
+                 { BoundingBoxType::XYZ, BoundingBoxType::XZ }) {
+                for (BroadphaseType broadphase_type :
+                     { BroadphaseType::BVH,
+                       BroadphaseType::DynamicTree,
+                       BroadphaseType::SweepAndPrune,
+                       BroadphaseType::SpatialHash,
+                       BroadphaseType::WideBVH }) {
+                    require_brute_force_each_tick(
+                    make_broadphase(broadphase_type, type, pool),
+                    type);
+                }
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
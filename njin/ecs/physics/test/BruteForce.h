@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "physics/PhysicsTypes.h"
+
+namespace njin::ecs::physics {
+    /**
+     * Find every overlapping pair by testing each pair of bounding boxes
+     * @param primitives Exact bounding boxes of the entities
+     * @param type The axes to test the bounding boxes on
+     * @return Sorted overlapping pairs
+     */
+    inline OverlappingPairs
+    get_brute_force_pairs(const std::vector<Primitive>& primitives,
+                          BoundingBoxType type) {
+        OverlappingPairs pairs{};
+        for (size_t i{ 0 }; i < primitives.size(); ++i) {
+            for (size_t j{ i + 1 }; j < primitives.size(); ++j) {
+                const auto& [a, a_box]{ primitives[i] };
+                const auto& [b, b_box]{ primitives[j] };
+                if (a_box.does_overlap(b_box, type)) {
+                    pairs.push_back(make_entity_pair(a, b));
+                }
+            }
+        }
+        std::ranges::sort(pairs);
+        return pairs;
+    }
+
+    /**
+     * Require the overlaps reported by a structure to match those found by
+     * testing every pair of bounding boxes. Box queries are checked for
+     * every structure, and entity queries for those that answer them.
+     * @tparam Structure BVH, WideBVH, DynamicTree or Broadphase
+     * @param structure Structure to check
+     * @param primitives Exact bounding boxes of the entities in it
+     */
+    template<typename Structure>
+    void require_brute_force(const Structure& structure,
+                             const std::vector<Primitive>& primitives) {
+        const BoundingBoxType type{ structure.get_type() };
+        for (const auto& [entity, box] : primitives) {
+            std::vector<EntityId> expected{};
+            for (const auto& [other, other_box] : primitives) {
+                if (box.does_overlap(other_box, type)) {
+                    expected.push_back(other);
+                }
+            }
+            std::ranges::sort(expected);
+            std::vector<EntityId> overlaps{ structure.get_overlaps(box) };
+            std::ranges::sort(overlaps);
+            REQUIRE(overlaps == expected);
+
+            if constexpr (requires { structure.get_overlaps(entity); }) {
+                std::erase(expected, entity);
+                overlaps = structure.get_overlaps(entity);
+                std::ranges::sort(overlaps);
+                REQUIRE(overlaps == expected);
+            }
+        }
+
+        OverlappingPairs pairs{};
+        structure.get_overlapping_pairs(pairs);
+        std::ranges::sort(pairs);
+        REQUIRE(pairs == get_brute_force_pairs(primitives, type));
+    }
+}  // namespace njin::ecs::physics
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "physics/ContactSolver.h"
+
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    namespace {
+        SolverBody make_body(EntityId entity,
+                             const math::njVec3f& centroid,
+                             const math::njVec3f& velocity,
+                             float inverse_mass,
+                             float size = 1.f) {
+            return { .entity = entity,
+                     .box = BoundingBox::make(centroid, size, size, size),
+                     .velocity = velocity,
+                     .inverse_mass = inverse_mass };
+        }
+
+        bool is_near(float a, float b) {
+            return std::abs(a - b) < 1e-4f;
+        }
+
+        /**
+         * Find the overlapping pairs of a set of bodies, after they have
+         * been moved by the solver
+         */
+        OverlappingPairs get_pairs(const std::vector<SolverBody>& bodies) {
+            OverlappingPairs pairs{};
+            for (size_t i{ 0 }; i < bodies.size(); ++i) {
+                for (size_t j{ i + 1 }; j < bodies.size(); ++j) {
+                    BoundingBox a{ bodies[i].box };
+                    BoundingBox b{ bodies[j].box };
+                    if (a.does_overlap(b, BoundingBoxType::XYZ)) {
+                        pairs.push_back(make_entity_pair(bodies[i].entity,
+                                                         bodies[j].entity));
+                    }
+                }
+            }
+            return pairs;
+        }
+    }  // namespace
+
+    TEST_CASE("contact solver", "[ecs][physics][ContactSolver]") {
+        ThreadPool pool{ 4 };
+        ContactSolver solver{};
+
+        // a large static floor, its top at y = 0
+        const SolverBody floor{ .entity = 0,
+                                .box = BoundingBox::make({ 0.f, -5.f, 0.f },
+                                                         100.f,
+                                                         10.f,
+                                                         100.f),
+                                .friction = 0.5f };
+
+        SECTION("no contacts") {
+            std::vector<SolverBody> bodies{
+                make_body(1, { 0.f, 5.f, 0.f }, { 0.f, -1.f, 0.f }, 1.f)
+            };
+            solver.solve(bodies, {}, pool);
+            REQUIRE(solver.get_stats().contact_count == 0);
+            REQUIRE(solver.get_stats().batch_count == 0);
+            REQUIRE(bodies[0].velocity.y == -1.f);
+        }
+
+        SECTION("resting on a static body") {
+            // sinking 0.1 into the floor while falling
+            std::vector<SolverBody> bodies{
+                floor,
+                make_body(1, { 0.f, 0.4f, 0.f }, { 0.f, -3.f, 0.f }, 1.f)
+            };
+            solver.solve(bodies, get_pairs(bodies), pool);
+
+            const ContactSolverStats& stats{ solver.get_stats() };
+            REQUIRE(stats.contact_count == 1);
+            REQUIRE(stats.unresolved_count == 0);
+            REQUIRE(is_near(stats.max_penetration, 0.1f));
+            REQUIRE(is_near(bodies[1].velocity.y, 0.f));
+            REQUIRE(is_near(bodies[1].displacement.y, 0.1f));
+
+            // the floor is never moved
+            REQUIRE(bodies[0].displacement == math::njVec3f{});
+            REQUIRE(bodies[0].velocity == math::njVec3f{});
+        }
+
+        SECTION("restitution") {
+            std::vector<SolverBody> bodies{
+                make_body(1, { -0.45f, 0.f, 0.f }, { 4.f, 0.f, 0.f }, 1.f),
+                make_body(2, { 0.45f, 0.f, 0.f }, { -4.f, 0.f, 0.f }, 1.f)
+            };
+            SECTION("inelastic") {
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[0].velocity.x, 0.f));
+                REQUIRE(is_near(bodies[1].velocity.x, 0.f));
+            }
+            SECTION("elastic") {
+                bodies[0].restitution = 1.f;
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[0].velocity.x, -4.f));
+                REQUIRE(is_near(bodies[1].velocity.x, 4.f));
+            }
+            SECTION("slow impacts do not bounce") {
+                bodies[0].restitution = 1.f;
+                bodies[0].velocity.x = 0.25f;
+                bodies[1].velocity.x = -0.25f;
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[0].velocity.x, 0.f));
+            }
+
+            // equal masses, so both move apart by the same amount
+            REQUIRE(is_near(bodies[0].displacement.x,
+                            -bodies[1].displacement.x));
+            REQUIRE(solver.get_stats().unresolved_count == 0);
+        }
+
+        SECTION("friction") {
+            std::vector<SolverBody> bodies{
+                floor,
+                make_body(1, { 0.f, 0.4f, 0.f }, { 5.f, -2.f, 0.f }, 1.f)
+            };
+            SECTION("frictionless") {
+                bodies[1].friction = 0.f;
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[1].velocity.x, 5.f));
+            }
+            SECTION("limited by the normal impulse") {
+                // the normal impulse of 2 allows a friction impulse of 1
+                bodies[0].friction = 0.5f;
+                bodies[1].friction = 0.5f;
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[1].velocity.x, 4.f));
+            }
+            SECTION("sticking") {
+                bodies[0].friction = 10.f;
+                bodies[1].friction = 10.f;
+                solver.solve(bodies, get_pairs(bodies), pool);
+                REQUIRE(is_near(bodies[1].velocity.x, 0.f));
+            }
+        }
+
+        SECTION("warm starting") {
+            std::vector<SolverBody> bodies{
+                floor,
+                make_body(1, { 0.f, 0.4f, 0.f }, { 0.f, -3.f, 0.f }, 1.f),
+                make_body(2, { 3.f, 0.4f, 0.f }, { 0.f, -3.f, 0.f }, 1.f)
+            };
+            const OverlappingPairs pairs{ get_pairs(bodies) };
+            solver.solve(bodies, pairs, pool);
+            REQUIRE(solver.get_stats().warm_started_count == 0);
+
+            // same contacts next tick
+            solver.solve(bodies, pairs, pool);
+            REQUIRE(solver.get_stats().warm_started_count == 2);
+
+            solver.set_settings({ .warm_starting = false });
+            solver.solve(bodies, pairs, pool);
+            REQUIRE(solver.get_stats().warm_started_count == 0);
+        }
+
+        SECTION("work is bounded") {
+            // a column of boxes jammed into each other on the floor
+            std::vector<SolverBody> bodies{ floor };
+            for (EntityId i{ 1 }; i <= 10; ++i) {
+                const float y{ static_cast<float>(i) * 0.5f };
+                bodies.push_back(
+                make_body(i, { 0.f, y, 0.f }, { 0.f, -1.f, 0.f }, 1.f));
+            }
+            const OverlappingPairs pairs{ get_pairs(bodies) };
+
+            solver.set_settings({ .velocity_iterations = 2,
+                                  .position_iterations = 1 });
+            std::vector<SolverBody> few{ bodies };
+            solver.solve(few, pairs, pool);
+            const ContactSolverStats stats{ solver.get_stats() };
+            REQUIRE(stats.velocity_iterations == 2);
+            REQUIRE(stats.position_iterations == 1);
+            REQUIRE(stats.contact_count == pairs.size());
+            REQUIRE(stats.batch_count >= 2);
+            REQUIRE(stats.unresolved_count > 0);
+            REQUIRE(stats.remaining_penetration <= stats.max_penetration);
+
+            solver.set_settings({ .position_iterations = 100 });
+            std::vector<SolverBody> many{ bodies };
+            solver.solve(many, pairs, pool);
+            REQUIRE(solver.get_stats().remaining_penetration <
+                    stats.remaining_penetration / 10.f);
+        }
+
+        SECTION("results do not depend on the number of threads") {
+            std::vector<SolverBody> bodies{ floor };
+            for (EntityId i{ 1 }; i <= 400; ++i) {
+                const auto phase{ static_cast<float>(i) };
+                bodies.push_back(
+                make_body(i,
+                          { static_cast<float>(i % 20) * 0.8f,
+                            static_cast<float>(i / 20) * 0.8f,
+                            std::sin(phase) * 0.3f },
+                          { std::cos(phase), -1.f, std::sin(phase * 2.f) },
+                          1.f / (1.f + static_cast<float>(i % 3))));
+            }
+            const OverlappingPairs pairs{ get_pairs(bodies) };
+
+            ThreadPool single{ 1 };
+            ContactSolver serial{};
+            std::vector<SolverBody> expected{ bodies };
+            serial.solve(expected, pairs, single);
+            solver.solve(bodies, pairs, pool);
+
+            for (size_t i{ 0 }; i < bodies.size(); ++i) {
+                REQUIRE(bodies[i].velocity == expected[i].velocity);
+                REQUIRE(bodies[i].displacement == expected[i].displacement);
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,115 @@
+#include "physics/DynamicTree.h"
+
+#include <algorithm>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BruteForce.h"
+
+namespace njin::ecs::physics {
+    namespace {
+        BoundingBox make_box(float x, float z) {
+            return BoundingBox::make({ x, 0.f, z }, 1.f, 1.f, 1.f);
+        }
+    }  // namespace
+
+    TEST_CASE("dynamic tree", "[ecs][physics][DynamicTree]") {
+        DynamicTree tree{ BoundingBoxType::XYZ, 0.25f };
+        REQUIRE(tree.size() == 0);
+        REQUIRE(tree.get_height() == 0);
+        REQUIRE(tree.get_overlaps(make_box(0.f, 0.f)).empty());
+
+        // a row of boxes, each overlapping its neighbours
+        std::vector<Primitive> primitives{};
+        for (EntityId i{ 0 }; i < 64; ++i) {
+            primitives.emplace_back(i,
+                                    make_box(static_cast<float>(i) * 0.75f,
+                                             0.f));
+            tree.insert(i, primitives.back().second);
+        }
+        require_brute_force(tree, primitives);
+
+        SECTION("balanced") {
+            // inserting in sorted order would degenerate into a list
+            // without rotations
+            REQUIRE(tree.get_height() <= 12);
+        }
+
+        SECTION("fattened bounds") {
+            const BoundingBox fat{ tree.get_fat_bounding_box(0) };
+            REQUIRE(fat.min_x == primitives[0].second.min_x - 0.25f);
+            REQUIRE(fat.max_y == primitives[0].second.max_y + 0.25f);
+            REQUIRE(tree.get_bounding_box(0).min_x ==
+                    primitives[0].second.min_x);
+        }
+
+        SECTION("duplicate insertion") {
+            REQUIRE_THROWS(tree.insert(0, make_box(0.f, 0.f)));
+        }
+
+        SECTION("moving") {
+            // staying within the fattened box
+            primitives[10].second = make_box(7.6f, 0.f);
+            REQUIRE_FALSE(tree.move(10, primitives[10].second));
+            require_brute_force(tree, primitives);
+
+            // leaving it
+            for (EntityId i{ 0 }; i < 64; i += 3) {
+                primitives[i].second = make_box(static_cast<float>(i) * 0.75f,
+                                                5.f);
+                REQUIRE(tree.move(i, primitives[i].second));
+            }
+            require_brute_force(tree, primitives);
+            REQUIRE(tree.get_height() <= 12);
+        }
+
+        SECTION("removing") {
+            for (EntityId i{ 0 }; i < 64; i += 2) {
+                tree.remove(i);
+            }
+            std::erase_if(primitives, [](const Primitive& primitive) {
+                return primitive.first % 2 == 0;
+            });
+            REQUIRE_FALSE(tree.contains(0));
+            REQUIRE(tree.contains(1));
+            require_brute_force(tree, primitives);
+
+            // freed nodes are reused
+            tree.insert(0, make_box(0.f, 0.f));
+            primitives.emplace_back(0, make_box(0.f, 0.f));
+            require_brute_force(tree, primitives);
+
+            for (const auto& [entity, box] : primitives) {
+                tree.remove(entity);
+            }
+            REQUIRE(tree.size() == 0);
+            REQUIRE(tree.get_height() == 0);
+        }
+
+        SECTION("overlapping pairs") {
+            // the buffer is cleared before being written to
+            OverlappingPairs pairs{ { 100, 101 } };
+            tree.get_overlapping_pairs(pairs);
+            REQUIRE(pairs.size() == 63);
+            for (const auto& [a, b] : pairs) {
+                REQUIRE(b == a + 1);
+            }
+        }
+    }
+
+    TEST_CASE("2D dynamic tree", "[ecs][physics][DynamicTree]") {
+        DynamicTree tree{ BoundingBoxType::XZ };
+        std::vector<Primitive> primitives{
+            { 0, BoundingBox::make({ 0.f, 0.f, 0.f }, 1.f, 1.f, 1.f) },
+            { 1, BoundingBox::make({ 0.5f, 10.f, 0.f }, 1.f, 1.f, 1.f) },
+            { 2, BoundingBox::make({ 5.f, 0.f, 0.f }, 1.f, 1.f, 1.f) }
+        };
+        for (const auto& [entity, box] : primitives) {
+            tree.insert(entity, box);
+        }
+
+        // Y is ignored
+        require_brute_force(tree, primitives);
+        REQUIRE(tree.get_overlaps(0) == std::vector<EntityId>{ 1 });
+    }
+}  // namespace njin::ecs::physics
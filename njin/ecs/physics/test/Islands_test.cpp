@@ -0,0 +1,83 @@
+#include "physics/Islands.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    TEST_CASE("islands", "[ecs][physics][Islands]") {
+        Islands islands{};
+
+        SECTION("empty") {
+            REQUIRE(islands.get_island_count() == 0);
+            islands.build({}, {});
+            REQUIRE(islands.get_island_count() == 0);
+        }
+
+        SECTION("bodies without pairs are islands of their own") {
+            const std::vector<EntityId> bodies{ 4, 2, 9 };
+            islands.build(bodies, {});
+            REQUIRE(islands.get_island_count() == 3);
+            for (uint32_t i{ 0 }; i < 3; ++i) {
+                REQUIRE(islands.get_island(i).size() == 1);
+                REQUIRE(islands.get_island(i)[0] == bodies[i]);
+                REQUIRE(islands.get_island_index(bodies[i]) == i);
+            }
+        }
+
+        SECTION("connected bodies share an island") {
+            // two chains, 1-2-3 and 5-6, and a lone body 4
+            const std::vector<EntityId> bodies{ 1, 2, 3, 4, 5, 6 };
+            const OverlappingPairs pairs{ { 2, 3 }, { 5, 6 }, { 1, 2 } };
+            islands.build(bodies, pairs);
+            REQUIRE(islands.get_island_count() == 3);
+
+            const auto first{ islands.get_island(0) };
+            REQUIRE(std::vector<EntityId>{ first.begin(), first.end() } ==
+                    std::vector<EntityId>{ 1, 2, 3 });
+            const auto second{ islands.get_island(1) };
+            REQUIRE(std::vector<EntityId>{ second.begin(), second.end() } ==
+                    std::vector<EntityId>{ 4 });
+            const auto third{ islands.get_island(2) };
+            REQUIRE(std::vector<EntityId>{ third.begin(), third.end() } ==
+                    std::vector<EntityId>{ 5, 6 });
+
+            REQUIRE(islands.get_island_index(3) == 0);
+            REQUIRE(islands.get_island_index(6) == 2);
+        }
+
+        SECTION("bodies left out do not link islands") {
+            // 0 is a floor that both 1 and 2 rest on
+            const std::vector<EntityId> bodies{ 1, 2 };
+            const OverlappingPairs pairs{ { 0, 1 }, { 0, 2 } };
+            islands.build(bodies, pairs);
+            REQUIRE(islands.get_island_count() == 2);
+            REQUIRE(!islands.contains(0));
+            REQUIRE(islands.contains(1));
+            REQUIRE_THROWS_AS(islands.get_island_index(0), std::out_of_range);
+        }
+
+        SECTION("rebuilding replaces the islands") {
+            islands.build(std::vector<EntityId>{ 1, 2 }, { { 1, 2 } });
+            REQUIRE(islands.get_island_count() == 1);
+            islands.build(std::vector<EntityId>{ 1, 2, 3 }, {});
+            REQUIRE(islands.get_island_count() == 3);
+        }
+
+        SECTION("large island") {
+            std::vector<EntityId> bodies{};
+            OverlappingPairs pairs{};
+            for (EntityId i{ 0 }; i < 1000; ++i) {
+                bodies.push_back(i);
+            }
+            // a chain, linked from its far end
+            for (EntityId i{ 999 }; i > 0; --i) {
+                pairs.emplace_back(i - 1, i);
+            }
+            islands.build(bodies, pairs);
+            REQUIRE(islands.get_island_count() == 1);
+            REQUIRE(islands.get_island(0).size() == 1000);
+        }
+    }
+}  // namespace njin::ecs::physics
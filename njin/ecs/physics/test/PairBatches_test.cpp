@@ -0,0 +1,127 @@
+#include "physics/PairBatches.h"
+
+#include <algorithm>
+#include <set>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    namespace {
+        /**
+         * Check that every pair ends up in exactly one batch and that no
+         * body other than a fixed one appears twice in a batch
+         */
+        template<typename IsFixed>
+        void require_valid(const PairBatches& batches,
+                           OverlappingPairs pairs,
+                           IsFixed&& is_fixed) {
+            OverlappingPairs batched{};
+            for (uint32_t i{ 0 }; i < batches.get_batch_count(); ++i) {
+                std::set<EntityId> bodies{};
+                for (const auto& [first, second] : batches.get_batch(i)) {
+                    batched.emplace_back(first, second);
+                    for (EntityId body : { first, second }) {
+                        if (!is_fixed(body)) {
+                            REQUIRE(bodies.insert(body).second);
+                        }
+                    }
+                }
+                REQUIRE(std::ranges::is_sorted(batches.get_batch(i)));
+            }
+            std::ranges::sort(batched);
+            std::ranges::sort(pairs);
+            REQUIRE(batched == pairs);
+            REQUIRE(batches.size() == pairs.size());
+        }
+    }  // namespace
+
+    TEST_CASE("pair batches", "[ecs][physics][PairBatches]") {
+        PairBatches batches{};
+        auto never_fixed = [](EntityId) { return false; };
+
+        SECTION("no pairs") {
+            batches.build({});
+            REQUIRE(batches.get_batch_count() == 0);
+            REQUIRE(batches.size() == 0);
+        }
+
+        SECTION("disjoint pairs share a batch") {
+            const OverlappingPairs pairs{ { 0, 1 }, { 2, 3 }, { 4, 5 } };
+            batches.build(pairs);
+            REQUIRE(batches.get_batch_count() == 1);
+            require_valid(batches, pairs, never_fixed);
+        }
+
+        SECTION("a chain alternates between two batches") {
+            OverlappingPairs pairs{};
+            for (EntityId i{ 0 }; i < 10; ++i) {
+                pairs.emplace_back(i, i + 1);
+            }
+            batches.build(pairs);
+            REQUIRE(batches.get_batch_count() == 2);
+            require_valid(batches, pairs, never_fixed);
+        }
+
+        SECTION("fixed bodies may repeat within a batch") {
+            // a floor touching every other body
+            OverlappingPairs pairs{};
+            for (EntityId i{ 1 }; i <= 100; ++i) {
+                pairs.emplace_back(0, i);
+            }
+            auto is_floor = [](EntityId entity) { return entity == 0; };
+
+            batches.build(pairs);
+            REQUIRE(batches.get_batch_count() == 100);
+            require_valid(batches, pairs, never_fixed);
+
+            batches.build(pairs, is_floor);
+            REQUIRE(batches.get_batch_count() == 1);
+            require_valid(batches, pairs, is_floor);
+        }
+
+        SECTION("more than 64 batches") {
+            // every pair of 80 bodies, which needs at least 79 batches
+            OverlappingPairs pairs{};
+            for (EntityId i{ 0 }; i < 80; ++i) {
+                for (EntityId j{ i + 1 }; j < 80; ++j) {
+                    pairs.emplace_back(i, j);
+                }
+            }
+            batches.build(pairs);
+            REQUIRE(batches.get_batch_count() >= 79);
+            require_valid(batches, pairs, never_fixed);
+        }
+
+        SECTION("batches do not depend on the order of the pairs") {
+            OverlappingPairs pairs{};
+            for (EntityId i{ 0 }; i < 30; ++i) {
+                for (EntityId j : { (i * 7 + 3) % 31, (i * 11 + 5) % 31 }) {
+                    if (i != j) {
+                        pairs.push_back(make_entity_pair(i, j));
+                    }
+                }
+            }
+            std::ranges::sort(pairs);
+            auto [last, end]{ std::ranges::unique(pairs) };
+            pairs.erase(last, end);
+
+            batches.build(pairs);
+            std::vector<OverlappingPairs> expected{};
+            for (uint32_t i{ 0 }; i < batches.get_batch_count(); ++i) {
+                const auto batch{ batches.get_batch(i) };
+                expected.emplace_back(batch.begin(), batch.end());
+            }
+
+            std::ranges::reverse(pairs);
+            PairBatches reversed{};
+            reversed.build(pairs);
+            REQUIRE(reversed.get_batch_count() == expected.size());
+            for (uint32_t i{ 0 }; i < reversed.get_batch_count(); ++i) {
+                const auto batch{ reversed.get_batch(i) };
+                REQUIRE(OverlappingPairs{ batch.begin(), batch.end() } ==
+                        expected[i]);
+            }
+            require_valid(reversed, pairs, never_fixed);
+        }
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,262 @@
+#include "physics/Queries.h"
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "physics/Broadphase.h"
+#include "physics/ThreadPool.h"
+
+namespace njin::ecs::physics {
+    namespace {
+        /**
+         * Boxes of different sizes on a 3D grid, with gaps between them
+         * @return Primitives
+         */
+        std::vector<Primitive> make_primitives() {
+            std::vector<Primitive> primitives{};
+            for (EntityId i{ 0 }; i < 125; ++i) {
+                const math::njVec3f centroid{ static_cast<float>(i % 5) * 3.f,
+                                              static_cast<float>(i / 5 % 5) *
+                                              3.f,
+                                              static_cast<float>(i / 25) *
+                                              3.f };
+                const float size{ 0.5f + static_cast<float>(i % 3) * 0.5f };
+                primitives.emplace_back(i,
+                                        BoundingBox::make(centroid,
+                                                          size,
+                                                          size * 0.5f,
+                                                          size));
+            }
+            return primitives;
+        }
+
+        /**
+         * Queries of every type through and around the grid
+         * @param count Number of queries
+         * @return Queries
+         */
+        std::vector<Query> make_queries(uint32_t count) {
+            std::vector<Query> queries{};
+            for (uint32_t i{ 0 }; i < count; ++i) {
+                const auto f{ static_cast<float>(i) };
+                const math::njVec3f origin{ std::sin(f) * 8.f + 6.f,
+                                            std::cos(f * 0.7f) * 8.f + 6.f,
+                                            std::sin(f * 1.3f) * 8.f + 6.f };
+                const math::njVec3f direction{
+                    math::normalize(math::njVec3f{ std::cos(f * 2.1f),
+                                                   std::sin(f * 0.3f),
+                                                   std::cos(f * 1.7f) })
+                };
+                Query query{ .type = static_cast<QueryType>(i % 4),
+                             .mode = i % 8 < 4 ? CastMode::Closest
+                                               : CastMode::Any,
+                             .origin = origin,
+                             .direction = direction,
+                             .max_distance = 20.f,
+                             .box = BoundingBox::make(origin, 1.f, 1.f, 1.f) };
+                if (query.type != QueryType::Ray) {
+                    query.direction = direction * 12.f;
+                }
+                queries.push_back(query);
+            }
+            return queries;
+        }
+
+        /**
+         * Sweep a query against every primitive
+         * @param primitives Primitives to test against
+         * @param query Ray, segment or sweep query
+         * @param entity Entity to test, or nothing to find the closest
+         * @return Time of the hit, or nothing if the query hits nothing
+         */
+        std::optional<float>
+        get_brute_force_time(const std::vector<Primitive>& primitives,
+                             const Query& query,
+                             std::optional<EntityId> entity = std::nullopt) {
+            BoundingBox box{ BoundingBox::make(query.origin, 0.f, 0.f, 0.f) };
+            math::njVec3f displacement{ query.direction };
+            if (query.type == QueryType::Ray) {
+                displacement = query.direction * query.max_distance;
+            } else if (query.type == QueryType::Sweep) {
+                box = query.box;
+            }
+
+            std::optional<float> first{};
+            for (const auto& [other, other_box] : primitives) {
+                if (entity && other != *entity) {
+                    continue;
+                }
+                const auto hit{ sweep(box,
+                                      displacement,
+                                      other_box,
+                                      BoundingBoxType::XYZ) };
+                if (hit && (!first || hit->time < *first)) {
+                    first = hit->time;
+                }
+            }
+            return first;
+        }
+    }  // namespace
+
+    TEST_CASE("queries match brute force", "[ecs][physics][Queries]") {
+        const std::vector<Primitive> primitives{ make_primitives() };
+        const std::vector<Query> queries{ make_queries(400) };
+
+        for (BroadphaseType broadphase_type : { BroadphaseType::BVH,
+                                                BroadphaseType::DynamicTree,
+                                                BroadphaseType::SweepAndPrune,
+                                                BroadphaseType::SpatialHash,
+                                                BroadphaseType::WideBVH }) {
+            const auto broadphase{
+                make_broadphase(broadphase_type, BoundingBoxType::XYZ)
+            };
+            broadphase->update(primitives);
+
+            // an unbounded box overlaps everything, and nothing more
+            constexpr float INF{ std::numeric_limits<float>::infinity() };
+            const Query everywhere{ .type = QueryType::Overlap,
+                                    .box = { .min_x = -INF,
+                                             .max_x = INF,
+                                             .min_y = -INF,
+                                             .max_y = INF,
+                                             .min_z = -INF,
+                                             .max_z = INF } };
+            REQUIRE(answer_query(*broadphase, everywhere).is_hit);
+            REQUIRE(broadphase->get_overlaps(everywhere.box).size() ==
+                    primitives.size());
+
+            bool is_correct{ true };
+            uint32_t hit_count{ 0 };
+            for (const Query& query : queries) {
+                const QueryResult result{ answer_query(*broadphase, query) };
+                hit_count += result.is_hit ? 1 : 0;
+
+                if (query.type == QueryType::Overlap) {
+                    const bool does_overlap{
+                        !broadphase->get_overlaps(query.box).empty()
+                    };
+                    is_correct = is_correct && result.is_hit == does_overlap;
+                    continue;
+                }
+
+                const auto expected{
+                    get_brute_force_time(primitives, query)
+                };
+                if (!expected) {
+                    is_correct = is_correct && !result.is_hit;
+                    continue;
+                }
+                // any hit must be a real hit on the entity, and the
+                // closest hit must be the first along the query
+                const auto actual{
+                    get_brute_force_time(primitives, query, result.entity)
+                };
+                is_correct = is_correct && result.is_hit && actual &&
+                             *actual == result.time;
+                if (query.mode == CastMode::Closest) {
+                    is_correct = is_correct && result.time == *expected;
+                }
+            }
+            REQUIRE(is_correct);
+            // the queries are not all trivially empty
+            REQUIRE(hit_count > queries.size() / 4);
+        }
+    }
+
+    TEST_CASE("queries", "[ecs][physics][Queries]") {
+        const auto broadphase{
+            make_broadphase(BroadphaseType::DynamicTree, BoundingBoxType::XYZ)
+        };
+        broadphase->update({
+        { 1, BoundingBox::make({ 5.f, 0.f, 0.f }, 1.f, 1.f, 1.f) },
+        { 2, BoundingBox::make({ 10.f, 0.f, 0.f }, 1.f, 1.f, 1.f) },
+        });
+
+        SECTION("rays hit the closest entity") {
+            const Query ray{ .origin = { 0.f, 0.f, 0.f },
+                             .direction = { 1.f, 0.f, 0.f },
+                             .max_distance = 100.f };
+            const QueryResult result{ answer_query(*broadphase, ray) };
+            REQUIRE(result.is_hit);
+            REQUIRE(result.entity == 1);
+            REQUIRE(result.point == math::njVec3f{ 4.5f, 0.f, 0.f });
+            REQUIRE(result.normal == math::njVec3f{ -1.f, 0.f, 0.f });
+        }
+
+        SECTION("rays stop at their max distance") {
+            const Query ray{ .origin = { 0.f, 0.f, 0.f },
+                             .direction = { 1.f, 0.f, 0.f },
+                             .max_distance = 4.f };
+            REQUIRE_FALSE(answer_query(*broadphase, ray).is_hit);
+        }
+
+        SECTION("ignored entities are left out") {
+            const Query segment{ .type = QueryType::Segment,
+                                 .origin = { 0.f, 0.f, 0.f },
+                                 .direction = { 20.f, 0.f, 0.f },
+                                 .ignored = 1 };
+            const QueryResult result{ answer_query(*broadphase, segment) };
+            REQUIRE(result.is_hit);
+            REQUIRE(result.entity == 2);
+        }
+
+        SECTION("sweeps hit with the face of the box") {
+            const Query sweep{ .type = QueryType::Sweep,
+                               .direction = { 20.f, 0.f, 0.f },
+                               .box = BoundingBox::make({ 0.f, 0.f, 0.f },
+                                                        2.f,
+                                                        2.f,
+                                                        2.f) };
+            const QueryResult result{ answer_query(*broadphase, sweep) };
+            REQUIRE(result.is_hit);
+            REQUIRE(result.entity == 1);
+            REQUIRE(result.point == math::njVec3f{ 3.5f, 0.f, 0.f });
+        }
+
+        SECTION("the closest overlap is the nearest centroid") {
+            const Query overlap{ .type = QueryType::Overlap,
+                                 .box = BoundingBox::make({ 8.f, 0.f, 0.f },
+                                                          10.f,
+                                                          1.f,
+                                                          1.f) };
+            const QueryResult result{ answer_query(*broadphase, overlap) };
+            REQUIRE(result.is_hit);
+            REQUIRE(result.entity == 2);
+            REQUIRE(result.time == 0.f);
+        }
+    }
+
+    TEST_CASE("batched queries match single queries",
+              "[ecs][physics][Queries]") {
+        const auto broadphase{
+            make_broadphase(BroadphaseType::BVH, BoundingBoxType::XYZ)
+        };
+        broadphase->update(make_primitives());
+        const std::vector<Query> queries{ make_queries(1000) };
+
+        ThreadPool pool{ 4 };
+        std::vector<QueryResult> results{};
+        answer_queries(*broadphase, queries, results, pool);
+        REQUIRE(results.size() == queries.size());
+
+        bool is_same{ true };
+        for (size_t i{ 0 }; i < queries.size(); ++i) {
+            const QueryResult expected{ answer_query(*broadphase, queries[i]) };
+            is_same = is_same && results[i].is_hit == expected.is_hit &&
+                      results[i].entity == expected.entity &&
+                      results[i].time == expected.time;
+        }
+        REQUIRE(is_same);
+
+        // the buffer is reused for a smaller batch
+        answer_queries(*broadphase,
+                       std::span{ queries }.first(10),
+                       results,
+                       pool);
+        REQUIRE(results.size() == 10);
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,151 @@
+#include "physics/SpatialHash.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    TEST_CASE("spatial hash", "[ecs][physics][SpatialHash]") {
+        SpatialHash hash{ BoundingBoxType::XZ, 2.f };
+
+        // tile-sized bodies on both sides of the origin, and one large body
+        // spanning many cells
+        std::vector<Primitive> primitives{
+            { 0, BoundingBox::make({ -1.f, 0.f, -1.f }, 2.f, 1.f, 2.f) },
+            { 1, BoundingBox::make({ 0.5f, 0.f, -1.f }, 2.f, 1.f, 2.f) },
+            { 2, BoundingBox::make({ 10.f, 0.f, 10.f }, 2.f, 1.f, 2.f) },
+            { 3, BoundingBox::make({ 0.f, 5.f, 0.f }, 9.f, 1.f, 9.f) }
+        };
+        hash.update(primitives);
+        REQUIRE(hash.get_bounding_box(2).min_x == 9.f);
+
+        // 3 shares several cells with both 0 and 1, but every pair is
+        // reported once
+        OverlappingPairs pairs{};
+        hash.get_overlapping_pairs(pairs);
+        std::ranges::sort(pairs);
+        REQUIRE(pairs == OverlappingPairs{ { 0, 1 }, { 0, 3 }, { 1, 3 } });
+
+        std::vector<EntityId> overlaps{
+            hash.get_overlaps(BoundingBox::make({ 0.f, 0.f, 0.f },
+                                                4.f,
+                                                1.f,
+                                                4.f))
+        };
+        std::ranges::sort(overlaps);
+        REQUIRE(overlaps == std::vector<EntityId>{ 0, 1, 3 });
+
+        SECTION("Y is checked for 3D broadphases") {
+            SpatialHash hash_3d{ BoundingBoxType::XYZ, 2.f };
+            hash_3d.update(primitives);
+            hash_3d.get_overlapping_pairs(pairs);
+            REQUIRE(pairs == OverlappingPairs{ { 0, 1 } });
+        }
+
+        SECTION("moving and removing") {
+            const size_t cell_count{ hash.get_cell_count() };
+
+            // moving within the same cells
+            primitives[2].second = BoundingBox::make({ 10.2f, 0.f, 10.f },
+                                                     2.f,
+                                                     1.f,
+                                                     2.f);
+            hash.update(primitives);
+            REQUIRE(hash.get_cell_count() == cell_count);
+
+            // moving next to 0, and dropping the large body
+            primitives[2].second = BoundingBox::make({ -1.f, 0.f, -2.5f },
+                                                     2.f,
+                                                     1.f,
+                                                     2.f);
+            primitives.pop_back();
+            hash.update(primitives);
+            hash.get_overlapping_pairs(pairs);
+            std::ranges::sort(pairs);
+            REQUIRE(pairs == OverlappingPairs{ { 0, 1 }, { 0, 2 }, { 1, 2 } });
+            REQUIRE_THROWS(hash.get_bounding_box(3));
+
+            // the slot of the large body is reused
+            primitives.emplace_back(4,
+                                    BoundingBox::make({ 20.f, 0.f, 0.f },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+            hash.update(primitives);
+            REQUIRE(hash.get_overlaps(primitives.back().second) ==
+                    std::vector<EntityId>{ 4 });
+        }
+
+        SECTION("oversized and non-finite bodies") {
+            constexpr float NaN{ std::numeric_limits<float>::quiet_NaN() };
+            constexpr float LARGEST{ std::numeric_limits<float>::max() };
+
+            // a floor spanning far more cells than any body
+            primitives.emplace_back(4,
+                                    BoundingBox::make({ 0.f, -1.f, 0.f },
+                                                      1e6f,
+                                                      1.f,
+                                                      1e6f));
+            // a skybox as large as a float gets, and a broken body
+            primitives.emplace_back(5,
+                                    BoundingBox{ .min_x = -LARGEST,
+                                                 .max_x = LARGEST,
+                                                 .min_y = -LARGEST,
+                                                 .max_y = LARGEST,
+                                                 .min_z = -LARGEST,
+                                                 .max_z = LARGEST });
+            primitives.emplace_back(6,
+                                    BoundingBox::make({ NaN, 0.f, 0.f },
+                                                      1.f,
+                                                      1.f,
+                                                      1.f));
+            hash.update(primitives);
+
+            // neither is spread over cells
+            REQUIRE(hash.get_oversized_count() == 2);
+            REQUIRE(hash.get_cell_count() < 64);
+
+            // oversized bodies still pair with everything they touch
+            hash.get_overlapping_pairs(pairs);
+            std::ranges::sort(pairs);
+            REQUIRE(pairs == OverlappingPairs{ { 0, 1 },
+                                               { 0, 3 },
+                                               { 0, 4 },
+                                               { 0, 5 },
+                                               { 1, 3 },
+                                               { 1, 4 },
+                                               { 1, 5 },
+                                               { 2, 4 },
+                                               { 2, 5 },
+                                               { 3, 4 },
+                                               { 3, 5 },
+                                               { 4, 5 } });
+
+            overlaps = hash.get_overlaps(primitives[2].second);
+            std::ranges::sort(overlaps);
+            REQUIRE(overlaps == std::vector<EntityId>{ 2, 4, 5 });
+
+            // huge, unbounded and NaN queries
+            overlaps = hash.get_overlaps(primitives[5].second);
+            REQUIRE(overlaps.size() == 6);
+            constexpr float INF{ std::numeric_limits<float>::infinity() };
+            overlaps = hash.get_overlaps(BoundingBox{ .min_x = -INF,
+                                                      .max_x = INF,
+                                                      .min_y = -INF,
+                                                      .max_y = INF,
+                                                      .min_z = -INF,
+                                                      .max_z = INF });
+            REQUIRE(overlaps.size() == 6);
+            REQUIRE(hash.get_overlaps(primitives[6].second).empty());
+
+            // shrinking the floor moves it back into the grid
+            primitives[4].second = BoundingBox::make({ 0.f, -1.f, 0.f },
+                                                     2.f,
+                                                     1.f,
+                                                     2.f);
+            hash.update(primitives);
+            REQUIRE(hash.get_oversized_count() == 1);
+        }
+    }
+}  // namespace njin::ecs::physics
@@ -0,0 +1,100 @@
+#include "physics/SweepAndPrune.h"
+
+#include <algorithm>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    namespace {
+        Primitive make_primitive(EntityId entity, float x) {
+            return { entity,
+                     BoundingBox::make({ x, 0.f, 0.f }, 1.f, 1.f, 1.f) };
+        }
+
+        OverlappingPairs sorted(OverlappingPairs pairs) {
+            std::ranges::sort(pairs);
+            return pairs;
+        }
+    }  // namespace
+
+    TEST_CASE("sweep and prune", "[ecs][physics][SweepAndPrune]") {
+        SweepAndPrune sap{};
+        sap.update({ make_primitive(0, 0.f),
+                     make_primitive(1, 0.5f),
+                     make_primitive(2, 5.f) });
+        REQUIRE(sap.get_added_pairs() == OverlappingPairs{ { 0, 1 } });
+        REQUIRE(sap.get_removed_pairs().empty());
+
+        SECTION("no movement, no events") {
+            sap.update({ make_primitive(0, 0.f),
+                         make_primitive(1, 0.5f),
+                         make_primitive(2, 5.f) });
+            REQUIRE(sap.get_added_pairs().empty());
+            REQUIRE(sap.get_removed_pairs().empty());
+        }
+
+        SECTION("pairs begin and stop overlapping") {
+            // 1 moves from 0 over to 2
+            sap.update({ make_primitive(0, 0.f),
+                         make_primitive(1, 4.5f),
+                         make_primitive(2, 5.f) });
+            REQUIRE(sap.get_added_pairs() == OverlappingPairs{ { 1, 2 } });
+            REQUIRE(sap.get_removed_pairs() == OverlappingPairs{ { 0, 1 } });
+
+            OverlappingPairs pairs{};
+            sap.get_overlapping_pairs(pairs);
+            REQUIRE(pairs == OverlappingPairs{ { 1, 2 } });
+        }
+
+        SECTION("touching boxes overlap") {
+            sap.update({ make_primitive(0, 0.f),
+                         make_primitive(1, 0.5f),
+                         make_primitive(2, 1.f) });
+            REQUIRE(sorted(sap.get_added_pairs()) ==
+                    OverlappingPairs{ { 0, 2 }, { 1, 2 } });
+        }
+
+        SECTION("separated along another axis") {
+            sap.update({ make_primitive(0, 0.f),
+                         { 1,
+                           BoundingBox::make({ 0.5f, 3.f, 0.f },
+                                             1.f,
+                                             1.f,
+                                             1.f) },
+                         make_primitive(2, 5.f) });
+            REQUIRE(sap.get_removed_pairs() == OverlappingPairs{ { 0, 1 } });
+
+            // but not for a 2D broadphase
+            SweepAndPrune sap_2d{ BoundingBoxType::XZ };
+            sap_2d.update({ make_primitive(0, 0.f),
+                            { 1,
+                              BoundingBox::make({ 0.5f, 3.f, 0.f },
+                                                1.f,
+                                                1.f,
+                                                1.f) } });
+            REQUIRE(sap_2d.get_added_pairs() == OverlappingPairs{ { 0, 1 } });
+        }
+
+        SECTION("entities come and go") {
+            sap.update({ make_primitive(1, 0.5f),
+                         make_primitive(2, 5.f),
+                         make_primitive(3, 5.5f) });
+            REQUIRE(sap.get_added_pairs() == OverlappingPairs{ { 2, 3 } });
+            REQUIRE(sap.get_removed_pairs() == OverlappingPairs{ { 0, 1 } });
+
+            OverlappingPairs pairs{};
+            sap.get_overlapping_pairs(pairs);
+            REQUIRE(pairs == OverlappingPairs{ { 2, 3 } });
+            REQUIRE(sap.get_overlaps(BoundingBox::make({ 0.f, 0.f, 0.f },
+                                                       1.f,
+                                                       1.f,
+                                                       1.f)) ==
+                    std::vector<EntityId>{ 1 });
+
+            sap.update({});
+            REQUIRE(sap.get_removed_pairs() == OverlappingPairs{ { 2, 3 } });
+            sap.get_overlapping_pairs(pairs);
+            REQUIRE(pairs.empty());
+        }
+    }
+}  // namespace njin::ecs::physics
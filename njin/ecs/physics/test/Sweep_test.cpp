@@ -0,0 +1,96 @@
+#include "physics/Sweep.h"
+
+#include <cmath>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    TEST_CASE("sweep", "[ecs][physics][Sweep]") {
+        const BoundingBox box{ BoundingBox::make({ 0.f, 0.f, 0.f },
+                                                 1.f,
+                                                 1.f,
+                                                 1.f) };
+        // a thin wall the box would pass through in a single step
+        const BoundingBox wall{ BoundingBox::make({ 5.f, 0.f, 0.f },
+                                                  0.1f,
+                                                  4.f,
+                                                  4.f) };
+
+        SECTION("hits a thin wall it would tunnel through") {
+            const auto hit{ sweep(box, { 10.f, 0.f, 0.f }, wall,
+                                  BoundingBoxType::XYZ) };
+            REQUIRE(hit.has_value());
+            // the box touches the wall after moving 5 - 0.05 - 0.5
+            REQUIRE(std::abs(hit->time - 0.445f) < 1e-6f);
+            REQUIRE(hit->normal == math::njVec3f{ -1.f, 0.f, 0.f });
+        }
+
+        SECTION("hits from the other side") {
+            const BoundingBox start{ BoundingBox::make({ 10.f, 0.f, 0.f },
+                                                       1.f,
+                                                       1.f,
+                                                       1.f) };
+            const auto hit{ sweep(start, { -10.f, 0.f, 0.f }, wall,
+                                  BoundingBoxType::XYZ) };
+            REQUIRE(hit.has_value());
+            REQUIRE(std::abs(hit->time - 0.445f) < 1e-6f);
+            REQUIRE(hit->normal == math::njVec3f{ 1.f, 0.f, 0.f });
+        }
+
+        SECTION("the normal is that of the last axis to start overlapping") {
+            // moving diagonally, the box lines up with the wall along y
+            // and z long before it reaches it along x
+            const auto hit{ sweep(box, { 10.f, 1.f, 0.f }, wall,
+                                  BoundingBoxType::XYZ) };
+            REQUIRE(hit.has_value());
+            REQUIRE(hit->normal == math::njVec3f{ -1.f, 0.f, 0.f });
+        }
+
+        SECTION("misses") {
+            // too short
+            REQUIRE_FALSE(sweep(box, { 4.f, 0.f, 0.f }, wall,
+                                BoundingBoxType::XYZ));
+            // moving away
+            REQUIRE_FALSE(sweep(box, { -10.f, 0.f, 0.f }, wall,
+                                BoundingBoxType::XYZ));
+            // passing over the wall
+            REQUIRE_FALSE(sweep(box, { 10.f, 0.f, 6.f }, wall,
+                                BoundingBoxType::XYZ));
+            // not moving along an axis it does not overlap on
+            const BoundingBox above{ BoundingBox::make({ 0.f, 5.f, 0.f },
+                                                       1.f,
+                                                       1.f,
+                                                       1.f) };
+            REQUIRE_FALSE(sweep(above, { 10.f, 0.f, 0.f }, wall,
+                                BoundingBoxType::XYZ));
+        }
+
+        SECTION("only the given axes are tested") {
+            const BoundingBox above{ BoundingBox::make({ 0.f, 5.f, 0.f },
+                                                       1.f,
+                                                       1.f,
+                                                       1.f) };
+            REQUIRE(sweep(above, { 10.f, 0.f, 0.f }, wall,
+                          BoundingBoxType::XZ));
+        }
+
+        SECTION("overlapping at the start") {
+            const auto hit{ sweep(box, { 1.f, 0.f, 0.f }, box,
+                                  BoundingBoxType::XYZ) };
+            REQUIRE(hit.has_value());
+            REQUIRE(hit->time == 0.f);
+            REQUIRE(hit->normal == math::njVec3f::zero());
+        }
+
+        SECTION("swept bounds enclose both ends") {
+            const BoundingBox bounds{ get_swept_bounds(box,
+                                                       { 10.f, -2.f, 0.f }) };
+            REQUIRE(bounds.min_x == -0.5f);
+            REQUIRE(bounds.max_x == 10.5f);
+            REQUIRE(bounds.min_y == -2.5f);
+            REQUIRE(bounds.max_y == 0.5f);
+            REQUIRE(bounds.min_z == -0.5f);
+            REQUIRE(bounds.max_z == 0.5f);
+        }
+    }
+}  // namespace njin::ecs::physics
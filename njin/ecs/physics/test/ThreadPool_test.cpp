@@ -0,0 +1,83 @@
+#include "physics/ThreadPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace njin::ecs::physics {
+    TEST_CASE("thread pool", "[ecs][physics][ThreadPool]") {
+        SECTION("thread count") {
+            ThreadPool single{ 1 };
+            REQUIRE(single.get_thread_count() == 1);
+
+            ThreadPool pool{ 4 };
+            REQUIRE(pool.get_thread_count() == 4);
+
+            ThreadPool hardware{};
+            REQUIRE(hardware.get_thread_count() >= 1);
+        }
+
+        SECTION("every index runs once") {
+            for (uint32_t threads : { 1u, 2u, 4u }) {
+                ThreadPool pool{ threads };
+                for (uint32_t count : { 0u, 1u, 3u, 1000u }) {
+                    std::vector<std::atomic<uint32_t>> calls(count);
+                    pool.parallel_for(count,
+                                      [&](uint32_t i) { ++calls[i]; });
+                    for (const std::atomic<uint32_t>& call : calls) {
+                        REQUIRE(call == 1);
+                    }
+                }
+            }
+        }
+
+        SECTION("loops can be run back to back") {
+            ThreadPool pool{ 4 };
+            std::atomic<uint32_t> total{ 0 };
+            for (uint32_t loop{ 0 }; loop < 100; ++loop) {
+                pool.parallel_for(10, [&](uint32_t i) { total += i; });
+            }
+            REQUIRE(total == 100 * 45);
+        }
+
+        SECTION("loops can be run from several threads at once") {
+            ThreadPool pool{ 4 };
+            std::atomic<uint32_t> total{ 0 };
+            std::vector<std::thread> callers{};
+            for (uint32_t caller{ 0 }; caller < 4; ++caller) {
+                callers.emplace_back([&] {
+                    for (uint32_t loop{ 0 }; loop < 100; ++loop) {
+                        pool.parallel_for(10,
+                                          [&](uint32_t i) { total += i; });
+                    }
+                });
+            }
+            for (std::thread& caller : callers) {
+                caller.join();
+            }
+            REQUIRE(total == 4 * 100 * 45);
+        }
+
+        SECTION("exceptions are rethrown") {
+            ThreadPool pool{ 4 };
+            std::atomic<uint32_t> calls{ 0 };
+            auto throw_once = [&](uint32_t i) {
+                ++calls;
+                if (i == 50) {
+                    throw std::runtime_error{ "failed" };
+                }
+            };
+            REQUIRE_THROWS_AS(pool.parallel_for(100, throw_once),
+                              std::runtime_error);
+            REQUIRE(calls == 100);
+
+            // the pool is still usable afterwards
+            calls = 0;
+            pool.parallel_for(10, [&](uint32_t) { ++calls; });
+            REQUIRE(calls == 10);
+        }
+    }
+}  // namespace njin::ecs::physics
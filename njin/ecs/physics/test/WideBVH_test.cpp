@@ -0,0 +1,119 @@
+#include "physics/WideBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "BruteForce.h"
+
+namespace njin::ecs::physics {
+    namespace {
+        std::vector<Primitive> make_primitives() {
+            // a loose grid of boxes of varying sizes, some overlapping
+            std::vector<Primitive> primitives{};
+            for (EntityId i{ 0 }; i < 200; ++i) {
+                const auto phase{ static_cast<float>(i) };
+                const math::njVec3f centroid{
+                    static_cast<float>(i % 20) * 1.2f,
+                    std::sin(phase) * 3.f,
+                    static_cast<float>(i / 20) * 1.2f
+                };
+                const float size{ 1.f + std::cos(phase * 0.7f) * 0.5f };
+                primitives.emplace_back(i,
+                                        BoundingBox::make(centroid,
+                                                          size,
+                                                          size,
+                                                          size));
+            }
+            return primitives;
+        }
+
+        uint32_t get_depth(const BVH& bvh, const BVHNode& node) {
+            if (node.is_leaf()) {
+                return 1;
+            }
+            return 1 + std::max(get_depth(bvh, *bvh.get_left(node)),
+                                get_depth(bvh, *bvh.get_right(node)));
+        }
+
+        template<uint32_t Width>
+        void require_scalar_masks(const WideBVH<Width>& bvh,
+                                  const std::vector<Primitive>& primitives) {
+            for (const auto& node : bvh.get_nodes()) {
+                for (const auto& [entity, box] : primitives) {
+                    REQUIRE(get_hit_mask(node, box) ==
+                            get_hit_mask_scalar(node, box));
+                }
+            }
+        }
+    }  // namespace
+
+    TEST_CASE("wide BVH", "[ecs][physics][WideBVH]") {
+        const std::vector<Primitive> primitives{ make_primitives() };
+
+        SECTION("empty") {
+            BVH4 bvh{ {} };
+            REQUIRE(bvh.get_nodes().empty());
+            REQUIRE(bvh.get_depth() == 0);
+            REQUIRE(bvh.get_overlaps(BoundingBox{}).empty());
+        }
+
+        SECTION("single primitive") {
+            BVH8 bvh{ { primitives.front() } };
+            REQUIRE(bvh.get_nodes().size() == 1);
+            REQUIRE(bvh.get_overlaps(primitives.front().second) ==
+                    std::vector<EntityId>{ 0 });
+        }
+
+        SECTION("unbounded query box") {
+            // nodes with unused slots, which the box must not descend into
+            constexpr float INF{ std::numeric_limits<float>::infinity() };
+            const BoundingBox everywhere{ .min_x = -INF,
+                                          .max_x = INF,
+                                          .min_y = -INF,
+                                          .max_y = INF,
+                                          .min_z = -INF,
+                                          .max_z = INF };
+            const std::vector<Primitive> few{ primitives.begin(),
+                                              primitives.begin() + 3 };
+            std::vector<EntityId> overlaps{
+                BVH4{ few }.get_overlaps(everywhere)
+            };
+            std::ranges::sort(overlaps);
+            REQUIRE(overlaps == std::vector<EntityId>{ 0, 1, 2 });
+
+            for (BoundingBoxType type :
+                 { BoundingBoxType::XYZ, BoundingBoxType::XZ }) {
+                REQUIRE(BVH8{ primitives, type }.get_overlaps(everywhere)
+                        .size() == primitives.size());
+            }
+        }
+
+        for (BoundingBoxType type :
+             { BoundingBoxType::XYZ, BoundingBoxType::XZ }) {
+            for (BVHBuilder builder :
+                 { BVHBuilder::Median, BVHBuilder::BinnedSAH }) {
+                const BVH binary{ primitives, type, { .builder = builder } };
+                const uint32_t binary_depth{
+                    get_depth(binary, *binary.get_root())
+                };
+
+                const BVH4 bvh4{ binary };
+                require_brute_force(bvh4, primitives);
+                require_scalar_masks(bvh4, primitives);
+                REQUIRE(bvh4.get_depth() < binary_depth);
+                REQUIRE(bvh4.get_nodes().size() <
+                        binary.get_nodes().size() / 2);
+
+                const BVH8 bvh8{ binary };
+                require_brute_force(bvh8, primitives);
+                require_scalar_masks(bvh8, primitives);
+                REQUIRE(bvh8.get_depth() <= bvh4.get_depth());
+                REQUIRE(bvh8.get_nodes().size() <
+                        binary.get_nodes().size() / 2);
+            }
+        }
+    }
+}  // namespace njin::ecs::physics
@@ -2,8 +2,7 @@
 #include "ecs/nj2DPhysicsSystem.h"
 
 #include "ecs/Components.h"
-#include "physics/BVH.h"
-#include "physics/BVHNode.h"
+#include "physics/Broadphase.h"
 constexpr std::intmax_t TICK_RATE{ 60 };
 constexpr float DT{ 1.0 / TICK_RATE };
 
@@ -37,36 +36,42 @@ namespace {
 
 namespace njin::ecs {
 
-    nj2DPhysicsSystem::nj2DPhysicsSystem() : njSystem{ TickGroup::Two } {}
+    nj2DPhysicsSystem::nj2DPhysicsSystem(physics::BroadphaseType broadphase,
+                                         std::shared_ptr<physics::ThreadPool>
+                                         pool) :
+        njSystem{ TickGroup::Two },
+        pool_{ std::move(pool) },
+        broadphase_{ physics::make_broadphase(broadphase,
+                                              physics::BoundingBoxType::XZ,
+                                              pool_) } {}
 
     void nj2DPhysicsSystem::update(const ecs::njEntityManager& entity_manager) {
         if (!should_update()) {
             return;
         }
-        auto views{ entity_manager
-                    .get_views<nj2DPhysicsComponent, njTransformComponent>() };
-        for (const auto& view : views) {
-            auto physics{ std::get<nj2DPhysicsComponent*>(view.second) };
-            auto transform{ std::get<njTransformComponent*>(view.second) };
 
-            resolve_inputs(entity_manager);
+        resolve_inputs(entity_manager);
 
-            write_current_transforms(entity_manager);
-            calculate_new_transforms(entity_manager);
+        write_current_transforms(entity_manager);
+        calculate_new_transforms(entity_manager);
 
-            // tentative primitives
-            std::vector<physics::Primitive> primitives{
-                calculate_primitives(entity_manager)
-            };
-            physics::BVH bvh{ primitives, physics::BoundingBoxType::XZ };
-            physics::BoundingBox box{ bvh.get_bounding_box(26) };
-            physics::BoundingBox box_2{ bvh.get_bounding_box(27) };
-            if (box.does_overlap(box_2, physics::BoundingBoxType::XZ)) {
-                std::cout << "overlapping" << std::endl;
-            } else {
-                std::cout << "not overlapping" << std::endl;
-            }
-        }
+        // tentative primitives
+        std::vector<physics::Primitive> primitives{
+            calculate_primitives(entity_manager)
+        };
+        broadphase_->update(primitives);
+        broadphase_->get_overlapping_pairs(overlapping_);
+    }
+
+    void nj2DPhysicsSystem::set_broadphase(physics::BroadphaseType broadphase) {
+        broadphase_ = physics::make_broadphase(broadphase,
+                                               physics::BoundingBoxType::XZ,
+                                               pool_);
+    }
+
+    const physics::OverlappingPairs&
+    nj2DPhysicsSystem::get_overlapping_pairs() const {
+        return overlapping_;
     }
 
     bool nj2DPhysicsSystem::should_update() {
@@ -1,16 +1,51 @@
 #include "ecs/nj3DPhysicsSystem.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ranges>
+#include <span>
 
 #include "ecs/Components.h"
-#include "physics/BVH.h"
+#include "physics/Broadphase.h"
 constexpr std::intmax_t TICK_RATE{ 60 };
 constexpr float DT{ 1.0 / TICK_RATE };
 
 namespace njin::ecs {
 
     namespace {
+        // distance a bullet is stopped short of what it hits, so that it
+        // is not overlapping it through rounding
+        constexpr float CCD_SKIN{ 1e-3f };
+
+        /**
+         * Reflect the part of a vector that points into a surface
+         * @param vector Velocity or displacement
+         * @param normal Unit normal of the surface
+         * @param restitution Share of the part into the surface kept
+         * @return Reflected vector, or the vector itself if it does not
+         * point into the surface
+         */
+        math::njVec3f reflect(const math::njVec3f& vector,
+                              const math::njVec3f& normal,
+                              float restitution) {
+            const float along{ vector.x * normal.x + vector.y * normal.y +
+                               vector.z * normal.z };
+            if (along >= 0.f) {
+                return vector;
+            }
+            return vector - normal * ((1.f + restitution) * along);
+        }
+
+        /**
+         * @param physics Hot physics component of a body
+         * @return Inverse of the mass of the body. Bodies without a
+         * positive mass are treated as having unit mass.
+         */
+        float get_inverse_mass(const nj3DRigidBodyComponent& physics) {
+            return physics.mass > 0.f ? 1.f / physics.mass : 1.f;
+        }
+
         /**
          * Incorporate movement intents generated by inputs into the dynamics
          * state for this tick
@@ -19,10 +54,10 @@ namespace njin::ecs {
         void resolve_inputs(const ecs::njEntityManager& entity_manager) {
             const auto views{
                 entity_manager
-                .get_views<njMovementIntentComponent, nj3DPhysicsComponent>()
+                .get_views<njMovementIntentComponent, nj3DRigidBodyComponent>()
             };
             for (const auto& view : views | std::views::values) {
-                const auto physics{ std::get<nj3DPhysicsComponent*>(view) };
+                const auto physics{ std::get<nj3DRigidBodyComponent*>(view) };
                 const auto intent{ std::get<njMovementIntentComponent*>(view) };
 
                 if (intent->velocity_override) {
@@ -32,103 +67,29 @@ namespace njin::ecs {
                 }
             }
         }
-
-        /**
-         * Find the axis-aligned penetration vector that separates two AABBs.
-         * @param first First AABB
-         * @param second Second AABB
-         * @return Penetration vector. This is the direction the first bounding
-         * box must move in to separate from the second bounding box
-         * @note This assumes the two AABBs overlap at least along one axis
-         */
-        math::njVec3f
-        find_penetration_vector(const physics::BoundingBox& first,
-                                const physics::BoundingBox& second) {
-            // each overlap value is signed because it is the vector that first
-            // needs to move to separate from second along that axis
-
-            // we know that either first has to move along the positive
-            // direction of the given axis, or the negative direction, to
-            // separate from second
-            // therefore we can just take the minimum of the two
-            // to find the minimum depenetration vector along a given axis
-            using namespace std;
-            float x_minus{ second.min_x - first.max_x };
-            float x_plus{ second.max_x - first.min_x };
-            float x_overlap{ 0.f };
-            if (abs(x_minus) < abs(x_plus)) {
-                x_overlap = x_minus;
-            } else {
-                x_overlap = x_plus;
-            }
-
-            float y_minus{ second.min_y - first.max_y };
-            float y_plus{ second.max_y - first.min_y };
-            float y_overlap{ 0.f };
-            if (abs(y_minus) < abs(y_plus)) {
-                y_overlap = y_minus;
-            } else {
-                y_overlap = y_plus;
-            }
-
-            float z_minus{ second.min_z - first.max_z };
-            float z_plus{ second.max_z - first.min_z };
-            float z_overlap{ 0.f };
-            if (abs(z_minus) < abs(z_plus)) {
-                z_overlap = z_minus;
-            } else {
-                z_overlap = z_plus;
-            }
-
-            // when we depenetrate we move objects apart by an extra 2 * machine epsilon
-            // to avoid the situation where the objects were moved apart
-            // by their original depenetrating vector but still count as
-            // "overlapping" due to floating point imprecisions
-
-            // we can't use 1 * machine epsilon because if objects are moved
-            // away from each other by moving each object half the length of the
-            // depenetrating vector it would imply the extra offset is halved,
-            // and we can't have half of a machine epsilon by definition
-
-            // you can just remove the "* 2" portion below to see what happens
-            // -- objects are not moved apart enough and still count as overlapping
-            // and the program gets stuck in an infinite loop
-
-            float epsilon{ std::numeric_limits<float>::epsilon() * 2 };
-            // x is the smallest
-            if (abs(x_overlap) < abs(y_overlap) &&
-                abs(x_overlap) < abs(z_overlap)) {
-                if (x_overlap < 0) {
-                    return { x_overlap - epsilon, 0.f, 0.f };
-                } else {
-                    return { x_overlap + epsilon, 0.f, 0.f };
-                }
-            } else if (abs(y_overlap) < abs(x_overlap) &&
-                       abs(y_overlap) < abs(z_overlap)) {
-                // y is the smallest
-                if (y_overlap < 0) {
-                    return { 0.f, y_overlap - epsilon, 0.f };
-                } else {
-                    return { 0.f, y_overlap + epsilon, 0.f };
-                }
-            } else {
-                // z is the smallest
-                if (z_overlap < 0) {
-                    return { 0.f, 0.f, z_overlap - epsilon };
-                } else {
-                    return { 0.f, 0.f, z_overlap + epsilon };
-                }
-            }
-        }
     }  // namespace
 
-    nj3DPhysicsSystem::nj3DPhysicsSystem() : njSystem{ TickGroup::Two } {}
+    nj3DPhysicsSystem::nj3DPhysicsSystem(physics::BroadphaseType broadphase,
+                                         const physics::ContactSolverSettings&
+                                         solver,
+                                         std::shared_ptr<physics::ThreadPool>
+                                         pool) :
+        njSystem{ TickGroup::Two },
+        // a pool of one thread starts no workers
+        pool_{ pool ? std::move(pool)
+                    : std::make_shared<physics::ThreadPool>(1) },
+        broadphase_{ physics::make_broadphase(broadphase,
+                                              physics::BoundingBoxType::XYZ,
+                                              pool_) },
+        solver_{ solver } {}
 
     void nj3DPhysicsSystem::update(const ecs::njEntityManager& entity_manager) {
-        if (!should_update()) {
-            return;
+        if (should_update()) {
+            step(entity_manager);
         }
+    }
 
+    void nj3DPhysicsSystem::step(const ecs::njEntityManager& entity_manager) {
         // write information the render system needs this loop
         resolve_inputs(entity_manager);
 
@@ -142,9 +103,70 @@ namespace njin::ecs {
             calculate_primitives(entity_manager)
         };
 
-        physics::BVH bvh{ depenetrate(entity_manager, tentative_primitives) };
+        // stop fast bodies at what they would pass through before it is
+        // too late to tell
+        sweep_bullets(entity_manager, tentative_primitives);
 
-        // answer shape casts
+        depenetrate(entity_manager, tentative_primitives);
+
+        update_sleep(entity_manager);
+
+        answer_collider_queries(entity_manager);
+    }
+
+    float nj3DPhysicsSystem::get_tick_duration() {
+        return DT;
+    }
+
+    void nj3DPhysicsSystem::set_broadphase(physics::BroadphaseType broadphase) {
+        broadphase_ = physics::make_broadphase(broadphase,
+                                               physics::BoundingBoxType::XYZ,
+                                               pool_);
+
+        // sleeping bodies take their bounding boxes from the broadphase,
+        // which is empty now
+        for (SleepState& state : entity_to_sleep_ | std::views::values) {
+            state = {};
+        }
+    }
+
+    void nj3DPhysicsSystem::set_solver_settings(const physics::
+                                                ContactSolverSettings&
+                                                settings) {
+        solver_.set_settings(settings);
+    }
+
+    const physics::ContactSolverStats&
+    nj3DPhysicsSystem::get_solver_stats() const {
+        return solver_.get_stats();
+    }
+
+    void nj3DPhysicsSystem::set_sleep_time(float seconds) {
+        sleep_time_ = seconds;
+    }
+
+    size_t nj3DPhysicsSystem::get_awake_count() const {
+        return awake_count_;
+    }
+
+    size_t nj3DPhysicsSystem::get_sleeping_count() const {
+        return sleeping_count_;
+    }
+
+    bool nj3DPhysicsSystem::is_sleeping(EntityId entity) const {
+        const auto it{ entity_to_sleep_.find(entity) };
+        return it != entity_to_sleep_.end() && it->second.is_sleeping;
+    }
+
+    void nj3DPhysicsSystem::set_max_ccd_substeps(uint32_t substeps) {
+        max_ccd_substeps_ = substeps;
+    }
+
+    void nj3DPhysicsSystem::answer_queries(std::span<const physics::Query>
+                                           queries,
+                                           std::vector<physics::QueryResult>&
+                                           results) {
+        physics::answer_queries(*broadphase_, queries, results, *pool_);
     }
 
     bool nj3DPhysicsSystem::should_update() {
@@ -166,7 +188,7 @@ namespace njin::ecs {
         // we only want to change the transforms of entities managed by the
         // physics system i.e. those with an nj3DPhysicsComponent
         const auto views{ entity_manager.get_views<njTransformComponent,
-                                                   nj3DPhysicsComponent>() };
+                                                   nj3DRigidBodyComponent>() };
         for (const auto& [entity, view] : views) {
             const auto transform_comp{ std::get<njTransformComponent*>(view) };
             // if this entity is new to the physics system
@@ -183,12 +205,24 @@ namespace njin::ecs {
 
     void nj3DPhysicsSystem::calculate_new_transforms(const ecs::njEntityManager&
                                                      entity_manager) {
+        // only the hot part of the physics component is needed here
         auto views{ entity_manager
-                    .get_views<njTransformComponent, nj3DPhysicsComponent>() };
+                    .get_views<njTransformComponent, nj3DRigidBodyComponent>() };
 
         for (const auto& [entity, view] : views) {
             auto transform_comp{ std::get<njTransformComponent*>(view) };
-            auto physics_comp{ std::get<nj3DPhysicsComponent*>(view) };
+            auto physics_comp{ std::get<nj3DRigidBodyComponent*>(view) };
+
+            // sleeping bodies stay where they are, unless something gave
+            // them a velocity since
+            const auto sleep{ entity_to_sleep_.find(entity) };
+            if (sleep != entity_to_sleep_.end() && sleep->second.is_sleeping) {
+                if (math::magnitude(physics_comp->velocity) <=
+                    sleep->second.sleep_velocity) {
+                    continue;
+                }
+                sleep->second = {};
+            }
 
             // force components
             float f_x{ physics_comp->force.x };
@@ -196,10 +230,10 @@ namespace njin::ecs {
             float f_z{ physics_comp->force.z };
 
             // acceleration components
-            float m{ physics_comp->mass };
-            float a_x{ f_x / m };
-            float a_y{ f_y / m };
-            float a_z{ f_z / m };
+            float inverse_m{ get_inverse_mass(*physics_comp) };
+            float a_x{ f_x * inverse_m };
+            float a_y{ f_y * inverse_m };
+            float a_z{ f_z * inverse_m };
 
             // velocity components
             float v_x{ physics_comp->velocity.x };
@@ -236,11 +270,16 @@ namespace njin::ecs {
     nj3DPhysicsSystem::calculate_primitives(const njEntityManager&
                                             entity_manager) const {
         std::vector<physics::Primitive> primitives{};
-        auto views{ entity_manager.get_views<nj3DPhysicsComponent>() };
+        auto views{ entity_manager.get_views<nj3DColliderComponent>() };
         for (const auto& [entity, view] : views) {
-            auto physics{ std::get<nj3DPhysicsComponent*>(view) };
+            if (is_sleeping(entity)) {
+                primitives.emplace_back(entity,
+                                        broadphase_->get_bounding_box(entity));
+                continue;
+            }
+            auto collider{ std::get<nj3DColliderComponent*>(view) };
 
-            auto& c{ physics->collider };
+            auto& c{ collider->collider };
             math::njMat4f global_transform{ entity_to_transform_.at(entity) *
                                             c.transform };
             math::njVec3f g{
@@ -310,133 +349,335 @@ namespace njin::ecs {
         return primitives;
     }
 
-    physics::BVH
+    void
+    nj3DPhysicsSystem::sweep_bullets(const njEntityManager& entity_manager,
+                                     std::vector<physics::Primitive>&
+                                     primitives) {
+        bool is_indexed{ false };
+        for (auto& [entity, box] : primitives) {
+            // most bodies are not bullets, so only their collider is read
+            auto collider_view{
+                entity_manager.get_view<nj3DColliderComponent>(entity)
+            };
+            auto collider{
+                std::get<nj3DColliderComponent*>(collider_view.second)
+            };
+            if (!collider->is_bullet || is_sleeping(entity)) {
+                continue;
+            }
+            auto view{
+                entity_manager.get_view<njTransformComponent,
+                                        nj3DRigidBodyComponent>(entity)
+            };
+            auto transform_comp{ std::get<njTransformComponent*>(view.second) };
+            auto physics{ std::get<nj3DRigidBodyComponent*>(view.second) };
+            if (physics->type != RigidBodyType::Dynamic) {
+                continue;
+            }
+
+            // the transform component still holds the transform at t_i
+            math::njMat4f& transform{ entity_to_transform_.at(entity) };
+            const math::njVec3f displacement{
+                transform.get_translation_part() -
+                transform_comp->transform.get_translation_part()
+            };
+
+            // a body that moves less than half its width along every axis
+            // cannot pass through anything without being caught
+            // overlapping it, so only fast bodies pay for the sweep
+            if (std::abs(displacement.x) <= (box.max_x - box.min_x) / 2 &&
+                std::abs(displacement.y) <= (box.max_y - box.min_y) / 2 &&
+                std::abs(displacement.z) <= (box.max_z - box.min_z) / 2) {
+                continue;
+            }
+
+            // bodies added since the last tick are not in the broadphase
+            // yet, so it is filled with the tentative bounding boxes
+            // first. Static and sleeping bodies are the same there as
+            // at t_i.
+            if (!is_indexed) {
+                broadphase_->update(primitives);
+                is_indexed = true;
+            }
+
+            physics::BoundingBox current{ box.translate(-displacement) };
+            math::njVec3f remaining{ displacement };
+            math::njVec3f velocity{ physics->velocity };
+            bool was_hit{ false };
+            for (uint32_t i{ 0 }; i < max_ccd_substeps_; ++i) {
+                const auto impact{ find_time_of_impact(entity_manager,
+                                                       entity,
+                                                       current,
+                                                       remaining) };
+                if (!impact) {
+                    current = current.translate(remaining);
+                    remaining = math::njVec3f::zero();
+                    break;
+                }
+                was_hit = true;
+                const auto& [other, hit]{ *impact };
+
+                // move up to just short of the contact
+                const float length{ math::magnitude(remaining) };
+                const float time{ std::max(0.f,
+                                           hit.time - CCD_SKIN / length) };
+                current = current.translate(remaining * time);
+
+                // and bounce off it with what is left of the motion
+                auto other_view{
+                    entity_manager.get_view<nj3DColliderComponent>(other)
+                };
+                const float restitution{ std::max(
+                collider->restitution,
+                std::get<nj3DColliderComponent*>(other_view.second)
+                ->restitution) };
+                remaining = reflect(remaining * (1.f - time),
+                                    hit.normal,
+                                    restitution);
+                velocity = reflect(velocity, hit.normal, restitution);
+            }
+            if (!was_hit) {
+                continue;
+            }
+
+            // when the substeps run out, whatever motion is left is
+            // dropped and the bullet stays where it is
+            physics->velocity = velocity;
+            const math::njVec3f correction{ current.centroid - box.centroid };
+            transform = math::njMat4f{ math::njMat4Type::Translation,
+                                       correction } *
+                        transform;
+            box = current;
+        }
+    }
+
+    std::optional<std::pair<EntityId, physics::SweepHit>>
+    nj3DPhysicsSystem::find_time_of_impact(const njEntityManager&
+                                           entity_manager,
+                                           EntityId entity,
+                                           const physics::BoundingBox& box,
+                                           const math::njVec3f&
+                                           displacement) const {
+        // only static and sleeping bodies are hit, and those do not move
+        // within a tick
+        const physics::BoundingBox swept{
+            physics::get_swept_bounds(box, displacement)
+        };
+        std::optional<std::pair<EntityId, physics::SweepHit>> first{};
+        for (EntityId other : broadphase_->get_overlaps(swept)) {
+            if (other == entity) {
+                continue;
+            }
+            auto view{ entity_manager.get_view<nj3DRigidBodyComponent>(other) };
+            if (std::get<nj3DRigidBodyComponent*>(view.second)->type ==
+                RigidBodyType::Dynamic &&
+                !is_sleeping(other)) {
+                continue;
+            }
+
+            const auto hit{ physics::sweep(box,
+                                           displacement,
+                                           broadphase_->get_bounding_box(other),
+                                           broadphase_->get_type()) };
+            // bodies the bullet already overlaps are left to the contact
+            // solver
+            if (!hit || hit->normal == math::njVec3f::zero()) {
+                continue;
+            }
+            if (!first || hit->time < first->second.time) {
+                first = { other, *hit };
+            }
+        }
+        return first;
+    }
+
+    void
     nj3DPhysicsSystem::depenetrate(const njEntityManager& entity_manager,
                                    const std::vector<physics::Primitive>&
                                    primitives) {
-        physics::BVH current_bvh{ primitives };
-        physics::OverlappingPairs current_overlapping{
-            physics::get_overlapping_pairs(current_bvh)
-        };
-        // we do passes over all overlapping pairs over and over again
-        // until there are no more overlaps
-        while (current_overlapping.size() > 0) {
-            // resolve all collision pairs
-            for (auto [first, second] : current_overlapping) {
-                auto first_view{
-                    entity_manager.get_view<nj3DPhysicsComponent>(first)
-                };
-                auto first_physics{
-                    std::get<nj3DPhysicsComponent*>(first_view.second)
-                };
-                auto second_view{
-                    entity_manager.get_view<nj3DPhysicsComponent>(second)
-                };
-                auto second_physics{
-                    std::get<nj3DPhysicsComponent*>(second_view.second)
-                };
+        broadphase_->update(primitives);
+        broadphase_->get_overlapping_pairs(overlapping_);
 
-                physics::BoundingBox first_box{
-                    current_bvh.get_bounding_box(first)
-                };
-                physics::BoundingBox second_box{
-                    current_bvh.get_bounding_box(second)
-                };
-                math::njVec3f penetration_vector{
-                    find_penetration_vector(first_box, second_box)
-                };
+        wake_islands(entity_manager, primitives);
 
-                // static-static collisions -> we do nothing
-                // static objects can't move, so this basically only happens
-                // if two static objects are placed overlapping each other
-                // from the very beginning
-                if (first_physics->type == RigidBodyType::Static &&
-                    second_physics->type == RigidBodyType::Static) {
-                    continue;
-                }
+        bodies_.clear();
+        for (const auto& [entity, box] : primitives) {
+            auto view{
+                entity_manager.get_view<nj3DRigidBodyComponent,
+                                        nj3DColliderComponent>(entity)
+            };
+            auto physics{ std::get<nj3DRigidBodyComponent*>(view.second) };
+            auto collider{ std::get<nj3DColliderComponent*>(view.second) };
+
+            // static and sleeping bodies never move
+            float inverse_mass{ 0.f };
+            if (physics->type == RigidBodyType::Dynamic &&
+                !is_sleeping(entity)) {
+                inverse_mass = get_inverse_mass(*physics);
+            }
+            bodies_.push_back({ .entity = entity,
+                                .box = box,
+                                .velocity = physics->velocity,
+                                .inverse_mass = inverse_mass,
+                                .restitution = collider->restitution,
+                                .friction = collider->friction });
+        }
 
-                // dynamic-static collisions -> we move the dynamic object
-                // out of the static object
-                else if (first_physics->type == RigidBodyType::Static &&
-                         second_physics->type == RigidBodyType::Dynamic) {
-                    // the second body must move away from the first,
-                    // but the penetration vector was calculated for
-                    // moving the first body away from the second, so
-                    // we just move in the opposite direction
-                    math::njMat4f depenetrating_transform{
-                        math::njMat4Type::Translation,
-                        -penetration_vector
-                    };
-
-                    entity_to_transform_[second] = depenetrating_transform *
-                                                   entity_to_transform_[second];
-                }
+        // a fixed amount of work, instead of passing over the overlapping
+        // pairs until there are none left
+        solver_.solve(bodies_, overlapping_, *pool_);
 
-                else if (first_physics->type == RigidBodyType::Dynamic &&
-                         second_physics->type == RigidBodyType::Static) {
-                    math::njMat4f depenetrating_transform{
-                        math::njMat4Type::Translation,
-                        penetration_vector
-                    };
-
-                    entity_to_transform_[first] = depenetrating_transform *
-                                                  entity_to_transform_[first];
-
-                    // we assume a completely inelastic collision - when the
-                    // dynamic body collides with the static body it will come
-                    // to a complete stop instead of bouncing
-                    // NOTE: maybe use coefficient of restitution to determine
-                    // whether something "bounces" or not?
-                    first_physics->velocity = math::njVec3f::zero();
-                }
-                // dynamic-dynamic collisions -> we move both dynamic objects
-                // away from each other
-                else {
-                    // this isn't a very precise way of doing things,
-                    // but for now we just move each body half the length
-                    // of the penetration vector
-
-                    math::njMat4f first_depen_transform{
-                        math::njMat4Type::Translation,
-                        penetration_vector * 0.5
-                    };
-
-                    math::njMat4f second_depen_transform{
-                        math::njMat4Type::Translation,
-                        -penetration_vector * 0.5
-                    };
-
-                    entity_to_transform_[first] = first_depen_transform *
-                                                  entity_to_transform_[first];
-                    entity_to_transform_[second] = second_depen_transform *
-                                                   entity_to_transform_[second];
-                }
+        for (const physics::SolverBody& body : bodies_) {
+            if (body.inverse_mass == 0.f) {
+                continue;
             }
-            // update the overlapping pairs
-            current_bvh = physics::BVH{ calculate_primitives(entity_manager) };
-            current_overlapping = physics::get_overlapping_pairs(current_bvh);
-        };
+            auto view{
+                entity_manager.get_view<nj3DRigidBodyComponent>(body.entity)
+            };
+            std::get<nj3DRigidBodyComponent*>(view.second)->velocity =
+            body.velocity;
+
+            math::njMat4f& transform{ entity_to_transform_.at(body.entity) };
+            transform = math::njMat4f{ math::njMat4Type::Translation,
+                                       body.displacement } *
+                        transform;
+        }
+
+        // bodies only moved a little, which broadphases can take
+        // advantage of
+        broadphase_->update(calculate_primitives(entity_manager));
 
         // depenetration done, write the collider bounds to the physics
         // component
         for (const auto& [entity, _] : primitives) {
-            physics::BoundingBox box{ current_bvh.get_bounding_box(entity) };
-            auto view{ entity_manager.get_view<nj3DPhysicsComponent>(entity) };
-            auto physics{ std::get<nj3DPhysicsComponent*>(view.second) };
+            physics::BoundingBox box{ broadphase_->get_bounding_box(entity) };
+            auto view{ entity_manager.get_view<nj3DColliderComponent>(entity) };
+            auto collider{ std::get<nj3DColliderComponent*>(view.second) };
 
             // the centroid of the bounding box is in global space,
             // because we prefer the physics system (particularly depenetration)
             // to work in global space.
             // but for the colliders in the physics component,
             // we only care about the local transform
-            physics->current_collider = {
-                .transform = physics->current_collider.transform,
+            collider->current_collider = {
+                .transform = collider->current_collider.transform,
                 .x_width = box.max_x - box.min_x,
                 .y_width = box.max_y - box.min_y,
                 .z_width = box.max_z - box.min_z
             };
         }
+    }
+
+    void
+    nj3DPhysicsSystem::wake_islands(const njEntityManager& entity_manager,
+                                    const std::vector<physics::Primitive>&
+                                    primitives) {
+        dynamic_bodies_.clear();
+        for (const auto& [entity, box] : primitives) {
+            auto view{
+                entity_manager.get_view<nj3DRigidBodyComponent>(entity)
+            };
+            if (std::get<nj3DRigidBodyComponent*>(view.second)->type ==
+                RigidBodyType::Dynamic) {
+                dynamic_bodies_.push_back(entity);
+            }
+        }
+
+        // static bodies are left out, so that everything resting on the
+        // same floor does not end up in one island
+        islands_.build(dynamic_bodies_, overlapping_);
+        for (uint32_t i{ 0 }; i < islands_.get_island_count(); ++i) {
+            const std::span<const EntityId> island{ islands_.get_island(i) };
+            const bool is_awake{ std::ranges::any_of(island,
+                                                     [this](EntityId entity) {
+                return !is_sleeping(entity);
+            }) };
+            if (!is_awake) {
+                continue;
+            }
+            for (EntityId entity : island) {
+                SleepState& state{ entity_to_sleep_[entity] };
+                if (state.is_sleeping) {
+                    state = {};
+                }
+            }
+        }
+    }
+
+    void nj3DPhysicsSystem::update_sleep(const njEntityManager&
+                                         entity_manager) {
+        // forget bodies that are gone or no longer dynamic
+        std::erase_if(entity_to_sleep_, [this](const auto& entry) {
+            return !islands_.contains(entry.first);
+        });
+
+        awake_count_ = 0;
+        sleeping_count_ = 0;
+        for (uint32_t i{ 0 }; i < islands_.get_island_count(); ++i) {
+            const std::span<const EntityId> island{ islands_.get_island(i) };
+            if (is_sleeping(island.front())) {
+                // islands are woken as a whole, so all of it is asleep
+                sleeping_count_ += island.size();
+                continue;
+            }
+
+            bool can_sleep{ true };
+            for (EntityId entity : island) {
+                auto view{
+                    entity_manager.get_view<nj3DRigidBodyComponent,
+                                            nj3DColliderComponent>(entity)
+                };
+                auto physics{ std::get<nj3DRigidBodyComponent*>(view.second) };
+                auto collider{ std::get<nj3DColliderComponent*>(view.second) };
+                SleepState& state{ entity_to_sleep_[entity] };
+                state.sleep_velocity = collider->sleep_velocity;
+                if (math::magnitude(physics->velocity) <
+                    collider->sleep_velocity) {
+                    state.rest_time += DT;
+                } else {
+                    state.rest_time = 0.f;
+                }
+                can_sleep = can_sleep && state.rest_time >= sleep_time_;
+            }
+
+            if (!can_sleep) {
+                awake_count_ += island.size();
+                continue;
+            }
+            for (EntityId entity : island) {
+                auto view{
+                    entity_manager.get_view<nj3DRigidBodyComponent>(entity)
+                };
+                std::get<nj3DRigidBodyComponent*>(view.second)->velocity =
+                math::njVec3f::zero();
+                entity_to_sleep_[entity].is_sleeping = true;
+            }
+            sleeping_count_ += island.size();
+        }
+    }
 
-        return current_bvh;
+    void nj3DPhysicsSystem::answer_collider_queries(const njEntityManager&
+                                                    entity_manager) {
+        auto views{ entity_manager.get_views<njCollidersComponent>() };
+
+        // gather every query into one batch, so that they are spread over
+        // the threads evenly however they are split between entities
+        queries_.clear();
+        for (const auto& view : views | std::views::values) {
+            const auto colliders{ std::get<njCollidersComponent*>(view) };
+            queries_.insert(queries_.end(),
+                            colliders->queries.begin(),
+                            colliders->queries.end());
+        }
+
+        answer_queries(queries_, results_);
+
+        auto result{ results_.begin() };
+        for (const auto& view : views | std::views::values) {
+            const auto colliders{ std::get<njCollidersComponent*>(view) };
+            const auto count{ colliders->queries.size() };
+            colliders->results.assign(result, result + count);
+            result += count;
+        }
     }
 }  // namespace njin::ecs
\ No newline at end of file
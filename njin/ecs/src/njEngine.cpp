@@ -1,10 +1,21 @@
 #include "ecs/njEngine.h"
 
+#include <array>
+
 namespace njin::ecs {
+    namespace {
+        constexpr std::array<TickGroup, 5> TICK_GROUPS{ TickGroup::Zero,
+                                                       TickGroup::One,
+                                                       TickGroup::Two,
+                                                       TickGroup::Three,
+                                                       TickGroup::Four };
+    }  // namespace
+
     njEngine::njEngine() {}
 
     void njEngine::add_system(std::unique_ptr<njSystem> system) {
         const TickGroup tick_group{ system->get_tick_group() };
+        system->scheduler_ = &scheduler_;
 
         TickGroupSystems& systems{ tick_group_to_systems_[tick_group] };
         systems.push_back(std::move(system));
@@ -24,11 +35,48 @@ namespace njin::ecs {
     }
 
     void njEngine::update() {
-        update_tick_group(TickGroup::Zero);
-        update_tick_group(TickGroup::One);
-        update_tick_group(TickGroup::Two);
-        update_tick_group(TickGroup::Three);
-        update_tick_group(TickGroup::Four);
+        // tasks waiting on the next tick or on finished jobs continue
+        // before any system runs
+        scheduler_.resume();
+
+        for (TickGroup group : TICK_GROUPS) {
+            update_tick_group(group);
+        }
+
+        // systems are done with their views, so storage can move around.
+        // Suspended tasks fetch theirs again when they are resumed.
+        if (compaction_budget_) {
+            entity_manager_.compact(*compaction_budget_);
+        }
+    }
+
+    void njEngine::spawn(njTask<> task) {
+        scheduler_.spawn(std::move(task));
+    }
+
+    size_t njEngine::get_task_count() const {
+        return scheduler_.get_task_count();
+    }
+
+    void njEngine::set_compaction_budget(std::optional<njSystem::Budget>
+                                         budget) {
+        compaction_budget_ = budget;
+    }
+
+    std::vector<njSliceReport> njEngine::get_slice_reports() const {
+        std::vector<njSliceReport> reports{};
+        for (TickGroup group : TICK_GROUPS) {
+            if (!tick_group_to_systems_.contains(group)) {
+                continue;
+            }
+            for (const auto& system : tick_group_to_systems_.at(group)) {
+                reports.push_back({ .system = system.get(),
+                                    .tick_group = group,
+                                    .time_sliced = system->is_time_sliced(),
+                                    .slices = system->get_slice_count() });
+            }
+        }
+        return reports;
     }
 
     void njEngine::update_tick_group(TickGroup group) {
@@ -0,0 +1,117 @@
+#include "ecs/njEntityManagerStats.h"
+
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#include <cstdlib>
+#include <memory>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define NJIN_HAS_CXXABI
+#endif
+
+namespace rj = rapidjson;
+
+namespace njin::ecs {
+    namespace {
+        using Writer = rj::PrettyWriter<rj::StringBuffer>;
+
+        void write_component(Writer& writer, const njComponentStats& stats) {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(stats.name.c_str());
+            writer.Key("count");
+            writer.Uint64(stats.count);
+            writer.Key("component_size");
+            writer.Uint64(stats.component_size);
+            writer.Key("bytes_used");
+            writer.Uint64(stats.bytes_used);
+            writer.Key("bytes_reserved");
+            writer.Uint64(stats.bytes_reserved);
+            writer.Key("load_factor");
+            writer.Double(stats.load_factor);
+            writer.Key("fragmentation");
+            writer.Double(stats.fragmentation);
+            writer.EndObject();
+        }
+
+        void write_signature(Writer& writer, const njSignatureStats& stats) {
+            writer.StartObject();
+            writer.Key("signature");
+            writer.Uint64(stats.signature);
+            writer.Key("components");
+            writer.StartArray();
+            for (const std::string& component : stats.components) {
+                writer.String(component.c_str());
+            }
+            writer.EndArray();
+            writer.Key("entity_count");
+            writer.Uint64(stats.entity_count);
+            writer.Key("bytes_reserved");
+            writer.Uint64(stats.bytes_reserved);
+            writer.EndObject();
+        }
+
+        void write_map(Writer& writer, const njMapStats& stats) {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(stats.name.c_str());
+            writer.Key("size");
+            writer.Uint64(stats.size);
+            writer.Key("bucket_count");
+            writer.Uint64(stats.bucket_count);
+            writer.Key("load_factor");
+            writer.Double(stats.load_factor);
+            writer.Key("bytes_reserved");
+            writer.Uint64(stats.bytes_reserved);
+            writer.EndObject();
+        }
+    }  // namespace
+
+    std::string demangle(const char* name) {
+#ifdef NJIN_HAS_CXXABI
+        int status{ 0 };
+        std::unique_ptr<char, decltype(&std::free)>
+        demangled{ abi::__cxa_demangle(name, nullptr, nullptr, &status),
+                   &std::free };
+        if (status == 0 && demangled) {
+            return demangled.get();
+        }
+#endif
+        return name;
+    }
+
+    std::string njEntityManagerStats::to_json() const {
+        rj::StringBuffer buffer{};
+        Writer writer{ buffer };
+
+        writer.StartObject();
+        writer.Key("entity_count");
+        writer.Uint64(entity_count);
+
+        writer.Key("components");
+        writer.StartArray();
+        for (const njComponentStats& stats : components) {
+            write_component(writer, stats);
+        }
+        writer.EndArray();
+
+        writer.Key("signatures");
+        writer.StartArray();
+        for (const njSignatureStats& stats : signatures) {
+            write_signature(writer, stats);
+        }
+        writer.EndArray();
+
+        writer.Key("maps");
+        writer.StartArray();
+        for (const njMapStats& stats : maps) {
+            write_map(writer, stats);
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        return buffer.GetString();
+    }
+}  // namespace njin::ecs
\ No newline at end of file
@@ -36,7 +36,7 @@ namespace njin::ecs {
     void njMovementSystem::update(const ecs::njEntityManager& entity_manager) {
         auto views{ entity_manager
                     .get_views<njInputComponent, njMovementIntentComponent>() };
-        for (auto& view : views) {
+        for_each_sliced(views, [](const auto& view) {
             auto input{ std::get<njInputComponent*>(view.second) };
             auto intent{ std::get<njMovementIntentComponent*>(view.second) };
 
@@ -44,7 +44,7 @@ namespace njin::ecs {
 
             // directly override the velocity
             intent->velocity = direction;
-        }
+        });
     }
 
     math::njMat4f
@@ -9,7 +9,9 @@ namespace njin::ecs {
                                                entity_manager) const {
         EntityId id{ entity_manager.add_entity(info_.name) };
         entity_manager.add_component(id, info_.transform);
-        entity_manager.add_component(id, info_.mesh);
+        // objects are mostly level geometry built from a handful of
+        // mesh / texture pairs, so they share their mesh component
+        entity_manager.add_shared_component(id, info_.mesh);
 
         return id;
     }
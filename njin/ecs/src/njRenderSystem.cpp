@@ -210,6 +210,34 @@ namespace njin::ecs {
             renderables.push_back(renderable);
         }
 
+        // shared meshes with no parent entity, one group per distinct
+        // mesh / texture pair
+        const auto shared_meshes{
+            entity_manager.get_shared_groups<njMeshComponent>()
+        };
+        for (const auto& group : shared_meshes) {
+            const njMeshComponent& mesh{ *group.value };
+            for (EntityId entity : *group.entities) {
+                if (!entity_manager.is_enabled(entity) ||
+                    !entity_manager.has_components<njTransformComponent>(
+                    entity) ||
+                    entity_manager.has_components<njParentComponent>(entity)) {
+                    continue;
+                }
+                auto transform{ std::get<njTransformComponent*>(
+                entity_manager.get_view<njTransformComponent>(entity)
+                .second) };
+                core::MeshData data{
+                    .global_transform = transform->transform,
+                    .mesh_name = mesh.mesh,
+                    .texture_name = mesh.texture,
+                };
+                core::Renderable renderable{ .type = RenderType::Mesh,
+                                             .data = data };
+                renderables.push_back(renderable);
+            }
+        }
+
         // colliders
         auto colliders{ entity_manager.get_views<njTransformComponent,
                                                  nj2DPhysicsComponent>() };
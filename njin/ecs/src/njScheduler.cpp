@@ -0,0 +1,63 @@
+#include "ecs/njScheduler.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace njin::ecs {
+    void njScheduler::spawn(njTask<> task) {
+        njTask<>::Handle handle{ task.get_handle() };
+        handle.promise().scheduler = this;
+        wait(handle, {});
+        tasks_.push_back(std::move(task));
+    }
+
+    void njScheduler::wait(std::coroutine_handle<> handle, Condition ready) {
+        waiting_.push_back({ handle, std::move(ready) });
+    }
+
+    void njScheduler::resume() {
+        // tasks that wait again while being resumed go into a fresh list,
+        // so they are not resumed twice in the same call
+        std::vector<Waiting> waiting{ std::move(waiting_) };
+        waiting_ = {};
+        for (Waiting& entry : waiting) {
+            if (entry.ready && !entry.ready()) {
+                waiting_.push_back(std::move(entry));
+                continue;
+            }
+            entry.handle.resume();
+        }
+
+        // destroy finished tasks, keeping the first exception around
+        std::exception_ptr exception{};
+        std::erase_if(tasks_, [&exception](const njTask<>& task) {
+            if (!task.is_done()) {
+                return false;
+            }
+            if (!exception) {
+                exception = task.get_handle().promise().exception;
+            }
+            return true;
+        });
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    size_t njScheduler::get_task_count() const {
+        return tasks_.size();
+    }
+
+    njFutureAwaiter<std::string> read_file_async(std::filesystem::path path) {
+        return when_ready(std::async(std::launch::async, [path] {
+            std::ifstream file{ path, std::ios::binary };
+            if (!file) {
+                throw std::runtime_error("could not read " + path.string());
+            }
+            std::stringstream contents{};
+            contents << file.rdbuf();
+            return contents.str();
+        }));
+    }
+}  // namespace njin::ecs
\ No newline at end of file
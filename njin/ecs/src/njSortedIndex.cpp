@@ -0,0 +1,99 @@
+#include "ecs/njSortedIndex.h"
+
+namespace njin::ecs {
+    void njSortedIndex::insert(EntityId entity, Key key) {
+        if (entity_to_key_.contains(entity)) {
+            update(entity, key);
+            return;
+        }
+
+        const size_t position{ lower_bound(entity, key) };
+        keys_.insert(keys_.begin() + position, key);
+        entities_.insert(entities_.begin() + position, entity);
+        entity_to_key_.insert({ entity, key });
+    }
+
+    void njSortedIndex::remove(EntityId entity) {
+        if (!entity_to_key_.contains(entity)) {
+            return;
+        }
+
+        const size_t position{ lower_bound(entity, entity_to_key_.at(entity)) };
+        keys_.erase(keys_.begin() + position);
+        entities_.erase(entities_.begin() + position);
+        entity_to_key_.erase(entity);
+    }
+
+    void njSortedIndex::update(EntityId entity, Key key) {
+        const Key old_key{ entity_to_key_.at(entity) };
+        if (old_key == key) {
+            return;
+        }
+
+        // shift the entries between the old and the new position by one
+        // instead of erasing and inserting, which would move every entry
+        // after them
+        size_t from{ lower_bound(entity, old_key) };
+        const size_t to{ lower_bound(entity, key) };
+        if (to > from) {
+            // moving right, the entry itself is still counted in `to`
+            for (; from + 1 < to; ++from) {
+                keys_[from] = keys_[from + 1];
+                entities_[from] = entities_[from + 1];
+            }
+        } else {
+            for (; from > to; --from) {
+                keys_[from] = keys_[from - 1];
+                entities_[from] = entities_[from - 1];
+            }
+        }
+        keys_[from] = key;
+        entities_[from] = entity;
+        entity_to_key_.at(entity) = key;
+    }
+
+    bool njSortedIndex::contains(EntityId entity) const {
+        return entity_to_key_.contains(entity);
+    }
+
+    size_t njSortedIndex::size() const {
+        return entities_.size();
+    }
+
+    std::span<const njSortedIndex::EntityId>
+    njSortedIndex::get_entities() const {
+        return entities_;
+    }
+
+    std::vector<njSortedIndex::Run> njSortedIndex::get_runs() const {
+        std::vector<Run> runs{};
+        size_t begin{ 0 };
+        for (size_t i{ 1 }; i <= keys_.size(); ++i) {
+            if (i == keys_.size() || keys_[i] != keys_[begin]) {
+                runs.push_back({ keys_[begin],
+                                 std::span{ entities_ }.subspan(begin,
+                                                                i - begin) });
+                begin = i;
+            }
+        }
+        return runs;
+    }
+
+    size_t njSortedIndex::lower_bound(EntityId entity, Key key) const {
+        // binary search over the parallel arrays
+        size_t low{ 0 };
+        size_t high{ keys_.size() };
+        while (low < high) {
+            const size_t middle{ low + (high - low) / 2 };
+            const bool before{ keys_[middle] < key ||
+                               (keys_[middle] == key &&
+                                entities_[middle] < entity) };
+            if (before) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+}  // namespace njin::ecs
\ No newline at end of file
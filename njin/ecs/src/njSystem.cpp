@@ -1,5 +1,7 @@
 #include "ecs/njSystem.h"
 
+#include <stdexcept>
+
 namespace njin::ecs {
 
     njSystem::njSystem(TickGroup group) : tick_group_{ group } {}
@@ -7,4 +9,27 @@ namespace njin::ecs {
     TickGroup njSystem::get_tick_group() const {
         return tick_group_;
     }
+
+    void njSystem::set_time_budget(Budget budget) {
+        budget_ = budget;
+    }
+
+    void njSystem::clear_time_budget() {
+        budget_.reset();
+    }
+
+    bool njSystem::is_time_sliced() const {
+        return budget_.has_value();
+    }
+
+    uint32_t njSystem::get_slice_count() const {
+        return last_slices_;
+    }
+
+    void njSystem::spawn(njTask<> task) {
+        if (!scheduler_) {
+            throw std::logic_error("system was not added to an engine");
+        }
+        scheduler_->spawn(std::move(task));
+    }
 }  // namespace njin::ecs
\ No newline at end of file
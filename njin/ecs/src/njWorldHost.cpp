@@ -0,0 +1,101 @@
+#include "ecs/njWorldHost.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace njin::ecs {
+    njWorldHost::njWorldHost(uint32_t shard_count,
+                             uint32_t pool_thread_count) :
+        pool_{ std::make_shared<physics::ThreadPool>(pool_thread_count) } {
+        if (shard_count == 0) {
+            throw std::invalid_argument("njWorldHost needs at least 1 shard");
+        }
+
+        shard_worlds_.resize(shard_count);
+        for (size_t shard{ 0 }; shard < shard_count; ++shard) {
+            workers_.emplace_back(&njWorldHost::run_shard, this, shard);
+        }
+    }
+
+    njWorldHost::~njWorldHost() {
+        {
+            std::lock_guard lock{ mutex_ };
+            stopping_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t njWorldHost::add_world(std::unique_ptr<njEngine> world) {
+        std::lock_guard lock{ mutex_ };
+        const size_t index{ worlds_.size() };
+        shard_worlds_[index % shard_worlds_.size()].push_back(world.get());
+        worlds_.push_back(std::move(world));
+
+        return index;
+    }
+
+    njEngine& njWorldHost::get_world(size_t index) {
+        return *worlds_.at(index);
+    }
+
+    size_t njWorldHost::get_world_count() const {
+        return worlds_.size();
+    }
+
+    uint32_t njWorldHost::get_shard_count() const {
+        return static_cast<uint32_t>(shard_worlds_.size());
+    }
+
+    std::shared_ptr<physics::ThreadPool> njWorldHost::get_thread_pool() const {
+        return pool_;
+    }
+
+    void njWorldHost::update() {
+        std::unique_lock lock{ mutex_ };
+        pending_ = get_shard_count();
+        ++generation_;
+        start_.notify_all();
+
+        done_.wait(lock, [this] { return pending_ == 0; });
+        if (exception_) {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
+    }
+
+    void njWorldHost::run_shard(size_t shard) {
+        uint64_t seen{ 0 };
+        std::unique_lock lock{ mutex_ };
+        while (true) {
+            start_.wait(lock,
+                        [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+
+            // the world list of a shard only changes between updates
+            const std::vector<njEngine*>& worlds{ shard_worlds_[shard] };
+            lock.unlock();
+            for (njEngine* world : worlds) {
+                // one failing world does not stop the rest of the shard
+                try {
+                    world->update();
+                } catch (...) {
+                    std::lock_guard exception_lock{ mutex_ };
+                    if (!exception_) {
+                        exception_ = std::current_exception();
+                    }
+                }
+            }
+            lock.lock();
+
+            --pending_;
+            if (pending_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+}  // namespace njin::ecs
\ No newline at end of file
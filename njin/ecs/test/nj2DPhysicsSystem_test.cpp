@@ -0,0 +1,64 @@
+#include "ecs/nj2DPhysicsSystem.h"
+
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/Components.h"
+#include "ecs/njEntityManager.h"
+
+namespace njin::ecs {
+    namespace {
+        /**
+         * Add a square at rest
+         * @param manager Entity manager to add the square to
+         * @param x Position of the square along x
+         * @param z Position of the square along z
+         * @return Entity of the square
+         */
+        EntityId add_square(njEntityManager& manager, float x, float z) {
+            const EntityId entity{ manager.add_entity("") };
+            manager.add_component(entity,
+                                  njTransformComponent::make(x, 0.f, z));
+            manager.add_component(entity,
+                                  nj2DPhysicsComponent{
+                                  .mass = 1.f,
+                                  .collider = { .x_width = 1.f,
+                                                .z_width = 1.f } });
+            return entity;
+        }
+
+        /**
+         * Wait for the tick interval to pass, then update once
+         * @param physics Physics system to tick
+         * @param manager Entity manager
+         */
+        void tick(nj2DPhysicsSystem& physics, const njEntityManager& manager) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+            physics.update(manager);
+        }
+    }  // namespace
+
+    TEST_CASE("nj2DPhysicsSystem", "[ecs][nj2DPhysicsSystem]") {
+        njEntityManager manager{};
+        const EntityId a{ add_square(manager, 0.f, 0.f) };
+        const EntityId b{ add_square(manager, 0.5f, 0.5f) };
+        add_square(manager, 5.f, 0.f);
+
+        for (physics::BroadphaseType broadphase :
+             { physics::BroadphaseType::SpatialHash,
+               physics::BroadphaseType::SweepAndPrune,
+               physics::BroadphaseType::BVH }) {
+            nj2DPhysicsSystem physics{ broadphase };
+            REQUIRE(physics.get_overlapping_pairs().empty());
+
+            tick(physics, manager);
+            const physics::OverlappingPairs& pairs{
+                physics.get_overlapping_pairs()
+            };
+            REQUIRE(pairs.size() == 1);
+            REQUIRE(pairs[0] == physics::make_entity_pair(a, b));
+        }
+    }
+}  // namespace njin::ecs
@@ -0,0 +1,298 @@
+#include "ecs/nj3DPhysicsSystem.h"
+
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/Components.h"
+#include "ecs/njEntityManager.h"
+
+namespace njin::ecs {
+    namespace {
+        /**
+         * Add a simulated body
+         * @param manager Entity manager to add the body to
+         * @param position Centre of the body
+         * @param physics Physics component of the body
+         * @return Entity of the body
+         */
+        EntityId add_body(njEntityManager& manager,
+                          const math::njVec3f& position,
+                          const nj3DPhysicsComponent& physics) {
+            const EntityId entity{ manager.add_entity("") };
+            manager.add_component(entity,
+                                  njTransformComponent::make(position.x,
+                                                             position.y,
+                                                             position.z));
+            manager.add_component(entity, physics);
+            return entity;
+        }
+
+        /**
+         * Add a cube with a unit mass
+         * @param manager Entity manager to add the cube to
+         * @param position Centre of the cube
+         * @param size Width of the cube
+         * @param type Static or dynamic
+         * @param velocity Starting velocity
+         * @return Entity of the cube
+         */
+        EntityId add_box(njEntityManager& manager,
+                         const math::njVec3f& position,
+                         float size,
+                         RigidBodyType type,
+                         const math::njVec3f& velocity = {}) {
+            return add_body(manager,
+                            position,
+                            { .velocity = velocity,
+                              .mass = 1.f,
+                              .collider = { .x_width = size,
+                                            .y_width = size,
+                                            .z_width = size },
+                              .type = type });
+        }
+
+        /**
+         * Add a static wall facing the x axis, thinner than a bullet moves
+         * in a tick
+         * @param manager Entity manager to add the wall to
+         * @param x Position of the wall along x
+         * @return Entity of the wall
+         */
+        EntityId add_wall(njEntityManager& manager, float x) {
+            return add_body(manager,
+                            { x, 0.f, 0.f },
+                            { .collider = { .x_width = 0.1f,
+                                            .y_width = 4.f,
+                                            .z_width = 4.f },
+                              .type = RigidBodyType::Static });
+        }
+
+        /**
+         * Add a small body flying along x at 10 units per tick
+         * @param manager Entity manager to add the body to
+         * @param is_bullet Whether the body is swept
+         * @param restitution Share of its speed kept on impact
+         * @return Entity of the body
+         */
+        EntityId add_projectile(njEntityManager& manager,
+                                bool is_bullet,
+                                float restitution = 0.f) {
+            return add_body(manager,
+                            {},
+                            { .velocity = { 600.f, 0.f, 0.f },
+                              .mass = 1.f,
+                              .collider = { .x_width = 0.2f,
+                                            .y_width = 0.2f,
+                                            .z_width = 0.2f },
+                              .type = RigidBodyType::Dynamic,
+                              .restitution = restitution,
+                              .is_bullet = is_bullet });
+        }
+
+        /**
+         * @param manager Entity manager the entity belongs to
+         * @param entity Entity to get the velocity of
+         * @return Velocity of the entity
+         */
+        math::njVec3f get_velocity(const njEntityManager& manager,
+                                   EntityId entity) {
+            auto view{ manager.get_view<nj3DRigidBodyComponent>(entity) };
+            return std::get<nj3DRigidBodyComponent*>(view.second)->velocity;
+        }
+
+        /**
+         * @param manager Entity manager the entity belongs to
+         * @param entity Entity to get the position of
+         * @return Position the physics system last wrote for the entity
+         */
+        math::njVec3f get_position(const njEntityManager& manager,
+                                   EntityId entity) {
+            auto view{ manager.get_view<njTransformComponent>(entity) };
+            return std::get<njTransformComponent*>(view.second)
+            ->transform.get_translation_part();
+        }
+
+        void step(nj3DPhysicsSystem& physics,
+                  const njEntityManager& manager,
+                  int ticks) {
+            for (int i{ 0 }; i < ticks; ++i) {
+                physics.step(manager);
+            }
+        }
+    }  // namespace
+
+    TEST_CASE("nj3DPhysicsSystem", "[ecs][nj3DPhysicsSystem]") {
+        constexpr float SLEEP_TIME{ 0.25f };
+        const int sleep_ticks{
+            static_cast<int>(SLEEP_TIME /
+                             nj3DPhysicsSystem::get_tick_duration())
+        };
+
+        njEntityManager manager{};
+        nj3DPhysicsSystem physics{};
+        physics.set_sleep_time(SLEEP_TIME);
+
+        // a stack of three cubes resting on a floor
+        add_box(manager, { 0.f, -5.f, 0.f }, 10.f, RigidBodyType::Static);
+        std::vector<EntityId> stack{};
+        for (int i{ 0 }; i < 3; ++i) {
+            stack.push_back(add_box(manager,
+                                    { 0.f, 0.5f + 0.99f * i, 0.f },
+                                    1.f,
+                                    RigidBodyType::Dynamic));
+        }
+
+        SECTION("a resting stack falls asleep after the sleep time") {
+            step(physics, manager, sleep_ticks - 2);
+            REQUIRE(physics.get_awake_count() == 3);
+            REQUIRE(physics.get_sleeping_count() == 0);
+
+            step(physics, manager, 4);
+            REQUIRE(physics.get_awake_count() == 0);
+            REQUIRE(physics.get_sleeping_count() == 3);
+
+            // sleeping bodies stay where they are
+            const math::njVec3f top{ get_position(manager, stack.back()) };
+            step(physics, manager, 10);
+            REQUIRE(get_position(manager, stack.back()) == top);
+            bool is_correct{ true };
+            for (EntityId entity : stack) {
+                is_correct = is_correct && physics.is_sleeping(entity);
+            }
+            REQUIRE(is_correct);
+        }
+
+        SECTION("an awake body touching a sleeping island wakes it") {
+            step(physics, manager, sleep_ticks + 2);
+            REQUIRE(physics.get_sleeping_count() == 3);
+
+            // a cube sliding into the middle of the stack
+            const EntityId slider{ add_box(manager,
+                                           { 5.f, 1.5f, 0.f },
+                                           1.f,
+                                           RigidBodyType::Dynamic,
+                                           { -30.f, 0.f, 0.f }) };
+            physics.step(manager);
+            REQUIRE(physics.get_awake_count() == 1);
+            REQUIRE(physics.get_sleeping_count() == 3);
+
+            step(physics, manager, 10);
+            REQUIRE_FALSE(physics.is_sleeping(slider));
+            REQUIRE(physics.get_awake_count() == 4);
+            REQUIRE(physics.get_sleeping_count() == 0);
+            bool is_correct{ true };
+            for (EntityId entity : stack) {
+                is_correct = is_correct && !physics.is_sleeping(entity);
+            }
+            REQUIRE(is_correct);
+        }
+
+        SECTION("giving a sleeping body a velocity wakes it") {
+            step(physics, manager, sleep_ticks + 2);
+            REQUIRE(physics.is_sleeping(stack.back()));
+
+            auto view{
+                manager.get_view<nj3DRigidBodyComponent>(stack.back())
+            };
+            std::get<nj3DRigidBodyComponent*>(view.second)->velocity = {
+                0.f,
+                5.f,
+                0.f
+            };
+            step(physics, manager, 2);
+            REQUIRE_FALSE(physics.is_sleeping(stack.back()));
+            REQUIRE(get_position(manager, stack.back()).y > 2.5f);
+        }
+
+        SECTION("bodies that keep moving stay awake") {
+            add_box(manager,
+                    { 20.f, 0.5f, 0.f },
+                    1.f,
+                    RigidBodyType::Dynamic,
+                    { 1.f, 0.f, 0.f });
+            step(physics, manager, sleep_ticks * 2);
+            REQUIRE(physics.get_awake_count() == 1);
+            REQUIRE(physics.get_sleeping_count() == 3);
+        }
+
+        SECTION("bodies without a mass move as if they had unit mass") {
+            const EntityId massless{
+                add_body(manager,
+                         { 20.f, 5.f, 0.f },
+                         { .force = { 1.f, 0.f, 0.f },
+                           .collider = { .x_width = 1.f,
+                                         .y_width = 1.f,
+                                         .z_width = 1.f },
+                           .type = RigidBodyType::Dynamic })
+            };
+            step(physics, manager, 10);
+            const math::njVec3f position{ get_position(manager, massless) };
+            REQUIRE(std::isfinite(position.x));
+            REQUIRE(position.x > 20.f);
+            REQUIRE(get_velocity(manager, massless).x > 0.f);
+        }
+    }
+
+    TEST_CASE("nj3DPhysicsSystem continuous collision",
+              "[ecs][nj3DPhysicsSystem]") {
+        njEntityManager manager{};
+        nj3DPhysicsSystem physics{};
+
+        SECTION("a fast body that is not a bullet tunnels") {
+            add_wall(manager, 5.f);
+            const EntityId body{ add_projectile(manager, false) };
+            step(physics, manager, 3);
+            REQUIRE(get_position(manager, body).x > 5.f);
+        }
+
+        SECTION("a bullet stops at a thin wall") {
+            add_wall(manager, 5.f);
+            const EntityId bullet{ add_projectile(manager, true) };
+            step(physics, manager, 5);
+            const math::njVec3f position{ get_position(manager, bullet) };
+            REQUIRE(position.x < 5.f);
+            REQUIRE(position.x > 4.5f);
+            REQUIRE(get_velocity(manager, bullet).x == 0.f);
+        }
+
+        SECTION("a bouncy bullet bounces off a thin wall") {
+            add_wall(manager, 5.f);
+            const EntityId bullet{ add_projectile(manager, true, 1.f) };
+            step(physics, manager, 3);
+            REQUIRE(get_position(manager, bullet).x < 5.f);
+            REQUIRE(get_velocity(manager, bullet).x == -600.f);
+        }
+
+        SECTION("a bullet stays put once its substeps run out") {
+            add_wall(manager, 5.f);
+            const EntityId bullet{ add_projectile(manager, true, 1.f) };
+            physics.set_max_ccd_substeps(1);
+            step(physics, manager, 2);
+            const math::njVec3f position{ get_position(manager, bullet) };
+            REQUIRE(position.x < 5.f);
+            REQUIRE(position.x > 4.5f);
+            REQUIRE(get_velocity(manager, bullet).x == -600.f);
+        }
+
+        SECTION("a bullet bouncing between walls never leaves them") {
+            // the bullet runs out of substeps every tick
+            add_wall(manager, -1.f);
+            add_wall(manager, 1.f);
+            const EntityId bullet{ add_projectile(manager, true, 1.f) };
+            physics.set_max_ccd_substeps(2);
+            bool is_correct{ true };
+            for (int i{ 0 }; i < 20; ++i) {
+                physics.step(manager);
+                const math::njVec3f position{ get_position(manager, bullet) };
+                is_correct = is_correct && position.x > -1.f &&
+                             position.x < 1.f;
+            }
+            REQUIRE(is_correct);
+
+            // with the rest of its motion dropped, not its speed
+            REQUIRE(std::abs(get_velocity(manager, bullet).x) == 600.f);
+        }
+    }
+}  // namespace njin::ecs
@@ -1,5 +1,8 @@
 #include "ecs/njEntityManager.h"
 
+#include <algorithm>
+#include <string_view>
+
 #include <ecs/Components.h>
 
 #include "catch2/catch_test_macros.hpp"
@@ -195,5 +198,339 @@ namespace njin::ecs {
             };
             REQUIRE(include_exclude.size() == 0);
         }
+
+        SECTION("queries across many signature buckets") {
+            struct Tag {};
+
+            // 0: transform, 1: transform + input, 2: input + tag,
+            // 3: transform + input + tag
+            for (EntityId i{ 0 }; i < 4; ++i) {
+                manager.add_entity("");
+            }
+            manager.add_component(0, transform_0);
+            manager.add_component(1, transform_0);
+            manager.add_component(1, input_0);
+            manager.add_component(2, input_0);
+            manager.add_component(2, Tag{});
+            manager.add_component(3, transform_0);
+            manager.add_component(3, input_0);
+            manager.add_component(3, Tag{});
+
+            auto entities_of{ [](const auto& views) {
+                std::set<EntityId> entities{};
+                for (const auto& [entity, view] : views) {
+                    entities.insert(entity);
+                }
+                return entities;
+            } };
+            REQUIRE(entities_of(manager.get_views<Transform>()) ==
+                    std::set<EntityId>{ 0, 1, 3 });
+            REQUIRE(entities_of(manager.get_views<Transform, Input>()) ==
+                    std::set<EntityId>{ 1, 3 });
+            REQUIRE(entities_of(manager.get_views<Input, Tag>()) ==
+                    std::set<EntityId>{ 2, 3 });
+            REQUIRE(
+            entities_of(manager.get_views<Include<Input>, Exclude<Tag>>()) ==
+            std::set<EntityId>{ 1 });
+
+            // emptied buckets are dropped from the index
+            manager.remove_components<Tag>(2);
+            manager.remove_entity(3);
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(manager.get_views<Tag>().empty());
+            REQUIRE(entities_of(manager.get_views<Input>()) ==
+                    std::set<EntityId>{ 1, 2 });
+
+            // and made again when needed
+            manager.add_component(2, Tag{});
+            REQUIRE(entities_of(manager.get_views<Input, Tag>()) ==
+                    std::set<EntityId>{ 2 });
+        }
+
+        SECTION("split components") {
+            manager.add_entity("body");
+            nj3DPhysicsComponent physics{ .velocity = { 1, 2, 3 },
+                                          .mass = 2,
+                                          .collider = { .x_width = 4 },
+                                          .type = RigidBodyType::Dynamic,
+                                          .friction = 0.25f };
+            manager.add_component(0, physics);
+
+            // the parts are stored and queried separately
+            auto bodies{ manager.get_views<nj3DRigidBodyComponent>() };
+            REQUIRE(bodies.size() == 1);
+            auto body{ std::get<nj3DRigidBodyComponent*>(bodies[0].second) };
+            REQUIRE(body->velocity == math::njVec3f{ 1, 2, 3 });
+            REQUIRE(body->mass == 2);
+            REQUIRE(body->type == RigidBodyType::Dynamic);
+
+            auto colliders{ manager.get_views<nj3DColliderComponent>() };
+            REQUIRE(colliders.size() == 1);
+            auto collider{
+                std::get<nj3DColliderComponent*>(colliders[0].second)
+            };
+            REQUIRE(collider->collider.x_width == 4);
+
+            // the material stays out of the part integration reads
+            REQUIRE(collider->friction == 0.25f);
+            REQUIRE(sizeof(nj3DRigidBodyComponent) <= 32);
+
+            // the logical component is there while both parts are
+            REQUIRE(manager.has_components<nj3DPhysicsComponent>(0));
+            manager.remove_components<nj3DColliderComponent>(0);
+            REQUIRE_FALSE(manager.has_components<nj3DPhysicsComponent>(0));
+            manager.add_component(0, physics);
+
+            // removing the logical component removes both parts
+            manager.remove_components<nj3DPhysicsComponent>(0);
+            REQUIRE(manager.get_views<nj3DRigidBodyComponent>().empty());
+            REQUIRE(manager.get_views<nj3DColliderComponent>().empty());
+            REQUIRE_FALSE(manager.has_components<nj3DPhysicsComponent>(0));
+        }
+
+        SECTION("enabling and disabling entities") {
+            manager.add_entity("zero");
+            manager.add_entity("one");
+            manager.add_component(0, transform_0);
+            manager.add_component(1, transform_1);
+            manager.add_component(1, input_1);
+            REQUIRE(manager.is_enabled(1));
+
+            manager.set_enabled(1, false);
+            REQUIRE_FALSE(manager.is_enabled(1));
+            auto transforms{ manager.get_views<Transform>() };
+            REQUIRE(transforms.size() == 1);
+            REQUIRE(transforms[0].first == 0);
+            REQUIRE(manager.get_views<Include<Input>>().empty());
+
+            // components and signature are untouched
+            REQUIRE(manager.has_components<Transform, Input>(1));
+            REQUIRE(*std::get<Transform*>(manager.get_view<Transform>(1)
+                                          .second) == transform_1);
+
+            manager.set_enabled(1, true);
+            REQUIRE(manager.get_views<Transform>().size() == 2);
+        }
+
+        SECTION("stats") {
+            manager.add_entity("zero");
+            manager.add_component(0, transform_0);
+            manager.add_component(0, input_0);
+            manager.add_entity("one");
+            manager.add_component(1, transform_1);
+
+            njEntityManagerStats stats{ manager.get_stats() };
+            REQUIRE(stats.entity_count == 2);
+            REQUIRE(stats.components.size() == 2);
+            for (const njComponentStats& component : stats.components) {
+                REQUIRE(component.bytes_used ==
+                        component.count * component.component_size);
+                REQUIRE(component.bytes_reserved >= component.bytes_used);
+            }
+
+            auto transform_stats{ std::ranges::find_if(
+            stats.components,
+            [](const njComponentStats& component) {
+                return component.component_size == sizeof(Transform);
+            }) };
+            REQUIRE(transform_stats != stats.components.end());
+            REQUIRE(transform_stats->count == 2);
+            // readable, not mangled
+            REQUIRE(transform_stats->name.ends_with("::Transform"));
+
+            // every bookkeeping structure is accounted for
+            for (std::string_view name : { "bit_to_signatures", "enabled" }) {
+                auto map_stats{ std::ranges::find(stats.maps,
+                                                  name,
+                                                  &njMapStats::name) };
+                REQUIRE(map_stats != stats.maps.end());
+                REQUIRE(map_stats->bytes_reserved > 0);
+            }
+
+            // {transform} and {transform, input} buckets
+            size_t bucketed{ 0 };
+            for (const njSignatureStats& signature : stats.signatures) {
+                bucketed += signature.entity_count;
+                if (signature.components.size() == 2) {
+                    REQUIRE(signature.entity_count == 1);
+                }
+            }
+            REQUIRE(bucketed == 2);
+
+            // removed entities no longer count towards their components
+            manager.remove_entity(1);
+            stats = manager.get_stats();
+            transform_stats = std::ranges::find_if(
+            stats.components,
+            [](const njComponentStats& component) {
+                return component.component_size == sizeof(Transform);
+            });
+            REQUIRE(transform_stats->count == 1);
+
+            std::string json{ stats.to_json() };
+            REQUIRE(json.find("\"entity_count\"") != std::string::npos);
+            REQUIRE(json.find("\"signatures\"") != std::string::npos);
+        }
+
+        SECTION("compaction") {
+            for (EntityId i{ 0 }; i < 8; ++i) {
+                manager.add_entity("");
+                Transform transform{ static_cast<float>(i), 0, 0 };
+                manager.add_component(i, transform);
+            }
+            for (EntityId i{ 0 }; i < 8; i += 2) {
+                manager.remove_entity(i);
+            }
+
+            auto transform_stats{ [&manager]() {
+                njEntityManagerStats stats{ manager.get_stats() };
+                return stats.components.at(0);
+            } };
+            REQUIRE(transform_stats().count == 4);
+            REQUIRE(transform_stats().fragmentation > 0.f);
+
+            // a pass with a generous budget finishes in one call
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(transform_stats().fragmentation == 0.f);
+            REQUIRE(transform_stats().load_factor == 1.f);
+
+            // components survive the move
+            auto transforms{ manager.get_views<Transform>() };
+            REQUIRE(transforms.size() == 4);
+            for (const auto& [entity, view] : transforms) {
+                REQUIRE(std::get<Transform*>(view)->x ==
+                        static_cast<float>(entity));
+            }
+
+            // storage ordered by a locality key, descending x
+            manager.set_compaction_key<Transform>([](const Transform& t) {
+                return static_cast<uint64_t>(100 - t.x);
+            });
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(std::get<Transform*>(manager.get_view<Transform>(7)
+                                         .second) <
+                    std::get<Transform*>(manager.get_view<Transform>(1)
+                                         .second));
+        }
+
+        SECTION("compaction key set before any component exists") {
+            manager.set_compaction_key<Transform>([](const Transform& t) {
+                return static_cast<uint64_t>(100 - t.x);
+            });
+            for (EntityId i{ 0 }; i < 4; ++i) {
+                manager.add_entity("");
+                Transform transform{ static_cast<float>(i), 0, 0 };
+                manager.add_component(i, transform);
+            }
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(std::get<Transform*>(manager.get_view<Transform>(3)
+                                         .second) <
+                    std::get<Transform*>(manager.get_view<Transform>(0)
+                                         .second));
+        }
+
+        SECTION("budgeted compaction") {
+            constexpr EntityId COUNT{ 4000 };
+            for (EntityId i{ 0 }; i < COUNT; ++i) {
+                manager.add_entity("");
+                Transform transform{ static_cast<float>(i), 0, 0 };
+                manager.add_component(i, transform);
+            }
+
+            // storage is paged, so inserting does not move components
+            const Transform* first{
+                std::get<Transform*>(manager.get_view<Transform>(0).second)
+            };
+            manager.add_entity("");
+            manager.add_component(COUNT, transform_0);
+            REQUIRE(std::get<Transform*>(manager.get_view<Transform>(0)
+                                         .second) == first);
+            manager.remove_entity(COUNT);
+
+            // appending in order leaves nothing to do but the hole at the end
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(manager.compact(std::chrono::microseconds{ 0 }));
+
+            for (EntityId i{ 0 }; i < COUNT; i += 2) {
+                manager.remove_entity(i);
+            }
+
+            // a pass is resumed across calls when the budget runs out
+            int calls{ 1 };
+            while (!manager.compact(std::chrono::microseconds{ 0 })) {
+                ++calls;
+            }
+            REQUIRE(calls > 1);
+
+            njEntityManagerStats stats{ manager.get_stats() };
+            REQUIRE(stats.components.at(0).fragmentation == 0.f);
+            auto transforms{ manager.get_views<Transform>() };
+            REQUIRE(transforms.size() == COUNT / 2);
+            bool is_correct{ true };
+            for (const auto& [entity, view] : transforms) {
+                is_correct = is_correct && std::get<Transform*>(view)->x ==
+                                           static_cast<float>(entity);
+            }
+            REQUIRE(is_correct);
+        }
+
+        SECTION("shared components") {
+            for (EntityId i{ 0 }; i < 4; ++i) {
+                manager.add_entity("");
+            }
+            manager.add_shared_component(0, transform_0);
+            manager.add_shared_component(1, transform_0);
+            manager.add_shared_component(2, transform_0);
+            manager.add_shared_component(3, transform_1);
+
+            // equal values are stored once
+            auto groups{ manager.get_shared_groups<Transform>() };
+            REQUIRE(groups.size() == 2);
+            REQUIRE(*groups[0].value == transform_0);
+            REQUIRE(*groups[0].entities == std::set<EntityId>{ 0, 1, 2 });
+            REQUIRE(manager.get_shared_component<Transform>(0) ==
+                    manager.get_shared_component<Transform>(1));
+
+            // shared components are separate from regular components
+            REQUIRE(manager.has_components<njShared<Transform>>(0));
+            REQUIRE_FALSE(manager.has_components<Transform>(0));
+            manager.add_component(3, input_0);
+            REQUIRE(manager.get_views<Input>().size() == 1);
+            auto views{ manager.get_views<Include<Input>,
+                                          Exclude<njShared<Transform>>>() };
+            REQUIRE(views.empty());
+
+            // copy on write
+            Transform* transform{
+                manager.get_shared_component_mutable<Transform>(1)
+            };
+            transform->x = 10;
+            REQUIRE(manager.get_shared_component<Transform>(0)->x == 1);
+            REQUIRE(manager.get_shared_component<Transform>(1)->x == 10);
+            REQUIRE(manager.get_shared_groups<Transform>().size() == 3);
+
+            // the sole owner of a value modifies it in place
+            REQUIRE(manager.get_shared_component_mutable<Transform>(1) ==
+                    transform);
+
+            // a value changed back joins the group it is equal to again
+            transform->x = 1;
+            REQUIRE(manager.compact(std::chrono::microseconds{ 1000000 }));
+            REQUIRE(manager.get_shared_groups<Transform>().size() == 2);
+            REQUIRE(manager.get_shared_component<Transform>(1) ==
+                    manager.get_shared_component<Transform>(0));
+
+            // no entity ever had a shared mesh
+            REQUIRE(manager.get_shared_component<njMeshComponent>(0) ==
+                    nullptr);
+
+            // empty groups go away
+            manager.remove_shared_component<Transform>(3);
+            manager.remove_entity(1);
+            groups = manager.get_shared_groups<Transform>();
+            REQUIRE(groups.size() == 1);
+            REQUIRE(*groups[0].entities == std::set<EntityId>{ 0, 2 });
+            REQUIRE_FALSE(manager.has_components<njShared<Transform>>(3));
+        }
     }
 }  // namespace njin::ecs
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "ecs/njScheduler.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "ecs/njEngine.h"
+
+namespace njin::ecs {
+    namespace {
+        njTask<int> add_after_tick(int a, int b) {
+            co_await next_tick();
+            co_return a + b;
+        }
+
+        njTask<> count_ticks(int& ticks, int until) {
+            while (ticks < until) {
+                co_await next_tick();
+                ++ticks;
+            }
+        }
+
+        njTask<> sum_into(int& result) {
+            const int first{ co_await add_after_tick(1, 2) };
+            const int second{ co_await add_after_tick(first, 3) };
+            result = second;
+        }
+
+        njTask<> fail_after_tick() {
+            co_await next_tick();
+            throw std::runtime_error("failed");
+        }
+
+        /**
+         * Loads a file across updates and records its contents
+         */
+        class LoaderSystem final : public njSystem {
+            public:
+            explicit LoaderSystem(std::filesystem::path path) :
+                njSystem{ TickGroup::Zero },
+                path_{ std::move(path) } {}
+
+            void update(const njEntityManager&) override {
+                if (!started_) {
+                    started_ = true;
+                    spawn(load());
+                }
+            }
+
+            std::string contents{};
+
+            private:
+            std::filesystem::path path_{};
+            bool started_{ false };
+
+            njTask<> load() {
+                contents = co_await read_file_async(path_);
+            }
+        };
+    }  // namespace
+
+    TEST_CASE("njScheduler", "[ecs][njScheduler]") {
+        njScheduler scheduler{};
+
+        SECTION("tasks advance once per resume") {
+            int ticks{ 0 };
+            scheduler.spawn(count_ticks(ticks, 3));
+            REQUIRE(scheduler.get_task_count() == 1);
+
+            // the first resume starts the task, which then waits a tick
+            scheduler.resume();
+            REQUIRE(ticks == 0);
+            scheduler.resume();
+            REQUIRE(ticks == 1);
+            scheduler.resume();
+            scheduler.resume();
+            REQUIRE(ticks == 3);
+            REQUIRE(scheduler.get_task_count() == 0);
+        }
+
+        SECTION("awaiting tasks") {
+            int result{ 0 };
+            scheduler.spawn(sum_into(result));
+            for (int i{ 0 }; i < 3; ++i) {
+                scheduler.resume();
+            }
+            REQUIRE(result == 6);
+            REQUIRE(scheduler.get_task_count() == 0);
+        }
+
+        SECTION("awaiting jobs") {
+            std::promise<int> job{};
+            int result{ 0 };
+            scheduler.spawn([](std::future<int> future, int& out) -> njTask<> {
+                out = co_await when_ready(std::move(future));
+            }(job.get_future(), result));
+
+            scheduler.resume();
+            scheduler.resume();
+            REQUIRE(scheduler.get_task_count() == 1);
+
+            job.set_value(42);
+            scheduler.resume();
+            REQUIRE(result == 42);
+            REQUIRE(scheduler.get_task_count() == 0);
+        }
+
+        SECTION("exceptions escape resume") {
+            scheduler.spawn(fail_after_tick());
+            scheduler.resume();
+            REQUIRE_THROWS_AS(scheduler.resume(), std::runtime_error);
+            REQUIRE(scheduler.get_task_count() == 0);
+        }
+    }
+
+    TEST_CASE("njEngine tasks", "[ecs][njScheduler]") {
+        const std::filesystem::path path{
+            std::filesystem::temp_directory_path() / "njScheduler_test.txt"
+        };
+        {
+            std::ofstream file{ path };
+            file << "contents";
+        }
+
+        njEngine engine{};
+        auto system{ std::make_unique<LoaderSystem>(path) };
+        LoaderSystem* loader{ system.get() };
+        engine.add_system(std::move(system));
+
+        // the system spawns the task in the first update, and the read
+        // completes some updates later
+        engine.update();
+        REQUIRE(engine.get_task_count() == 1);
+        while (engine.get_task_count() > 0) {
+            engine.update();
+        }
+        REQUIRE(loader->contents == "contents");
+
+        std::filesystem::remove(path);
+    }
+}  // namespace njin::ecs
\ No newline at end of file
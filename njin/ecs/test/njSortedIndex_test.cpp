@@ -0,0 +1,98 @@
+#include "ecs/njSortedIndex.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/Components.h"
+#include "ecs/njEntityManager.h"
+
+namespace njin::ecs {
+    namespace {
+        std::vector<EntityId> to_vector(std::span<const EntityId> entities) {
+            return { entities.begin(), entities.end() };
+        }
+    }  // namespace
+
+    TEST_CASE("njSortedIndex", "[ecs][njSortedIndex]") {
+        njSortedIndex index{};
+        index.insert(3, 20);
+        index.insert(1, 10);
+        index.insert(2, 20);
+        index.insert(0, 30);
+
+        SECTION("entities are sorted by key, then by entity") {
+            REQUIRE(to_vector(index.get_entities()) ==
+                    std::vector<EntityId>{ 1, 2, 3, 0 });
+
+            auto runs{ index.get_runs() };
+            REQUIRE(runs.size() == 3);
+            REQUIRE(runs[0].key == 10);
+            REQUIRE(to_vector(runs[1].entities) ==
+                    std::vector<EntityId>{ 2, 3 });
+            REQUIRE(runs[2].key == 30);
+        }
+
+        SECTION("updating keys") {
+            // to the front
+            index.update(0, 0);
+            REQUIRE(to_vector(index.get_entities()) ==
+                    std::vector<EntityId>{ 0, 1, 2, 3 });
+
+            // to the back
+            index.update(2, 40);
+            REQUIRE(to_vector(index.get_entities()) ==
+                    std::vector<EntityId>{ 0, 1, 3, 2 });
+
+            // into an existing run
+            index.update(1, 20);
+            auto runs{ index.get_runs() };
+            REQUIRE(runs.size() == 3);
+            REQUIRE(to_vector(runs[1].entities) ==
+                    std::vector<EntityId>{ 1, 3 });
+        }
+
+        SECTION("removing entities") {
+            index.remove(2);
+            index.remove(2);
+            REQUIRE(index.size() == 3);
+            REQUIRE_FALSE(index.contains(2));
+            REQUIRE(to_vector(index.get_entities()) ==
+                    std::vector<EntityId>{ 1, 3, 0 });
+        }
+    }
+
+    TEST_CASE("njEntityManager sorted runs", "[ecs][njSortedIndex]") {
+        njEntityManager manager{};
+        for (EntityId i{ 0 }; i < 4; ++i) {
+            manager.add_entity("");
+        }
+        manager.add_component(0, njMeshComponent{ "cube", "rocks" });
+        manager.set_sort_key<njMeshComponent>([](const njMeshComponent& mesh) {
+            return std::hash<std::string>{}(mesh.texture) % 2;
+        });
+        manager.add_component(1, njMeshComponent{ "cube", "rocks" });
+        manager.add_component(2, njMeshComponent{ "cube", "rocks" });
+
+        // everything has the same key
+        auto runs{ manager.get_sorted_runs<njMeshComponent>() };
+        REQUIRE(runs.size() == 1);
+        REQUIRE(to_vector(runs[0].entities) ==
+                std::vector<EntityId>{ 0, 1, 2 });
+
+        // a reported change moves the entity, an unreported one does not
+        const njMeshComponent rocks{ "cube", "rocks" };
+        std::string other{ "grass" };
+        while (std::hash<std::string>{}(other) % 2 ==
+               std::hash<std::string>{}(rocks.texture) % 2) {
+            other += "s";
+        }
+        auto view{ manager.get_view<njMeshComponent>(1) };
+        std::get<njMeshComponent*>(view.second)->texture = other;
+        REQUIRE(manager.get_sorted_runs<njMeshComponent>().size() == 1);
+        manager.mark_changed<njMeshComponent>(1);
+        runs = manager.get_sorted_runs<njMeshComponent>();
+        REQUIRE(runs.size() == 2);
+
+        manager.remove_entity(1);
+        REQUIRE(manager.get_sorted_runs<njMeshComponent>().size() == 1);
+    }
+}  // namespace njin::ecs
\ No newline at end of file
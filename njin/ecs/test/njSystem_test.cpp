@@ -0,0 +1,72 @@
+#include "ecs/njSystem.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/Components.h"
+#include "ecs/njEngine.h"
+
+namespace njin::ecs {
+    namespace {
+        /**
+         * Counts how many entities with an input component it has visited
+         */
+        class CountingSystem final : public njSystem {
+            public:
+            explicit CountingSystem(int& visited) :
+                njSystem{ TickGroup::Zero },
+                visited_{ &visited } {}
+
+            void update(const njEntityManager& entity_manager) override {
+                auto views{ entity_manager.get_views<njInputComponent>() };
+                for_each_sliced(views, [this](const auto&) { ++*visited_; });
+            }
+
+            private:
+            int* visited_;
+        };
+    }  // namespace
+
+    TEST_CASE("njSystem", "[ecs][njSystem]") {
+        njEngine engine{};
+        int visited{ 0 };
+        auto system{ std::make_unique<CountingSystem>(visited) };
+        CountingSystem* counting{ system.get() };
+        engine.add_system(std::move(system));
+
+        for (int i{ 0 }; i < 3; ++i) {
+            EntityId entity{ engine.add_entity("") };
+            engine.add_component(entity, njInputComponent{});
+        }
+
+        SECTION("not time-sliced") {
+            engine.update();
+            REQUIRE(visited == 3);
+            REQUIRE(counting->get_slice_count() == 1);
+        }
+
+        SECTION("time-sliced") {
+            // a zero budget processes exactly one entity per update
+            counting->set_time_budget(njSystem::Budget{ 0 });
+            REQUIRE(counting->is_time_sliced());
+
+            engine.update();
+            REQUIRE(visited == 1);
+            REQUIRE(counting->get_slice_count() == 0);
+
+            engine.update();
+            engine.update();
+            REQUIRE(visited == 3);
+            REQUIRE(counting->get_slice_count() == 3);
+
+            // the next pass starts from the beginning
+            engine.update();
+            REQUIRE(visited == 4);
+
+            std::vector<njSliceReport> reports{ engine.get_slice_reports() };
+            REQUIRE(reports.size() == 1);
+            REQUIRE(reports[0].system == counting);
+            REQUIRE(reports[0].time_sliced);
+            REQUIRE(reports[0].slices == 3);
+        }
+    }
+}  // namespace njin::ecs
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "ecs/njWorldHost.h"
+
+#include <atomic>
+#include <stdexcept>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/Components.h"
+
+namespace njin::ecs {
+    namespace {
+        /**
+         * Counts the number of updates in the world it belongs to
+         */
+        class TickCounterSystem final : public njSystem {
+            public:
+            TickCounterSystem() : njSystem{ TickGroup::Zero } {}
+
+            void update(const njEntityManager& entity_manager) override {
+                auto views{ entity_manager.get_views<njInputComponent>() };
+                for (const auto& [entity, view] : views) {
+                    std::get<njInputComponent*>(view)->w = true;
+                }
+                ++ticks;
+            }
+
+            int ticks{ 0 };
+        };
+
+        /**
+         * Sums indices on the thread pool of a host
+         */
+        class PoolSystem final : public njSystem {
+            public:
+            explicit PoolSystem(std::shared_ptr<physics::ThreadPool> pool) :
+                njSystem{ TickGroup::Zero },
+                pool_{ std::move(pool) } {}
+
+            void update(const njEntityManager&) override {
+                pool_->parallel_for(100, [this](uint32_t i) { sum += i; });
+            }
+
+            std::atomic<uint32_t> sum{ 0 };
+
+            private:
+            std::shared_ptr<physics::ThreadPool> pool_;
+        };
+
+        /**
+         * Throws on every update
+         */
+        class ThrowingSystem final : public njSystem {
+            public:
+            ThrowingSystem() : njSystem{ TickGroup::Zero } {}
+
+            void update(const njEntityManager&) override {
+                throw std::runtime_error("world failed");
+            }
+        };
+    }  // namespace
+
+    TEST_CASE("njWorldHost", "[ecs][njWorldHost]") {
+        njWorldHost host{ 2 };
+        std::vector<TickCounterSystem*> counters{};
+        for (int i{ 0 }; i < 5; ++i) {
+            auto world{ std::make_unique<njEngine>() };
+            auto system{ std::make_unique<TickCounterSystem>() };
+            counters.push_back(system.get());
+            world->add_system(std::move(system));
+            EntityId entity{ world->add_entity("") };
+            world->add_component(entity, njInputComponent{});
+            host.add_world(std::move(world));
+        }
+        REQUIRE(host.get_world_count() == 5);
+        REQUIRE(host.get_shard_count() == 2);
+
+        SECTION("every world updates once per host update") {
+            host.update();
+            host.update();
+            host.update();
+            for (const TickCounterSystem* counter : counters) {
+                REQUIRE(counter->ticks == 3);
+            }
+        }
+
+        SECTION("worlds are independent") {
+            host.update();
+            for (size_t i{ 0 }; i < host.get_world_count(); ++i) {
+                auto views{
+                    host.get_world(i).get_view<njInputComponent>()
+                };
+                REQUIRE(views.size() == 1);
+                REQUIRE(std::get<njInputComponent*>(views[0].second)->w);
+            }
+        }
+
+        SECTION("worlds share the thread pool of the host") {
+            njWorldHost pooled{ 4, 4 };
+            REQUIRE(pooled.get_thread_pool()->get_thread_count() == 4);
+
+            std::vector<PoolSystem*> systems{};
+            for (int i{ 0 }; i < 8; ++i) {
+                auto world{ std::make_unique<njEngine>() };
+                auto system{
+                    std::make_unique<PoolSystem>(pooled.get_thread_pool())
+                };
+                systems.push_back(system.get());
+                world->add_system(std::move(system));
+                pooled.add_world(std::move(world));
+            }
+            pooled.update();
+            pooled.update();
+            for (const PoolSystem* system : systems) {
+                REQUIRE(system->sum == 2 * 4950);
+            }
+        }
+
+        SECTION("exceptions from worlds are rethrown by the host") {
+            auto world{ std::make_unique<njEngine>() };
+            world->add_system(std::make_unique<ThrowingSystem>());
+            host.add_world(std::move(world));
+
+            REQUIRE_THROWS_AS(host.update(), std::runtime_error);
+            // the other worlds still updated, and the host keeps working
+            for (const TickCounterSystem* counter : counters) {
+                REQUIRE(counter->ticks == 1);
+            }
+            REQUIRE_THROWS_AS(host.update(), std::runtime_error);
+            for (const TickCounterSystem* counter : counters) {
+                REQUIRE(counter->ticks == 2);
+            }
+        }
+    }
+}  // namespace njin::ecs
\ No newline at end of file